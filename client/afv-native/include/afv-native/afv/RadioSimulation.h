@@ -34,7 +34,9 @@
 #ifndef AFV_NATIVE_RADIOSIMULATION_H
 #define AFV_NATIVE_RADIOSIMULATION_H
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 
 #include "afv-native/utility.h"
@@ -61,34 +63,77 @@ namespace afv_native {
         /** RadioState is the internal state object for each radio within a RadioSimulation.
          *
          * It tracks the current playback position of the mixing effects, the channel frequency and gain.
+         *
+         * The effect sources are allocated once when the radio is created and are only ever rewound or
+         * stopped by the audio thread, so the output path never has to allocate.  Fields that are set
+         * from other threads are atomic.
          */
         class RadioState {
         public:
-            unsigned int Frequency;
-            float Gain;
-            std::shared_ptr<audio::RecordedSampleSource> Click;
-            std::shared_ptr<audio::RecordedSampleSource> Crackle;
-            std::shared_ptr<audio::RecordedSampleSource> AcBus;
-            std::shared_ptr<audio::RecordedSampleSource> VhfWhiteNoise;
-            std::shared_ptr<audio::RecordedSampleSource> HfWhiteNoise;
-            std::shared_ptr<audio::SineToneSource> BlockTone;
+            RadioState();
+
+            std::atomic<unsigned int> Frequency;
+            std::atomic<float> Gain;
+            std::unique_ptr<audio::RecordedSampleSource> Click;
+            std::unique_ptr<audio::RecordedSampleSource> Crackle;
+            std::unique_ptr<audio::RecordedSampleSource> AcBus;
+            std::unique_ptr<audio::RecordedSampleSource> VhfWhiteNoise;
+            std::unique_ptr<audio::RecordedSampleSource> HfWhiteNoise;
+            audio::SineToneSource BlockTone;
+            bool BlockToneActive;
             audio::SimpleCompressorEffect simpleCompressorEffect;
             audio::VHFFilterSource vhfFilter;
-            int mLastRxCount;
-            bool mBypassEffects;
-            bool mHfSquelch;
+            std::atomic<int> mLastRxCount;
+            std::atomic<bool> mBypassEffects;
+            std::atomic<bool> mHfSquelch;
             bool mIsReceiving;
+
+            /** set by setFrequency() so the audio thread resets the effects on its next pass */
+            std::atomic<bool> mFxResetPending;
         };
 
         /** CallsignMeta is the per-packetstream metadata stored within the RadioSimulation object.
          *
-         * It's used to hold the RemoteVoiceSource object for that callsign+channel combination,
-         * and the list of transceivers that this packet stream relates to.
+         * It maps the callsign+channel combination onto the preallocated StreamSlot that holds its
+         * RemoteVoiceSource and transceiver list.
          */
         struct CallsignMeta {
+            size_t slot;
+        };
+
+        /** StreamSlot is a preallocated per-stream mixing slot.
+         *
+         * Slots are created when the RadioSimulation is constructed and are recycled as callsigns
+         * come and go, so neither the network thread nor the audio thread allocate a new decoder for
+         * each stream.
+         *
+         * The transceiver list is updated by the network thread on every voice packet, and read by
+         * the audio thread once per frame.  It is guarded by a sequence lock (transceiverSeq is odd
+         * while an update is in progress) so the reader never blocks.
+         */
+        struct TransceiverSet {
+            static constexpr size_t maxTransceivers = 8;
+
+            size_t count;
+            dto::RxTransceiver items[maxTransceivers];
+        };
+
+        struct StreamSlot {
             std::shared_ptr<RemoteVoiceSource> source;
-            std::vector<dto::RxTransceiver> transceivers;
-            CallsignMeta();
+            std::atomic<uint32_t> transceiverSeq;
+            TransceiverSet transceivers;
+
+            StreamSlot();
+        };
+
+        /** StreamRegistry is the list of slots the audio thread should mix.
+         *
+         * RadioSimulation keeps two of these and publishes a new one by swapping the active index,
+         * so the audio thread always sees a complete list without taking a lock.
+         */
+        struct StreamRegistry {
+            size_t count;
+            size_t slots[audio::maxIncomingStreams];
         };
 
         enum class RadioSimulationState
@@ -158,6 +203,20 @@ namespace afv_native {
              */
             std::atomic<uint32_t> *AudiableAudioStreams;
 
+            /** Duration of the most recent getAudioFrame() call, in microseconds. */
+            std::atomic<uint32_t> LastFrameDurationUs;
+
+            /** Longest getAudioFrame() call since the last reset(), in microseconds. */
+            std::atomic<uint32_t> PeakFrameDurationUs;
+
+            /** Exponentially weighted average of the getAudioFrame() duration, in microseconds. */
+            std::atomic<float> AverageFrameDurationUs;
+
+            /** getDecodeUnderruns returns the total number of frames that were padded with silence because
+             * the network thread hadn't decoded them in time.
+             */
+            uint32_t getDecodeUnderruns() const;
+
             int lastReceivedRadio() const;
             util::ChainedCallback<void(RadioSimulationState)>  RadioStateCallback;
 
@@ -173,18 +232,39 @@ namespace afv_native {
              */
             static const int maintenanceTimerIntervalMs = 30 * 1000; /* every 30s */
 
+            /** decodeTimerIntervalMs is the interval between decode passes on the network thread.
+             *
+             * Running at twice the frame rate keeps each stream's decoded queue topped up even when the
+             * timer fires late.
+             */
+            static const int decodeTimerIntervalMs = audio::frameLengthMs / 2;
+
             struct event_base *mEvBase;
             std::shared_ptr<EffectResources> mResources;
             cryptodto::UDPChannel *mChannel;
             std::string mCallsign;
 
+            /** mStreamMapLock serialises the writers of the stream registry (the network thread, the
+             * maintenance timer and reset()).  It is never taken by the audio thread.
+             */
             std::mutex mStreamMapLock;
             std::unordered_map<std::string, struct CallsignMeta> mIncomingStreams;
+            std::vector<size_t> mFreeSlots;
+
+            /** mStreamSlots is the fixed pool of maxIncomingStreams stream slots. */
+            StreamSlot *mStreamSlots;
+
+            /** mStreamRegistry is the double-buffered list of live slots.  mPublishedRegistry is the
+             * index the audio thread should read from, and mRegistryInUse is the index it is reading
+             * right now (or -1 when it is idle).
+             */
+            StreamRegistry mStreamRegistry[2];
+            std::atomic<unsigned int> mPublishedRegistry;
+            std::atomic<int> mRegistryInUse;
 
-            std::mutex mRadioStateLock;
             std::atomic<bool> mPtt;
             bool mLastFramePtt;
-            unsigned int mTxRadio;
+            std::atomic<unsigned int> mTxRadio;
             std::atomic<uint32_t> mTxSequence;
             std::vector<RadioState> mRadioState;
 
@@ -204,17 +284,25 @@ namespace afv_native {
 
             audio::SampleType *mFetchBuffer;
 
+            /** mSlotSamples holds one decoded frame per stream slot, and mSlotTransceivers the
+             * transceiver snapshot taken for it.  Both are only touched by the audio thread.
+             */
+            audio::SampleType *mSlotSamples;
+            bool *mSlotHasFrame;
+            TransceiverSet *mSlotTransceivers;
+
             std::shared_ptr<VoiceCompressionSink> mVoiceSink;
             std::shared_ptr<audio::SpeexPreprocessor> mVoiceFilter;
 
             event::EventCallbackTimer mMaintenanceTimer;
+            event::EventCallbackTimer mDecodeTimer;
             RollingAverage<double> mVuMeter;
 
             void resetRadioFx(unsigned int radio, bool except_click = false);
 
             void set_radio_effects(size_t rxIter);
 
-            bool mix_effect(std::shared_ptr<audio::ISampleSource> effect, float gain);
+            bool mix_effect(audio::ISampleSource &effect, float gain);
 
             void processCompressedFrame(std::vector<unsigned char> compressedData) override;
 
@@ -224,11 +312,27 @@ namespace afv_native {
                     const std::string &dtoName, const unsigned char *bufIn, size_t bufLen);
 
             void maintainIncomingStreams();
+
+            /** decodeIncomingStreams tops up the decoded frame queue of every stream.  This runs on the
+             * network thread so that the audio thread only has to mix PCM.  The timer is armed when the
+             * first stream is registered and stops once there are none left.
+             */
+            void decodeIncomingStreams();
+
+            /** acquireStreamSlot returns the slot for a callsign, allocating one from the free pool
+             * if required.  Must be called with mStreamMapLock held.
+             *
+             * @return the slot index, or maxIncomingStreams if the pool is exhausted.
+             */
+            size_t acquireStreamSlot(const std::string &callsign);
+
+            /** publishStreamRegistry rebuilds the registry from mIncomingStreams and hands it to the
+             * audio thread.  On return the audio thread is guaranteed not to reference any slot that
+             * is no longer in mIncomingStreams.  Must be called with mStreamMapLock held.
+             */
+            void publishStreamRegistry();
         private:
-            bool _process_radio(
-                    const std::map<void *, audio::SampleType[audio::frameSizeSamples]> &sampleCache,
-                    std::map<void *, audio::SampleType[audio::frameSizeSamples]> &eqSampleCache,
-                    size_t rxIter);
+            bool _process_radio(const StreamRegistry &registry, size_t rxIter);
 
             /** mix_buffers is a utility function that mixes two buffers of audio together.  The src_dst
              * buffer is assumed to be the final output buffer and is modified by the mixing in place.
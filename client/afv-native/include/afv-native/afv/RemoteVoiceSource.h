@@ -34,6 +34,7 @@
 #ifndef AFV_NATIVE_REMOTEVOICESOURCE_H
 #define AFV_NATIVE_REMOTEVOICESOURCE_H
 
+#include <atomic>
 #include <mutex>
 #include <speexdsp/include/speex/speex_jitter.h>
 #include <opus/include/opus.h>
@@ -41,6 +42,7 @@
 #include "afv-native/afv/dto/interfaces/IAudio.h"
 #include "afv-native/audio/audio_params.h"
 #include "afv-native/audio/ISampleSource.h"
+#include "afv-native/audio/PcmRingBuffer.h"
 #include "afv-native/audio/SourceStatus.h"
 #include "afv-native/util/monotime.h"
 
@@ -52,10 +54,17 @@ namespace afv_native {
          */
         const int frameTimeOut = 10;
 
+        /** decodeAheadFrames is the number of decoded frames the network thread tries to keep queued
+         * for each stream.  This is the slack that absorbs scheduling jitter between the decode pass and
+         * the audio callback, and adds frameLengthMs of latency per frame.
+         */
+        const size_t decodeAheadFrames = 2;
+
         /** RemoveVoiceSource takes a stream of IAudio DTOs and stores them in an appropriately tuned jitterbuffer.
          *
-         * These can then be demand polled by a consumer which will pull the packets from the jitterBuffer and run them
-         * through the decoder.
+         * The jitterbuffer is drained and run through the decoder by decodeFrames(), which is called from the
+         * network thread.  The decoded PCM is queued in a lock-free ring which the consumer polls via
+         * getAudioFrame(), so the audio thread never touches the jitterbuffer or the codec.
          *
          * @note this is analogous to the GeoVR CallsignSampleProvider, but without the effects pass which is handled
          * elsewhere.
@@ -66,29 +75,51 @@ namespace afv_native {
             OpusDecoder *mDecoder;
 
             std::mutex mJitterBufferMutex;
-            bool mIsActive;
             util::monotime_t mLastActive;
+
+            audio::PcmRingBuffer mPcmBuffer;
+
+            /** mDecoding is set while the network thread is producing frames for the current transmission. */
+            std::atomic<bool> mDecoding;
+            /** mPlaying is set while the audio thread is consuming frames for the current transmission. */
+            std::atomic<bool> mPlaying;
+            std::atomic<uint32_t> mUnderruns;
         protected:
             int mSilentFrames;
 
             int mCurrentFrame;
             bool mEnding;
             int mEndingSequence;
+
+            /** decodeFrame pulls one packet from the jitterbuffer and decodes it into bufferOut. */
+            audio::SourceStatus decodeFrame(audio::SampleType *bufferOut);
         public:
             RemoteVoiceSource();
             virtual ~RemoteVoiceSource();
             RemoteVoiceSource(const RemoteVoiceSource& copySrc) = delete;
 
             void appendAudioDTO(const dto::IAudio &audio);
+
+            /** decodeFrames tops up the decoded frame queue to targetFrames.  Called from the network thread. */
+            void decodeFrames(size_t targetFrames = decodeAheadFrames);
+
+            /** getAudioFrame returns the next decoded frame.  Safe to call from the realtime audio thread. */
             audio::SourceStatus getAudioFrame(audio::SampleType *bufferOut) override;
 
             util::monotime_t getLastActivityTime() const;
 
             /** flush resets the stream, preserving any jitter adjustments, but otherwise clearing the codec state and
              * jitter buffered packets.
+             *
+             * @note the decoded frame queue is also cleared, so the audio thread must not be polling this source.
              */
             void flush();
             bool isActive() const;
+
+            /** getUnderruns returns the number of frames the audio thread had to fill with silence because the
+             * decoder had not kept up.
+             */
+            uint32_t getUnderruns() const;
         };
     }
 }
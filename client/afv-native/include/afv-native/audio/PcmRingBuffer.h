@@ -0,0 +1,94 @@
+/* audio/PcmRingBuffer.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_PCMRINGBUFFER_H
+#define AFV_NATIVE_PCMRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+
+#include "afv-native/audio/audio_params.h"
+
+namespace afv_native {
+    namespace audio {
+        /** PcmRingBuffer is a fixed capacity, single-producer/single-consumer queue of decoded audio frames.
+         *
+         * All storage is allocated up front, and neither end ever blocks or allocates, so it is safe to
+         * read from the realtime audio thread while another thread fills it.
+         *
+         * Each frame may carry an end-of-stream marker, which lets the producer tell the consumer that a
+         * transmission has finished without any other shared state.
+         */
+        class PcmRingBuffer {
+        protected:
+            const size_t mCapacity;
+            SampleType *mFrames;
+            bool *mEndOfStream;
+            std::atomic<size_t> mReadIndex;
+            std::atomic<size_t> mWriteIndex;
+        public:
+            explicit PcmRingBuffer(size_t capacityFrames);
+            virtual ~PcmRingBuffer();
+            PcmRingBuffer(const PcmRingBuffer &copySrc) = delete;
+
+            /** writeFrame returns the buffer for the next frame to be produced, or nullptr if the ring is full.
+             *
+             * The frame only becomes visible to the consumer once commitFrame() is called.
+             */
+            SampleType *writeFrame();
+
+            /** commitFrame publishes the frame last returned by writeFrame().
+             *
+             * @param endOfStream true if this frame marks the end of the stream.  The samples of an end of
+             *     stream frame are not delivered to the consumer.
+             */
+            void commitFrame(bool endOfStream = false);
+
+            /** readFrame copies the oldest frame into bufferOut.
+             *
+             * @param bufferOut buffer to receive frameSizeSamples samples.
+             * @param endOfStream set to true if the frame read was an end of stream marker.
+             * @return false if no frame was available.
+             */
+            bool readFrame(SampleType *bufferOut, bool &endOfStream);
+
+            /** available returns the number of frames queued. */
+            size_t available() const;
+
+            /** clear drops all queued frames.  Must only be called while neither side is using the ring. */
+            void clear();
+        };
+    }
+}
+
+#endif //AFV_NATIVE_PCMRINGBUFFER_H
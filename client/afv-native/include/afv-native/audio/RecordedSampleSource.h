@@ -54,6 +54,16 @@ namespace afv_native {
 
             bool isPlaying() const;
 
+            /** restart rewinds the source to the beginning of the sample and resumes playback.
+             *
+             * This allows a source to be reused without reallocating it, which is required for
+             * sources that are owned by the realtime audio path.
+             */
+            void restart();
+
+            /** stop halts playback.  The next call to getAudioFrame() will return Closed. */
+            void stop();
+
         };
     }
 }
@@ -52,6 +52,9 @@ namespace afv_native {
         public:
             explicit SineToneSource(double freqHz, float gain=1.0);
             SourceStatus getAudioFrame(SampleType *bufferOut) override;
+
+            /** reset restarts the tone from phase zero. */
+            void reset();
         };
     }
 }
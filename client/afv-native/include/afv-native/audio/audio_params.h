@@ -53,6 +53,11 @@ namespace afv_native {
 
         const int compressedSourceCacheTimeoutMs = 1000 * 60; /* 1 minute */
 
+        /** maximum number of remote voice streams that can be tracked at once.  Slots for these are
+         * preallocated so that the output path never has to allocate.
+         */
+        const size_t maxIncomingStreams = 128;
+
         /* note:  changing this type will require changing some of the opus decoder usage. */
         typedef float SampleType;
 
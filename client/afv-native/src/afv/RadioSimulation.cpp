@@ -34,6 +34,8 @@
 
 #include <cmath>
 #include <atomic>
+#include <chrono>
+#include <thread>
 
 #include "afv-native/Log.h"
 #include "afv-native/afv/RadioSimulation.h"
@@ -53,11 +55,30 @@ const float fxHfWhiteNoiseGain = 0.16f;
 const double minDb = -40.0;
 const double maxDb = 0.0;
 
-CallsignMeta::CallsignMeta():
-    source(),
+RadioState::RadioState():
+    Frequency(0),
+    Gain(0.0f),
+    Click(),
+    Crackle(),
+    AcBus(),
+    VhfWhiteNoise(),
+    HfWhiteNoise(),
+    BlockTone(fxBlockToneFreq),
+    BlockToneActive(false),
+    mLastRxCount(0),
+    mBypassEffects(false),
+    mHfSquelch(false),
+    mIsReceiving(false),
+    mFxResetPending(false)
+{
+}
+
+StreamSlot::StreamSlot():
+    source(std::make_shared<RemoteVoiceSource>()),
+    transceiverSeq(0),
     transceivers()
 {
-    source = std::make_shared<RemoteVoiceSource>();
+    transceivers.count = 0;
 }
 
 RadioSimulation::RadioSimulation(
@@ -67,12 +88,19 @@ RadioSimulation::RadioSimulation(
         unsigned int radioCount):
     IncomingAudioStreams(0),
     AudiableAudioStreams(nullptr),
+    LastFrameDurationUs(0),
+    PeakFrameDurationUs(0),
+    AverageFrameDurationUs(0.0f),
     mEvBase(evBase),
     mResources(std::move(resources)),
     mChannel(),
     mStreamMapLock(),
     mIncomingStreams(),
-    mRadioStateLock(),
+    mFreeSlots(),
+    mStreamSlots(nullptr),
+    mStreamRegistry(),
+    mPublishedRegistry(0),
+    mRegistryInUse(-1),
     mPtt(false),
     mLastFramePtt(false),
     mTxRadio(0),
@@ -81,14 +109,44 @@ RadioSimulation::RadioSimulation(
     mChannelBuffer(nullptr),
     mMixingBuffer(nullptr),
     mFetchBuffer(nullptr),
+    mSlotSamples(nullptr),
+    mSlotHasFrame(nullptr),
+    mSlotTransceivers(nullptr),
     mVoiceSink(std::make_shared<VoiceCompressionSink>(*this)),
     mVoiceFilter(),
     mMaintenanceTimer(mEvBase, std::bind(&RadioSimulation::maintainIncomingStreams, this)),
+    mDecodeTimer(mEvBase, std::bind(&RadioSimulation::decodeIncomingStreams, this)),
     mVuMeter(300 / audio::frameLengthMs) // VU is a 300ms zero to peak response...
 {
     mChannelBuffer = new audio::SampleType[audio::frameSizeSamples];
     mMixingBuffer = new audio::SampleType[audio::frameSizeSamples];
     mFetchBuffer = new audio::SampleType[audio::frameSizeSamples];
+
+    mStreamSlots = new StreamSlot[audio::maxIncomingStreams];
+    mSlotSamples = new audio::SampleType[audio::maxIncomingStreams * audio::frameSizeSamples];
+    mSlotHasFrame = new bool[audio::maxIncomingStreams];
+    mSlotTransceivers = new TransceiverSet[audio::maxIncomingStreams];
+    mFreeSlots.reserve(audio::maxIncomingStreams);
+    // hand out the lowest slots first.
+    for (size_t i = audio::maxIncomingStreams; i > 0; i--) {
+        mFreeSlots.push_back(i - 1);
+    }
+    mStreamRegistry[0].count = 0;
+    mStreamRegistry[1].count = 0;
+
+    for (auto &radio: mRadioState) {
+        radio.Click = std::make_unique<audio::RecordedSampleSource>(mResources->mClick, false);
+        radio.Crackle = std::make_unique<audio::RecordedSampleSource>(mResources->mCrackle, true);
+        radio.AcBus = std::make_unique<audio::RecordedSampleSource>(mResources->mAcBus, true);
+        radio.VhfWhiteNoise = std::make_unique<audio::RecordedSampleSource>(mResources->mVhfWhiteNoise, true);
+        radio.HfWhiteNoise = std::make_unique<audio::RecordedSampleSource>(mResources->mHfWhiteNoise, true);
+        radio.Click->stop();
+        radio.Crackle->stop();
+        radio.AcBus->stop();
+        radio.VhfWhiteNoise->stop();
+        radio.HfWhiteNoise->stop();
+    }
+
     setUDPChannel(channel);
     mMaintenanceTimer.enable(maintenanceTimerIntervalMs);
     AudiableAudioStreams = new std::atomic<uint32_t>[radioCount];
@@ -146,18 +204,13 @@ void RadioSimulation::processCompressedFrame(std::vector<unsigned char> compress
 {
     if (mChannel != nullptr && mChannel->isOpen()) {
         dto::AudioTxOnTransceivers audioOutDto;
-        {
-            std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-
-            if (!mPtt.load()) {
-                audioOutDto.LastPacket = true;
-                mLastFramePtt = false;
-            } else {
-                mLastFramePtt = true;
-            }
-
-            audioOutDto.Transceivers.emplace_back(mTxRadio);
+        if (!mPtt.load()) {
+            audioOutDto.LastPacket = true;
+            mLastFramePtt = false;
+        } else {
+            mLastFramePtt = true;
         }
+        audioOutDto.Transceivers.emplace_back(mTxRadio.load());
         audioOutDto.SequenceCounter = std::atomic_fetch_add<uint32_t>(&mTxSequence, 1);
         audioOutDto.Callsign = mCallsign;
         audioOutDto.Audio = std::move(compressedData);
@@ -184,9 +237,7 @@ bool RadioSimulation::getTxActive(unsigned int radio) {
 bool
 RadioSimulation::getRxActive(unsigned int radio)
 {
-    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-
-    return (mRadioState[radio].mLastRxCount > 0);
+    return (mRadioState[radio].mLastRxCount.load() > 0);
 }
 
 inline bool
@@ -195,45 +246,53 @@ freqIsHF(unsigned int freq)
     return freq < 30000000;
 }
 
-bool RadioSimulation::_process_radio(
-        const std::map<void *, audio::SampleType[audio::frameSizeSamples]> &sampleCache,
-std::map<void *, audio::SampleType[audio::frameSizeSamples]> &eqSampleCache,
-size_t rxIter)
+bool RadioSimulation::_process_radio(const StreamRegistry &registry, size_t rxIter)
 {
+    RadioState &radio = mRadioState[rxIter];
     ::memset(mChannelBuffer, 0, audio::frameSizeBytes);
-    if (mPtt.load() && mTxRadio == rxIter) {
+    if (radio.mFxResetPending.exchange(false)) {
+        resetRadioFx(rxIter, true);
+    }
+    if (mPtt.load() && mTxRadio.load() == rxIter) {
         // don't analyze and mix-in the radios transmitting, but suppress the
         // effects.
         resetRadioFx(rxIter);
         AudiableAudioStreams[rxIter].store(0);
         return true;
     }
+    const unsigned int radioFrequency = radio.Frequency.load();
+    const float radioGain = radio.Gain.load();
+    const bool bypassEffects = radio.mBypassEffects.load();
+    const bool hfSquelch = radio.mHfSquelch.load();
+
     // now, find all streams that this applies to.
     float crackleGain = 0.0f;
     float hfGain = 0.0f;
     float vhfGain = 0.0f;
     float acBusGain = 0.0f;
     uint32_t concurrentStreams = 0;
-    for (auto &srcPair: mIncomingStreams) {
-        if (!srcPair.second.source || !srcPair.second.source->isActive() ||
-                (sampleCache.find(srcPair.second.source.get()) == sampleCache.end())) {
+    for (size_t i = 0; i < registry.count; i++) {
+        const size_t slot = registry.slots[i];
+        if (!mSlotHasFrame[slot]) {
             continue;
         }
         bool mUseStream = false;
         float voiceGain = 1.0f;
-        for (const afv::dto::RxTransceiver &tx: srcPair.second.transceivers) {
-            if (tx.Frequency == mRadioState[rxIter].Frequency) {
+        const TransceiverSet &transceivers = mSlotTransceivers[slot];
+        for (size_t txIter = 0; txIter < transceivers.count; txIter++) {
+            const afv::dto::RxTransceiver &tx = transceivers.items[txIter];
+            if (tx.Frequency == radioFrequency) {
                 mUseStream = true;
 
                 float crackleFactor = 0.0f;
-                if (!mRadioState[rxIter].mBypassEffects) {
+                if (!bypassEffects) {
                     crackleFactor = static_cast<float>((exp(tx.DistanceRatio) * pow(tx.DistanceRatio, -4.0) / 350.0) - 0.00776652);
                     crackleFactor = fmax(0.0f, crackleFactor);
                     crackleFactor = fmin(0.20f, crackleFactor);
 
                     if (freqIsHF(tx.Frequency))
                     {
-                        if (!mRadioState[rxIter].mHfSquelch)
+                        if (!hfSquelch)
                         {
                             hfGain = fxHfWhiteNoiseGain;
                         }
@@ -259,22 +318,18 @@ size_t rxIter)
         }
         if (mUseStream) {
             // then include this stream.
-            try {
-                mix_buffers(
-                            mChannelBuffer,
-                            sampleCache.at(srcPair.second.source.get()),
-                            voiceGain * mRadioState[rxIter].Gain);
-                concurrentStreams++;
-            } catch (const std::out_of_range &) {
-                LOG("RadioSimulation", "internal error:  Tried to mix uncached stream");
-            }
+            mix_buffers(
+                        mChannelBuffer,
+                        mSlotSamples + (slot * audio::frameSizeSamples),
+                        voiceGain * radioGain);
+            concurrentStreams++;
         }
     }
     AudiableAudioStreams[rxIter].store(concurrentStreams);
 
     if (concurrentStreams > 0) {
 
-        if (!mRadioState[rxIter].mBypassEffects) {
+        if (!bypassEffects) {
 
             // limiter effect
             for(unsigned int i = 0; i < audio::frameSizeSamples; i++)
@@ -285,49 +340,48 @@ size_t rxIter)
                     mChannelBuffer[i] = -1.0f;
             }
 
-            mRadioState[rxIter].vhfFilter.transformFrame(mChannelBuffer, mChannelBuffer);
-            mRadioState[rxIter].simpleCompressorEffect.transformFrame(mChannelBuffer, mChannelBuffer);
+            radio.vhfFilter.transformFrame(mChannelBuffer, mChannelBuffer);
+            radio.simpleCompressorEffect.transformFrame(mChannelBuffer, mChannelBuffer);
 
             set_radio_effects(rxIter);
-            if (!mix_effect(mRadioState[rxIter].Crackle, crackleGain * mRadioState[rxIter].Gain))
+            if (!mix_effect(*radio.Crackle, crackleGain * radioGain))
             {
-                mRadioState[rxIter].Crackle.reset();
+                radio.Crackle->stop();
             }
-            if (!mix_effect(mRadioState[rxIter].HfWhiteNoise, hfGain * mRadioState[rxIter].Gain))
+            if (!mix_effect(*radio.HfWhiteNoise, hfGain * radioGain))
             {
-                mRadioState[rxIter].HfWhiteNoise.reset();
+                radio.HfWhiteNoise->stop();
             }
-            if (!mix_effect(mRadioState[rxIter].VhfWhiteNoise, vhfGain * mRadioState[rxIter].Gain))
+            if (!mix_effect(*radio.VhfWhiteNoise, vhfGain * radioGain))
             {
-                mRadioState[rxIter].VhfWhiteNoise.reset();
+                radio.VhfWhiteNoise->stop();
             }
-            if (!mix_effect(mRadioState[rxIter].AcBus, acBusGain * mRadioState[rxIter].Gain))
+            if (!mix_effect(*radio.AcBus, acBusGain * radioGain))
             {
-                mRadioState[rxIter].AcBus.reset();
+                radio.AcBus->stop();
             }
         } // bypass effects
         if (concurrentStreams > 1) {
-            if (!mRadioState[rxIter].BlockTone) {
-                mRadioState[rxIter].BlockTone = std::make_shared<audio::SineToneSource>(fxBlockToneFreq);
+            if (!radio.BlockToneActive) {
+                radio.BlockTone.reset();
+                radio.BlockToneActive = true;
             }
-            if (!mix_effect(mRadioState[rxIter].BlockTone, fxBlockToneGain * mRadioState[rxIter].Gain)) {
-                mRadioState[rxIter].BlockTone.reset();
+            if (!mix_effect(radio.BlockTone, fxBlockToneGain * radioGain)) {
+                radio.BlockToneActive = false;
             }
         } else {
-            if (mRadioState[rxIter].BlockTone) {
-                mRadioState[rxIter].BlockTone.reset();
-            }
+            radio.BlockToneActive = false;
         }
     } else {
         resetRadioFx(rxIter, true);
-        if (mRadioState[rxIter].mLastRxCount > 0) {
-            mRadioState[rxIter].Click = std::make_shared<audio::RecordedSampleSource>(mResources->mClick, false);
+        if (radio.mLastRxCount.load() > 0) {
+            radio.Click->restart();
         }
     }
-    mRadioState[rxIter].mLastRxCount = concurrentStreams;
+    radio.mLastRxCount.store(concurrentStreams);
     // if we have a pending click, play it.
-    if (!mix_effect(mRadioState[rxIter].Click, fxClickGain * mRadioState[rxIter].Gain)) {
-        mRadioState[rxIter].Click.reset();
+    if (!mix_effect(*radio.Click, fxClickGain * radioGain)) {
+        radio.Click->stop();
     }
     // now, finally, mix the channel buffer into the mixing buffer.
     mix_buffers(mMixingBuffer, mChannelBuffer);
@@ -336,24 +390,40 @@ size_t rxIter)
 
 audio::SourceStatus RadioSimulation::getAudioFrame(audio::SampleType *bufferOut)
 {
-    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    std::lock_guard<std::mutex> streamGuard(mStreamMapLock);
+    const auto frameStart = std::chrono::steady_clock::now();
 
-    std::map<void *, audio::SampleType[audio::frameSizeSamples]> sampleCache;
-    std::map<void *, audio::SampleType[audio::frameSizeSamples]> eqSampleCache;
+    // pin the current registry.  If the writer published a new one between our load and our
+    // store, retry so we never read a buffer the writer may be refilling.
+    unsigned int registryIndex;
+    do {
+        registryIndex = mPublishedRegistry.load();
+        mRegistryInUse.store(static_cast<int>(registryIndex));
+    } while (mPublishedRegistry.load() != registryIndex);
+    const StreamRegistry &registry = mStreamRegistry[registryIndex];
 
     uint32_t allStreams = 0;
     // first, pull frames from all active audio sources.
-    for (auto &src: mIncomingStreams) {
-        if (src.second.source && src.second.source->isActive() &&
-                (sampleCache.find(src.second.source.get()) == sampleCache.end())) {
-            const auto rv = src.second.source->getAudioFrame(sampleCache[src.second.source.get()]);
-            if (rv != audio::SourceStatus::OK) {
-                sampleCache.erase(src.second.source.get());
-            } else {
-                allStreams++;
-            }
+    for (size_t i = 0; i < registry.count; i++) {
+        const size_t slot = registry.slots[i];
+        StreamSlot &thisSlot = mStreamSlots[slot];
+        mSlotHasFrame[slot] = false;
+        if (!thisSlot.source->isActive()) {
+            continue;
         }
+        const auto rv = thisSlot.source->getAudioFrame(mSlotSamples + (slot * audio::frameSizeSamples));
+        if (rv != audio::SourceStatus::OK) {
+            continue;
+        }
+        // take a consistent copy of the transceivers.
+        uint32_t seqBefore, seqAfter;
+        do {
+            seqBefore = thisSlot.transceiverSeq.load(std::memory_order_acquire);
+            mSlotTransceivers[slot] = thisSlot.transceivers;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            seqAfter = thisSlot.transceiverSeq.load(std::memory_order_relaxed);
+        } while ((seqBefore & 1) || seqBefore != seqAfter);
+        mSlotHasFrame[slot] = true;
+        allStreams++;
     }
     IncomingAudioStreams.store(allStreams);
 
@@ -362,35 +432,45 @@ audio::SourceStatus RadioSimulation::getAudioFrame(audio::SampleType *bufferOut)
 
     size_t rxIter = 0;
     for (rxIter = 0; rxIter < mRadioState.size(); rxIter++) {
-        _process_radio(sampleCache, eqSampleCache, rxIter);
+        _process_radio(registry, rxIter);
     } // rxIter
+    mRegistryInUse.store(-1);
     ::memcpy(bufferOut, mMixingBuffer, sizeof(audio::SampleType) * audio::frameSizeSamples);
+
+    const auto frameDuration = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - frameStart);
+    const auto frameDurationUs = static_cast<uint32_t>(frameDuration.count());
+    LastFrameDurationUs.store(frameDurationUs);
+    if (frameDurationUs > PeakFrameDurationUs.load()) {
+        PeakFrameDurationUs.store(frameDurationUs);
+    }
+    AverageFrameDurationUs.store(AverageFrameDurationUs.load() * 0.95f + frameDurationUs * 0.05f);
     return audio::SourceStatus::OK;
 }
 
 void RadioSimulation::set_radio_effects(size_t rxIter)
 {
-    if (!mRadioState[rxIter].VhfWhiteNoise)
+    if (!mRadioState[rxIter].VhfWhiteNoise->isPlaying())
     {
-        mRadioState[rxIter].VhfWhiteNoise = std::make_shared<audio::RecordedSampleSource>(mResources->mVhfWhiteNoise, true);
+        mRadioState[rxIter].VhfWhiteNoise->restart();
     }
-    if (!mRadioState[rxIter].HfWhiteNoise)
+    if (!mRadioState[rxIter].HfWhiteNoise->isPlaying())
     {
-        mRadioState[rxIter].HfWhiteNoise = std::make_shared<audio::RecordedSampleSource>(mResources->mHfWhiteNoise, true);
+        mRadioState[rxIter].HfWhiteNoise->restart();
     }
-    if (!mRadioState[rxIter].Crackle)
+    if (!mRadioState[rxIter].Crackle->isPlaying())
     {
-        mRadioState[rxIter].Crackle = std::make_shared<audio::RecordedSampleSource>(mResources->mCrackle, true);
+        mRadioState[rxIter].Crackle->restart();
     }
-    if (!mRadioState[rxIter].AcBus)
+    if (!mRadioState[rxIter].AcBus->isPlaying())
     {
-        mRadioState[rxIter].AcBus = std::make_shared<audio::RecordedSampleSource>(mResources->mAcBus, true);
+        mRadioState[rxIter].AcBus->restart();
     }
 }
 
-bool RadioSimulation::mix_effect(std::shared_ptr<ISampleSource> effect, float gain) {
-    if (effect && gain > 0.0f) {
-        auto rv = effect->getAudioFrame(mFetchBuffer);
+bool RadioSimulation::mix_effect(ISampleSource &effect, float gain) {
+    if (gain > 0.0f) {
+        auto rv = effect.getAudioFrame(mFetchBuffer);
         if (rv == audio::SourceStatus::OK) {
             RadioSimulation::mix_buffers(mChannelBuffer, mFetchBuffer, gain);
         } else {
@@ -402,6 +482,10 @@ bool RadioSimulation::mix_effect(std::shared_ptr<ISampleSource> effect, float ga
 
 RadioSimulation::~RadioSimulation()
 {
+    delete[] mSlotTransceivers;
+    delete[] mSlotHasFrame;
+    delete[] mSlotSamples;
+    delete[] mStreamSlots;
     delete[] mFetchBuffer;
     delete[] mMixingBuffer;
     delete[] mChannelBuffer;
@@ -412,36 +496,115 @@ void RadioSimulation::rxVoicePacket(const afv::dto::AudioRxOnTransceivers &pkt)
 {
     std::lock_guard<std::mutex> streamMapLock(mStreamMapLock);
     //FIXME:  Deal with the case of a single-callsign transmitting multiple different voicestreams simultaneously.
-    mIncomingStreams[pkt.Callsign].source->appendAudioDTO(pkt);
-    mIncomingStreams[pkt.Callsign].transceivers = pkt.Transceivers;
+    const size_t slot = acquireStreamSlot(pkt.Callsign);
+    if (slot >= audio::maxIncomingStreams) {
+        return;
+    }
+    StreamSlot &thisSlot = mStreamSlots[slot];
+
+    // sequence-locked update of the transceiver list.  The audio thread retries its copy if it
+    // overlaps with this.
+    const uint32_t seq = thisSlot.transceiverSeq.load(std::memory_order_relaxed);
+    thisSlot.transceiverSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    const size_t txCount = std::min(pkt.Transceivers.size(), TransceiverSet::maxTransceivers);
+    std::copy_n(pkt.Transceivers.begin(), txCount, thisSlot.transceivers.items);
+    thisSlot.transceivers.count = txCount;
+    thisSlot.transceiverSeq.store(seq + 2, std::memory_order_release);
+
+    thisSlot.source->appendAudioDTO(pkt);
+    // decode straight away so the first frame of a transmission isn't held up by the decode timer.
+    thisSlot.source->decodeFrames();
+}
+
+size_t RadioSimulation::acquireStreamSlot(const std::string &callsign)
+{
+    auto streamIter = mIncomingStreams.find(callsign);
+    if (streamIter != mIncomingStreams.end()) {
+        return streamIter->second.slot;
+    }
+    if (mFreeSlots.empty()) {
+        // reclaim the least recently heard stream that isn't currently playing.
+        auto oldest = mIncomingStreams.end();
+        for (auto iter = mIncomingStreams.begin(); iter != mIncomingStreams.end(); iter++) {
+            const auto &source = mStreamSlots[iter->second.slot].source;
+            if (source->isActive()) {
+                continue;
+            }
+            if (oldest == mIncomingStreams.end() ||
+                    source->getLastActivityTime() < mStreamSlots[oldest->second.slot].source->getLastActivityTime()) {
+                oldest = iter;
+            }
+        }
+        if (oldest == mIncomingStreams.end()) {
+            LOG("RadioSimulation", "no free stream slots - dropping audio from %s", callsign.c_str());
+            return audio::maxIncomingStreams;
+        }
+        const size_t reclaimed = oldest->second.slot;
+        mIncomingStreams.erase(oldest);
+        publishStreamRegistry();
+        mFreeSlots.push_back(reclaimed);
+    }
+    const size_t slot = mFreeSlots.back();
+    mFreeSlots.pop_back();
+    // the slot isn't visible to the audio thread, so it's safe to reset it here.
+    mStreamSlots[slot].source->flush();
+    mStreamSlots[slot].transceivers.count = 0;
+    mIncomingStreams[callsign].slot = slot;
+    publishStreamRegistry();
+    // the decode timer only runs while there are streams, so an idle client doesn't wake up.
+    if (!mDecodeTimer.pending()) {
+        mDecodeTimer.enable(decodeTimerIntervalMs);
+    }
+    return slot;
+}
+
+void RadioSimulation::publishStreamRegistry()
+{
+    const unsigned int current = mPublishedRegistry.load();
+    const unsigned int next = current ^ 1u;
+    // wait for the audio thread to let go of the buffer we are about to refill.  It only holds it
+    // for a single frame.
+    while (mRegistryInUse.load() == static_cast<int>(next)) {
+        std::this_thread::yield();
+    }
+    StreamRegistry &registry = mStreamRegistry[next];
+    registry.count = 0;
+    for (const auto &streamPair: mIncomingStreams) {
+        registry.slots[registry.count++] = streamPair.second.slot;
+    }
+    mPublishedRegistry.store(next);
+    // and wait until nobody is still looking at the old list, so removed slots can be reused.
+    while (mRegistryInUse.load() == static_cast<int>(current)) {
+        std::this_thread::yield();
+    }
 }
 
 void RadioSimulation::setFrequency(unsigned int radio, unsigned int frequency)
 {
-    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
     if (radio >= mRadioState.size()) {
         return;
     }
-    if (mRadioState[radio].Frequency == frequency) {
+    if (mRadioState[radio].Frequency.exchange(frequency) == frequency) {
         return;
     }
-    mRadioState[radio].Frequency = frequency;
-    // reset all of the effects, except the click which should be audiable due to the Squelch-gate kicking in on the new frequency
-    resetRadioFx(radio, true);
+    // reset all of the effects, except the click which should be audiable due to the Squelch-gate kicking in on the new frequency.
+    // The effects belong to the audio thread, so it performs the reset on its next pass.
+    mRadioState[radio].mFxResetPending.store(true);
     LOG("RadioSimulation", "setFrequency: %i: %i", radio, frequency);
 }
 
 void RadioSimulation::resetRadioFx(unsigned int radio, bool except_click)
 {
     if (!except_click) {
-        mRadioState[radio].Click.reset();
-        mRadioState[radio].mLastRxCount = 0;
+        mRadioState[radio].Click->stop();
+        mRadioState[radio].mLastRxCount.store(0);
     }
-    mRadioState[radio].BlockTone.reset();
-    mRadioState[radio].Crackle.reset();
-    mRadioState[radio].VhfWhiteNoise.reset();
-    mRadioState[radio].HfWhiteNoise.reset();
-    mRadioState[radio].AcBus.reset();
+    mRadioState[radio].BlockToneActive = false;
+    mRadioState[radio].Crackle->stop();
+    mRadioState[radio].VhfWhiteNoise->stop();
+    mRadioState[radio].HfWhiteNoise->stop();
+    mRadioState[radio].AcBus->stop();
 }
 
 void RadioSimulation::setPtt(bool pressed)
@@ -451,18 +614,16 @@ void RadioSimulation::setPtt(bool pressed)
 
 void RadioSimulation::setGain(unsigned int radio, float gain)
 {
-    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    mRadioState[radio].Gain = gain;
+    mRadioState[radio].Gain.store(gain);
     LOG("RadioSimulation", "setGain: %i: %f", radio, gain);
 }
 
 void RadioSimulation::setTxRadio(unsigned int radio)
 {
-    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
     if (radio >= mRadioState.size()) {
         return;
     }
-    mTxRadio = radio;
+    mTxRadio.store(radio);
     LOG("RadioSimulation", "setTxRadio: %i", radio);
 }
 
@@ -517,20 +678,47 @@ void RadioSimulation::setUDPChannel(cryptodto::UDPChannel *newChannel)
 void RadioSimulation::maintainIncomingStreams()
 {
     std::lock_guard<std::mutex> ml(mStreamMapLock);
-    std::vector<std::string> callsignsToPurge;
+    std::vector<size_t> slotsToPurge;
     util::monotime_t now = util::monotime_get();
-    for (const auto &streamPair: mIncomingStreams) {
-        auto idleTime = now - streamPair.second.source->getLastActivityTime();
-        if ((now - streamPair.second.source->getLastActivityTime()) > audio::compressedSourceCacheTimeoutMs) {
-            callsignsToPurge.emplace_back(streamPair.first);
+    for (auto iter = mIncomingStreams.begin(); iter != mIncomingStreams.end();) {
+        const auto &source = mStreamSlots[iter->second.slot].source;
+        if ((now - source->getLastActivityTime()) > audio::compressedSourceCacheTimeoutMs) {
+            slotsToPurge.emplace_back(iter->second.slot);
+            iter = mIncomingStreams.erase(iter);
+        } else {
+            iter++;
         }
     }
-    for (const auto &callsign: callsignsToPurge) {
-        mIncomingStreams.erase(callsign);
+    if (!slotsToPurge.empty()) {
+        publishStreamRegistry();
+        mFreeSlots.insert(mFreeSlots.end(), slotsToPurge.begin(), slotsToPurge.end());
     }
+    LOG("RadioSimulation", "audio frame time: avg %.0fus, peak %uus, decode underruns: %u",
+        AverageFrameDurationUs.load(), PeakFrameDurationUs.load(), getDecodeUnderruns());
     mMaintenanceTimer.enable(maintenanceTimerIntervalMs);
 }
 
+void RadioSimulation::decodeIncomingStreams()
+{
+    std::lock_guard<std::mutex> ml(mStreamMapLock);
+    for (const auto &streamPair: mIncomingStreams) {
+        mStreamSlots[streamPair.second.slot].source->decodeFrames();
+    }
+    // once the last stream has been purged, acquireStreamSlot arms the timer again.
+    if (!mIncomingStreams.empty()) {
+        mDecodeTimer.enable(decodeTimerIntervalMs);
+    }
+}
+
+uint32_t RadioSimulation::getDecodeUnderruns() const
+{
+    uint32_t underruns = 0;
+    for (size_t i = 0; i < audio::maxIncomingStreams; i++) {
+        underruns += mStreamSlots[i].source->getUnderruns();
+    }
+    return underruns;
+}
+
 void RadioSimulation::setCallsign(const std::string &newCallsign)
 {
     mCallsign = newCallsign;
@@ -540,9 +728,14 @@ void RadioSimulation::reset()
 {
     {
         std::lock_guard<std::mutex> ml(mStreamMapLock);
+        for (const auto &streamPair: mIncomingStreams) {
+            mFreeSlots.push_back(streamPair.second.slot);
+        }
         mIncomingStreams.clear();
+        publishStreamRegistry();
     }
     mTxSequence.store(0);
+    PeakFrameDurationUs.store(0);
     mPtt.store(false);
     mLastFramePtt = false;
     // reset the voice compression codec state.
@@ -577,16 +770,14 @@ void RadioSimulation::setEnableInputFilters(bool enableInputFilters)
 
 void RadioSimulation::setEnableOutputEffects(bool enableEffects)
 {
-    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
     for (auto &thisRadio: mRadioState) {
-        thisRadio.mBypassEffects = !enableEffects;
+        thisRadio.mBypassEffects.store(!enableEffects);
     }
 }
 
 void RadioSimulation::setEnableHfSquelch(bool enableSquelch)
 {
-    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
     for (auto& thisRadio : mRadioState) {
-        thisRadio.mHfSquelch = enableSquelch;
+        thisRadio.mHfSquelch.store(enableSquelch);
     }
 }
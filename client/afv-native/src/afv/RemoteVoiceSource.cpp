@@ -47,7 +47,10 @@ using namespace std;
 
 RemoteVoiceSource::RemoteVoiceSource():
         mJitterBufferMutex(),
-        mIsActive(false),
+        mPcmBuffer(decodeAheadFrames * 4),
+        mDecoding(false),
+        mPlaying(false),
+        mUnderruns(0),
         mSilentFrames(0),
         mEnding(false),
         mEndingSequence(0),
@@ -101,10 +104,48 @@ void RemoteVoiceSource::appendAudioDTO(const dto::IAudio &audio)
         mSilentFrames = 0;
         mLastActive = util::monotime_get();
     }
-    mIsActive = true;
+    mDecoding.store(true);
+}
+
+void RemoteVoiceSource::decodeFrames(size_t targetFrames)
+{
+    while (mDecoding.load() && mPcmBuffer.available() < targetFrames) {
+        SampleType *frame = mPcmBuffer.writeFrame();
+        if (frame == nullptr) {
+            break;
+        }
+        if (decodeFrame(frame) != SourceStatus::OK) {
+            // tell the consumer the transmission is over.
+            mPcmBuffer.commitFrame(true);
+            mDecoding.store(false);
+            break;
+        }
+        mPcmBuffer.commitFrame();
+    }
 }
 
 SourceStatus RemoteVoiceSource::getAudioFrame(SampleType *bufferOut)
+{
+    bool endOfStream = false;
+    if (mPcmBuffer.readFrame(bufferOut, endOfStream)) {
+        if (endOfStream) {
+            mPlaying.store(false);
+            ::memset(bufferOut, 0, frameSizeBytes);
+            return SourceStatus::Closed;
+        }
+        mPlaying.store(true);
+        return SourceStatus::OK;
+    }
+    ::memset(bufferOut, 0, frameSizeBytes);
+    if (mPlaying.load()) {
+        // the decoder hasn't kept up.  Play silence rather than dropping the stream mid-transmission.
+        mUnderruns.fetch_add(1);
+        return SourceStatus::OK;
+    }
+    return SourceStatus::Closed;
+}
+
+SourceStatus RemoteVoiceSource::decodeFrame(SampleType *bufferOut)
 {
     SourceStatus rv = SourceStatus::OK;
     JitterBufferPacket pktOut;
@@ -172,9 +213,6 @@ SourceStatus RemoteVoiceSource::getAudioFrame(SampleType *bufferOut)
             }
         }
     }
-    if (rv != SourceStatus::OK) {
-        mIsActive = false;
-    }
     return rv;
 }
 
@@ -184,13 +222,25 @@ void RemoteVoiceSource::flush()
         std::lock_guard<std::mutex> lock(mJitterBufferMutex);
         // this nukes the jitter buffer contents, without resetting the latency timers.
         jitter_buffer_reset(mJitterBuffer);
+        mSilentFrames = 0;
     }
-    opus_decoder_ctl(mDecoder, OPUS_RESET_STATE);
+    if (mDecoder != nullptr) {
+        opus_decoder_ctl(mDecoder, OPUS_RESET_STATE);
+    }
+    mEnding = false;
+    mDecoding.store(false);
+    mPlaying.store(false);
+    mPcmBuffer.clear();
 }
 
 bool RemoteVoiceSource::isActive() const
 {
-    return mIsActive;
+    return mDecoding.load() || mPlaying.load() || mPcmBuffer.available() > 0;
+}
+
+uint32_t RemoteVoiceSource::getUnderruns() const
+{
+    return mUnderruns.load();
 }
 
 util::monotime_t RemoteVoiceSource::getLastActivityTime() const
@@ -0,0 +1,97 @@
+/* audio/PcmRingBuffer.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/audio/PcmRingBuffer.h"
+
+#include <cstring>
+
+using namespace afv_native::audio;
+
+PcmRingBuffer::PcmRingBuffer(size_t capacityFrames):
+    mCapacity(capacityFrames),
+    mFrames(nullptr),
+    mEndOfStream(nullptr),
+    mReadIndex(0),
+    mWriteIndex(0)
+{
+    mFrames = new SampleType[mCapacity * frameSizeSamples];
+    mEndOfStream = new bool[mCapacity];
+}
+
+PcmRingBuffer::~PcmRingBuffer()
+{
+    delete[] mEndOfStream;
+    delete[] mFrames;
+}
+
+SampleType *PcmRingBuffer::writeFrame()
+{
+    const size_t writeIndex = mWriteIndex.load(std::memory_order_relaxed);
+    if (writeIndex - mReadIndex.load(std::memory_order_acquire) >= mCapacity) {
+        return nullptr;
+    }
+    return mFrames + ((writeIndex % mCapacity) * frameSizeSamples);
+}
+
+void PcmRingBuffer::commitFrame(bool endOfStream)
+{
+    const size_t writeIndex = mWriteIndex.load(std::memory_order_relaxed);
+    mEndOfStream[writeIndex % mCapacity] = endOfStream;
+    mWriteIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+bool PcmRingBuffer::readFrame(SampleType *bufferOut, bool &endOfStream)
+{
+    const size_t readIndex = mReadIndex.load(std::memory_order_relaxed);
+    if (readIndex == mWriteIndex.load(std::memory_order_acquire)) {
+        return false;
+    }
+    const size_t frame = readIndex % mCapacity;
+    endOfStream = mEndOfStream[frame];
+    if (!endOfStream) {
+        ::memcpy(bufferOut, mFrames + (frame * frameSizeSamples), frameSizeBytes);
+    }
+    mReadIndex.store(readIndex + 1, std::memory_order_release);
+    return true;
+}
+
+size_t PcmRingBuffer::available() const
+{
+    return mWriteIndex.load(std::memory_order_acquire) - mReadIndex.load(std::memory_order_acquire);
+}
+
+void PcmRingBuffer::clear()
+{
+    mReadIndex.store(0);
+    mWriteIndex.store(0);
+}
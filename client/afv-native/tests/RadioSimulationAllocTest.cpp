@@ -0,0 +1,204 @@
+/* tests/RadioSimulationAllocTest.cpp
+ *
+ * Drives RadioSimulation::getAudioFrame with several live voice streams and fails if the
+ * output path allocates or frees memory.  Global operator new/delete are replaced with the
+ * counting versions from plugin/tests/AllocationCounter.h; only the getAudioFrame calls are
+ * counted, the packets are fed in from the same thread between frames as the network thread
+ * would.  A retune half way through exercises the effects reset, and a last pass runs the
+ * output path on another thread while mStreamMapLock is held, so it fails (rather than hangs)
+ * if getAudioFrame takes the lock.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <event2/event.h>
+#include <opus/include/opus.h>
+
+#include "afv-native/afv/EffectResources.h"
+#include "afv-native/afv/RadioSimulation.h"
+#include "afv-native/afv/dto/voice_server/AudioRxOnTransceivers.h"
+#include "afv-native/audio/audio_params.h"
+
+#include "AllocationCounter.h"
+
+using namespace afv_native;
+
+using xpilot::AllocationCounter;
+
+namespace {
+    const unsigned int radioFrequencies[] = { 124500000, 8891000 };
+    const unsigned int retuneFrequency = 124550000;
+    const size_t streamCount = 6;
+    const size_t frameCount = 500;
+    const size_t lockedFrameCount = 50;
+
+    /** exposes the state the test checks; the simulation itself is unchanged. */
+    class ProbedRadioSimulation: public afv::RadioSimulation {
+    public:
+        using afv::RadioSimulation::RadioSimulation;
+
+        std::mutex &streamMapLock()
+        {
+            return mStreamMapLock;
+        }
+
+        bool fxResetPending(unsigned int radio) const
+        {
+            return mRadioState[radio].mFxResetPending.load();
+        }
+    };
+
+    struct TestStream {
+        std::string callsign;
+        uint32_t frequency;
+        float frequencyHz;
+        OpusEncoder *encoder;
+        uint32_t sequence;
+    };
+}
+
+int main()
+{
+    struct event_base *evBase = event_base_new();
+    auto resources = std::make_shared<afv::EffectResources>();
+
+    int failures = 0;
+    {
+        ProbedRadioSimulation radio(evBase, resources, nullptr, 2);
+        radio.setFrequency(0, radioFrequencies[0]);
+        radio.setFrequency(1, radioFrequencies[1]);
+        radio.setGain(0, 1.0f);
+        radio.setGain(1, 1.0f);
+
+        // three streams on the VHF radio, so the block tone plays too, and one on the HF radio.
+        // The rest are tuned to neither and only take up a slot.
+        std::vector<TestStream> streams;
+        for (size_t i = 0; i < streamCount; i++) {
+            int error = 0;
+            TestStream stream;
+            stream.callsign = "TEST" + std::to_string(i);
+            stream.frequency = i < 3 ? radioFrequencies[0] : (i == 3 ? radioFrequencies[1] : 121500000);
+            stream.frequencyHz = 300.0f + 100.0f * i;
+            stream.encoder = opus_encoder_create(audio::sampleRateHz, 1, OPUS_APPLICATION_VOIP, &error);
+            stream.sequence = 0;
+            if (error != OPUS_OK) {
+                std::printf("opus_encoder_create failed: %d\n", error);
+                return 1;
+            }
+            opus_encoder_ctl(stream.encoder, OPUS_SET_BITRATE(audio::encoderBitrate));
+            streams.push_back(stream);
+        }
+
+        std::vector<audio::SampleType> pcm(audio::frameSizeSamples);
+        std::vector<unsigned char> encoded(audio::targetOutputFrameSizeBytes);
+        std::vector<audio::SampleType> output(audio::frameSizeSamples);
+        uint32_t maxAudible = 0;
+        size_t allocatingFrames = 0;
+        size_t fxResets = 0;
+
+        for (size_t frame = 0; frame < frameCount; frame++) {
+            for (auto &stream: streams) {
+                for (int i = 0; i < audio::frameSizeSamples; i++) {
+                    const double t = static_cast<double>(frame * audio::frameSizeSamples + i) / audio::sampleRateHz;
+                    pcm[i] = static_cast<audio::SampleType>(0.3 * std::sin(2.0 * M_PI * stream.frequencyHz * t));
+                }
+                const int len = opus_encode_float(stream.encoder, pcm.data(), audio::frameSizeSamples,
+                        encoded.data(), static_cast<opus_int32>(encoded.size()));
+                if (len < 0) {
+                    std::printf("opus_encode_float failed: %d\n", len);
+                    return 1;
+                }
+
+                afv::dto::AudioRxOnTransceivers pkt;
+                pkt.Callsign = stream.callsign;
+                pkt.SequenceCounter = stream.sequence++;
+                pkt.Audio.assign(encoded.begin(), encoded.begin() + len);
+                pkt.LastPacket = false;
+                afv::dto::RxTransceiver transceiver;
+                transceiver.ID = 0;
+                transceiver.Frequency = stream.frequency;
+                transceiver.DistanceRatio = 0.8f;
+                pkt.Transceivers.push_back(transceiver);
+                radio.rxVoicePacket(pkt);
+            }
+
+            // retuning away and back half way through makes the audio thread reset the radio
+            // effects twice.  The streams stay on the original frequency.
+            if (frame == frameCount / 2) {
+                radio.setFrequency(0, retuneFrequency);
+            } else if (frame == frameCount / 2 + 1) {
+                radio.setFrequency(0, radioFrequencies[0]);
+            }
+            const bool resetPending = radio.fxResetPending(0);
+
+            AllocationCounter::Start();
+            radio.getAudioFrame(output.data());
+            AllocationCounter::Stop();
+
+            // the initial tuning resets the effects on the first frame, that one doesn't count.
+            if (frame > 0 && resetPending && !radio.fxResetPending(0)) {
+                fxResets++;
+            }
+
+            if (AllocationCounter::Allocations.load() > 0 || AllocationCounter::Frees.load() > 0) {
+                if (allocatingFrames++ < 10) {
+                    std::printf("frame %zu: %zu allocations, %zu frees\n", frame, AllocationCounter::Allocations.load(), AllocationCounter::Frees.load());
+                }
+            }
+            maxAudible = std::max(maxAudible, radio.AudiableAudioStreams[0].load());
+        }
+
+        // the output path must not wait for the network thread.  Hold the stream map lock as
+        // rxVoicePacket would and give the audio thread a generous deadline.
+        bool lockFree = true;
+        {
+            std::unique_lock<std::mutex> held(radio.streamMapLock());
+            auto audio = std::async(std::launch::async, [&radio]() {
+                std::vector<audio::SampleType> buffer(audio::frameSizeSamples);
+                for (size_t frame = 0; frame < lockedFrameCount; frame++) {
+                    radio.getAudioFrame(buffer.data());
+                }
+            });
+            if (audio.wait_for(std::chrono::seconds(5)) != std::future_status::ready) {
+                lockFree = false;
+            }
+            held.unlock();
+            audio.get();
+        }
+
+        std::printf("%zu frames, %zu streams, up to %u audible on one radio, %zu frames allocated, "
+                "%zu effects resets, %s while the stream map was locked\n",
+                frameCount, streams.size(), maxAudible, allocatingFrames, fxResets,
+                lockFree ? "ran" : "blocked");
+        if (allocatingFrames > 0) {
+            failures++;
+        }
+        if (fxResets != 2) {
+            std::printf("the retune didn't reset the radio effects\n");
+            failures++;
+        }
+        if (!lockFree) {
+            std::printf("getAudioFrame waited for mStreamMapLock\n");
+            failures++;
+        }
+        // make sure the streams were actually mixed, not skipped.
+        if (maxAudible < 2) {
+            std::printf("the voice streams never reached the mixer\n");
+            failures++;
+        }
+
+        for (auto &stream: streams) {
+            opus_encoder_destroy(stream.encoder);
+        }
+    }
+
+    event_base_free(evBase);
+    return failures == 0 ? 0 : 1;
+}
@@ -112,7 +112,7 @@ namespace xpilot
     }
 
     void AircraftManager::OnFastPositionUpdateReceived(QString callsign, AircraftVisualState visualState,
-                                                       VelocityVector positionalVelocityVector, VelocityVector rotationalVelocityVector)
+                                                       VelocityVector positionalVelocityVector, VelocityVector rotationalVelocityVector, qint64 receivedAt)
     {
         auto aircraft = std::find_if(m_aircraft.begin(), m_aircraft.end(), [=](NetworkAircraft a){
             return a.Callsign == callsign && a.Status != AircraftStatus::Ignored;
@@ -122,7 +122,7 @@ namespace xpilot
         {
             aircraft->HaveVelocities = true;
             aircraft->LastUpdated = QDateTime::currentDateTimeUtc();
-            m_xplaneAdapter.SendFastPositionUpdate(*aircraft, visualState, positionalVelocityVector, rotationalVelocityVector);
+            m_xplaneAdapter.SendFastPositionUpdate(*aircraft, visualState, positionalVelocityVector, rotationalVelocityVector, receivedAt);
         }
     }
 
@@ -40,7 +40,7 @@ namespace xpilot
         void OnCapabilitiessResponseReceived(QString callsign, QString data);
         void OnCapabilitiesRequestReceived(QString callsign);
         void OnSlowPositionUpdateReceived(QString callsign, AircraftVisualState visualState, double groundSpeed);
-        void OnFastPositionUpdateReceived(QString callsign, AircraftVisualState visualState, VelocityVector positionalVelocityVector, VelocityVector rotationalVelocityVector);
+        void OnFastPositionUpdateReceived(QString callsign, AircraftVisualState visualState, VelocityVector positionalVelocityVector, VelocityVector rotationalVelocityVector, qint64 receivedAt);
         void OnPilotDeleted(QString callsign);
         void OnAircraftConfigurationReceived(QString callsign, QString json);
         void OnAircraftInfoReceived(QString callsign, QString typeCode, QString airlineIcao);
@@ -24,6 +24,7 @@ public:
     double HeadingVelocity;
     double BankVelocity;
     double NoseWheelAngle;
+    qint64 SampledAt; // steady clock microseconds when the plugin sampled it, 0 for RREF data
 
     bool operator!=(const UserAircraftData& other) const
     {
@@ -43,7 +44,8 @@ public:
                 PitchVelocity != other.PitchVelocity ||
                 HeadingVelocity != other.HeadingVelocity ||
                 BankVelocity != other.BankVelocity ||
-                NoseWheelAngle != other.NoseWheelAngle;
+                NoseWheelAngle != other.NoseWheelAngle ||
+                SampledAt != other.SampledAt;
     }
 
     bool operator==(const UserAircraftData& other) const
@@ -64,6 +66,7 @@ public:
                 PitchVelocity == other.PitchVelocity &&
                 HeadingVelocity == other.HeadingVelocity &&
                 BankVelocity == other.BankVelocity &&
-                NoseWheelAngle == other.NoseWheelAngle;
+                NoseWheelAngle == other.NoseWheelAngle &&
+                SampledAt == other.SampledAt;
     }
 };
@@ -8,6 +8,15 @@
 
 #include <src/common/build_config.h>
 
+#include <event2/thread.h>
+#include <mutex>
+
+#ifndef Q_OS_WIN
+#include <cerrno>
+#include <pthread.h>
+#include <sys/time.h>
+#endif
+
 using namespace afv_native::afv;
 
 namespace xpilot
@@ -25,6 +34,116 @@ namespace xpilot
 
     static afv_native::log_fn gLogger = defaultLogger;
 
+#ifdef Q_OS_WIN
+    static const int WAKEUP_SOCKET_FAMILY = AF_INET;
+#else
+    static const int WAKEUP_SOCKET_FAMILY = AF_UNIX;
+
+    // The bundled libevent is built without libevent_pthreads, so evthread_use_pthreads() isn't
+    // available; these are the equivalent callbacks.
+    static void* evLockAlloc(unsigned locktype)
+    {
+        auto *lock = new pthread_mutex_t;
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        if(locktype & EVTHREAD_LOCKTYPE_RECURSIVE) {
+            pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        }
+        if(pthread_mutex_init(lock, &attr) != 0) {
+            delete lock;
+            lock = nullptr;
+        }
+        pthread_mutexattr_destroy(&attr);
+        return lock;
+    }
+
+    static void evLockFree(void* lock, unsigned)
+    {
+        pthread_mutex_destroy(static_cast<pthread_mutex_t*>(lock));
+        delete static_cast<pthread_mutex_t*>(lock);
+    }
+
+    static int evLock(unsigned mode, void* lock)
+    {
+        return (mode & EVTHREAD_TRY) ? pthread_mutex_trylock(static_cast<pthread_mutex_t*>(lock))
+                                     : pthread_mutex_lock(static_cast<pthread_mutex_t*>(lock));
+    }
+
+    static int evUnlock(unsigned, void* lock)
+    {
+        return pthread_mutex_unlock(static_cast<pthread_mutex_t*>(lock));
+    }
+
+    static unsigned long evThreadId()
+    {
+        return static_cast<unsigned long>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    }
+
+    static void* evCondAlloc(unsigned)
+    {
+        auto *cond = new pthread_cond_t;
+        if(pthread_cond_init(cond, nullptr) != 0) {
+            delete cond;
+            cond = nullptr;
+        }
+        return cond;
+    }
+
+    static void evCondFree(void* cond)
+    {
+        pthread_cond_destroy(static_cast<pthread_cond_t*>(cond));
+        delete static_cast<pthread_cond_t*>(cond);
+    }
+
+    static int evCondSignal(void* cond, int broadcast)
+    {
+        return broadcast ? pthread_cond_broadcast(static_cast<pthread_cond_t*>(cond))
+                         : pthread_cond_signal(static_cast<pthread_cond_t*>(cond));
+    }
+
+    static int evCondWait(void* cond, void* lock, const struct timeval* tv)
+    {
+        auto *c = static_cast<pthread_cond_t*>(cond);
+        auto *m = static_cast<pthread_mutex_t*>(lock);
+        if(!tv) {
+            return pthread_cond_wait(c, m) == 0 ? 0 : -1;
+        }
+
+        struct timeval now, abstime;
+        gettimeofday(&now, nullptr);
+        evutil_timeradd(&now, tv, &abstime);
+        struct timespec ts;
+        ts.tv_sec = abstime.tv_sec;
+        ts.tv_nsec = abstime.tv_usec * 1000;
+        const int r = pthread_cond_timedwait(c, m, &ts);
+        return r == ETIMEDOUT ? 1 : (r == 0 ? 0 : -1);
+    }
+#endif
+
+    // Lets other threads wake the event loop with event_active() and stop it with event_base_loopbreak().
+    // Must run before the event base is created.
+    static void enableLibeventThreads()
+    {
+        static std::once_flag once;
+        std::call_once(once, []{
+#ifdef Q_OS_WIN
+            evthread_use_windows_threads();
+#else
+            static const evthread_lock_callbacks lockCallbacks = {
+                EVTHREAD_LOCK_API_VERSION, EVTHREAD_LOCKTYPE_RECURSIVE,
+                evLockAlloc, evLockFree, evLock, evUnlock
+            };
+            static const evthread_condition_callbacks conditionCallbacks = {
+                EVTHREAD_CONDITION_API_VERSION,
+                evCondAlloc, evCondFree, evCondSignal, evCondWait
+            };
+            evthread_set_lock_callbacks(&lockCallbacks);
+            evthread_set_condition_callbacks(&conditionCallbacks);
+            evthread_set_id_callback(evThreadId);
+#endif
+        });
+    }
+
     AudioForVatsim::AudioForVatsim(NetworkManager& networkManager, XplaneAdapter& xplaneAdapter, ControllerManager& controllerManager, QObject* parent) :
         QObject(parent),
         m_xplaneAdapter(xplaneAdapter),
@@ -66,7 +185,28 @@ namespace xpilot
 
         QString clientName = QString("xPilot %1").arg(BuildConfig::getVersionString());
 
+        enableLibeventThreads();
         ev_base = event_base_new();
+
+        // Cross-thread wakeup for the event loop: writing a byte to one end of the socket pair makes
+        // the loop run the queued tasks.
+        if(evutil_socketpair(WAKEUP_SOCKET_FAMILY, SOCK_STREAM, 0, m_wakeupSockets) == 0)
+        {
+            evutil_make_socket_nonblocking(m_wakeupSockets[0]);
+            evutil_make_socket_nonblocking(m_wakeupSockets[1]);
+            m_wakeupEvent = event_new(ev_base, m_wakeupSockets[0], EV_READ | EV_PERSIST, &AudioForVatsim::onEventLoopWakeup, this);
+            event_add(m_wakeupEvent, nullptr);
+        }
+        else
+        {
+            // no sockets to spare: fall back to a user event that runOnEventLoop fires with event_active()
+            afvLogger(QString("%1: AudioForVatsim: Could not create wakeup socket pair (%2), using a user event instead\r\n")
+                      .arg(QDateTime::currentDateTimeUtc().toString("MMM dd HH:mm:ss yyyy"))
+                      .arg(evutil_socket_error_to_string(EVUTIL_SOCKET_ERROR())));
+            m_wakeupSockets[0] = m_wakeupSockets[1] = -1;
+            m_wakeupEvent = event_new(ev_base, -1, 0, &AudioForVatsim::onEventLoopWakeup, this);
+        }
+
         m_client = std::make_shared<afv_native::Client>(ev_base, 2, clientName.toStdString().c_str());
         m_client->ClientEventCallback.addCallback(nullptr, [&](afv_native::ClientEventType evt, void* data)
         {
@@ -120,8 +260,11 @@ namespace xpilot
                     break;
                 case afv_native::ClientEventType::StationAliasesUpdated:
                     {
+                        // this callback runs on the event loop thread; hand the aliases over to the Qt thread
                         auto stations = m_client->getStationAliases();
-                        m_aliasedStations = QVector<afv_native::afv::dto::Station>(stations.begin(), stations.end());
+                        QMetaObject::invokeMethod(this, [this, stations]{
+                            m_aliasedStations = QVector<afv_native::afv::dto::Station>(stations.begin(), stations.end());
+                        });
                     }
                     break;
                 case afv_native::ClientEventType::VoiceServerConnected:
@@ -134,9 +277,12 @@ namespace xpilot
                     break;
             }
         });
-        m_client->setEnableInputFilters(true);
-        m_client->setEnableOutputEffects(!AppConfig::getInstance()->AudioEffectsDisabled);
-        m_client->setEnableHfSquelch(AppConfig::getInstance()->HFSquelchEnabled);
+        runOnEventLoop([this, effectsDisabled = AppConfig::getInstance()->AudioEffectsDisabled,
+                       hfSquelch = AppConfig::getInstance()->HFSquelchEnabled]{
+            m_client->setEnableInputFilters(true);
+            m_client->setEnableOutputEffects(!effectsDisabled);
+            m_client->setEnableHfSquelch(hfSquelch);
+        });
 
         configureAudioDevices();
         setMicrophoneVolume(AppConfig::getInstance()->MicrophoneVolume);
@@ -167,10 +313,10 @@ namespace xpilot
                 m_radioStackState = state;
 
                 if(m_radioStackState.Com1TransmitEnabled) {
-                    m_client->setTxRadio(0);
+                    runOnEventLoop([this]{ m_client->setTxRadio(0); });
                 }
                 else if(m_radioStackState.Com2TransmitEnabled) {
-                    m_client->setTxRadio(1);
+                    runOnEventLoop([this]{ m_client->setTxRadio(1); });
                 }
 
                 if(AppConfig::getInstance()->AircraftRadioStackControlsVolume) {
@@ -187,10 +333,10 @@ namespace xpilot
             }
         });
         connect(&xplaneAdapter, &XplaneAdapter::pttPressed, this, [&]{
-            m_client->setPtt(true);
+            runOnEventLoop([this]{ m_client->setPtt(true); });
         });
         connect(&xplaneAdapter, &XplaneAdapter::pttReleased, this, [&]{
-            m_client->setPtt(false);
+            runOnEventLoop([this]{ m_client->setPtt(false); });
         });
 
         connect(&controllerManager, &ControllerManager::controllerAdded, this, [&](Controller controller)
@@ -246,28 +392,79 @@ namespace xpilot
             }
         });
 
-        m_keepAlive = true;
+        // Block in the event loop until there is work to do; datagrams, timers and HTTP completions
+        // are dispatched as soon as they are ready instead of on the next polling interval.
         m_workerThread = QThread::create([&]{
-            while(m_keepAlive)
-            {
-                event_base_loop(ev_base, EVLOOP_NONBLOCK);
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
+            event_base_loop(ev_base, EVLOOP_NO_EXIT_ON_EMPTY);
         });
         m_workerThread->start();
     }
 
     AudioForVatsim::~AudioForVatsim()
     {
-        m_keepAlive = false;
-        m_workerThread->terminate();
-        m_workerThread->deleteLater();
+        // thread-safe with libevent threading enabled, and doesn't depend on the wakeup path;
+        // repeated in case the loop hadn't started yet, as starting it clears the break flag
+        do {
+            event_base_loopbreak(ev_base);
+        } while(!m_workerThread->wait(100));
+        delete m_workerThread;
+
         m_client.reset();
+        if(m_wakeupEvent)
+        {
+            event_free(m_wakeupEvent);
+        }
+        if(m_wakeupSockets[0] != -1)
+        {
+            evutil_closesocket(m_wakeupSockets[0]);
+            evutil_closesocket(m_wakeupSockets[1]);
+        }
+        event_base_free(ev_base);
 #ifdef Q_OS_WIN
         WSACleanup();
 #endif
     }
 
+    void AudioForVatsim::runOnEventLoop(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_pendingTasksLock);
+            m_pendingTasks.push_back(std::move(task));
+        }
+        if(m_wakeupSockets[1] != -1)
+        {
+            const char wakeup = 0;
+            send(m_wakeupSockets[1], &wakeup, 1, 0);
+        }
+        else if(m_wakeupEvent)
+        {
+            event_active(m_wakeupEvent, 0, 0);
+        }
+    }
+
+    void AudioForVatsim::runPendingTasks()
+    {
+        std::vector<std::function<void()>> tasks;
+        {
+            std::lock_guard<std::mutex> lock(m_pendingTasksLock);
+            tasks.swap(m_pendingTasks);
+        }
+        for(auto &task : tasks)
+        {
+            task();
+        }
+    }
+
+    void AudioForVatsim::onEventLoopWakeup(evutil_socket_t fd, short events, void* arg)
+    {
+        if(fd != -1)
+        {
+            char buffer[64];
+            while(recv(fd, buffer, sizeof(buffer), 0) > 0) {}
+        }
+        reinterpret_cast<AudioForVatsim*>(arg)->runPendingTasks();
+    }
+
     void AudioForVatsim::afvLogger(QString message)
     {
         m_logDataStream << message;
@@ -277,18 +474,22 @@ namespace xpilot
     void AudioForVatsim::setInputDevice(QString deviceName)
     {
         if(!deviceName.isEmpty()) {
-            m_client->stopAudio();
-            m_client->setAudioInputDevice(deviceName.toStdString().c_str());
-            m_client->startAudio();
+            runOnEventLoop([this, device = deviceName.toStdString()]{
+                m_client->stopAudio();
+                m_client->setAudioInputDevice(device);
+                m_client->startAudio();
+            });
         }
     }
 
     void AudioForVatsim::setOutputDevice(QString deviceName)
     {
         if(!deviceName.isEmpty()) {
-            m_client->stopAudio();
-            m_client->setAudioOutputDevice(deviceName.toStdString().c_str());
-            m_client->startAudio();
+            runOnEventLoop([this, device = deviceName.toStdString()]{
+                m_client->stopAudio();
+                m_client->setAudioOutputDevice(device);
+                m_client->startAudio();
+            });
         }
     }
 
@@ -298,7 +499,7 @@ namespace xpilot
         if(v < 0) v = 0;
         if(v > 100) v = 100;
 
-        m_client->setRadioGain(0, ScaleVolume(v / 100.0f));
+        runOnEventLoop([this, gain = ScaleVolume(v / 100.0f)]{ m_client->setRadioGain(0, gain); });
 
         AppConfig::getInstance()->Com1Volume = v;
         AppConfig::getInstance()->saveConfig();
@@ -310,7 +511,7 @@ namespace xpilot
         if(v < 0) v = 0;
         if(v > 100) v = 100;
 
-        m_client->setRadioGain(1, ScaleVolume(v / 100.0f));
+        runOnEventLoop([this, gain = ScaleVolume(v / 100.0f)]{ m_client->setRadioGain(1, gain); });
 
         AppConfig::getInstance()->Com2Volume = v;
         AppConfig::getInstance()->saveConfig();
@@ -318,14 +519,14 @@ namespace xpilot
 
     void AudioForVatsim::disableAudioEffects(bool disabled)
     {
-        m_client->setEnableOutputEffects(!disabled);
+        runOnEventLoop([this, disabled]{ m_client->setEnableOutputEffects(!disabled); });
         AppConfig::getInstance()->AudioEffectsDisabled = disabled;
         AppConfig::getInstance()->saveConfig();
     }
 
     void AudioForVatsim::enableHfSquelch(bool enabled)
     {
-        m_client->setEnableHfSquelch(enabled);
+        runOnEventLoop([this, enabled]{ m_client->setEnableHfSquelch(enabled); });
         AppConfig::getInstance()->HFSquelchEnabled = enabled;
         AppConfig::getInstance()->saveConfig();
     }
@@ -335,9 +536,13 @@ namespace xpilot
         if(!enableVoice)
             return;
 
-        m_client->setCallsign(callsign.toStdString());
-        m_client->setCredentials(AppConfig::getInstance()->VatsimId.toStdString(), AppConfig::getInstance()->VatsimPasswordDecrypted.toStdString());
-        m_client->connect();
+        runOnEventLoop([this, cs = callsign.toStdString(),
+                       username = AppConfig::getInstance()->VatsimId.toStdString(),
+                       password = AppConfig::getInstance()->VatsimPasswordDecrypted.toStdString()]{
+            m_client->setCallsign(cs);
+            m_client->setCredentials(username, password);
+            m_client->connect();
+        });
         m_transceiverTimer.start();
         m_rxTxQueryTimer.start();
     }
@@ -347,7 +552,7 @@ namespace xpilot
         emit radioRxChanged(0, false);
         emit radioRxChanged(1, false);
 
-        m_client->disconnect();
+        runOnEventLoop([this]{ m_client->disconnect(); });
         m_transceiverTimer.stop();
         m_rxTxQueryTimer.stop();
     }
@@ -398,7 +603,7 @@ namespace xpilot
 
     void AudioForVatsim::configureAudioDevices()
     {
-        m_client->stopAudio();
+        runOnEventLoop([this]{ m_client->stopAudio(); });
 
         m_outputDevices.clear();
         m_inputDevices.clear();
@@ -425,17 +630,20 @@ namespace xpilot
 
         emit inputDevicesChanged();
 
-        if(!AppConfig::getInstance()->InputDevice.isEmpty())
-        {
-            m_client->setAudioInputDevice(AppConfig::getInstance()->InputDevice.toStdString());
-        }
+        runOnEventLoop([this, inputDevice = AppConfig::getInstance()->InputDevice.toStdString(),
+                       outputDevice = AppConfig::getInstance()->OutputDevice.toStdString()]{
+            if(!inputDevice.empty())
+            {
+                m_client->setAudioInputDevice(inputDevice);
+            }
 
-        if(!AppConfig::getInstance()->OutputDevice.isEmpty())
-        {
-            m_client->setAudioOutputDevice(AppConfig::getInstance()->OutputDevice.toStdString());
-        }
+            if(!outputDevice.empty())
+            {
+                m_client->setAudioOutputDevice(outputDevice);
+            }
 
-        m_client->startAudio();
+            m_client->startAudio();
+        });
     }
 
     void AudioForVatsim::updateTransceivers()
@@ -446,17 +654,22 @@ namespace xpilot
         com1Alias > 0 ? (emit radioAliasChanged(0, com1Alias)) : (emit radioAliasChanged(0, 0));
         com2Alias > 0 ? (emit radioAliasChanged(1, com2Alias)) : (emit radioAliasChanged(1, 0));
 
-        m_client->setRadioState(0, m_radioStackState.Com1ReceiveEnabled &&
-                                m_radioStackState.AvionicsPowerOn ? (com1Alias > 0 ? com1Alias : m_radioStackState.Com1Frequency * 1000) : 0);
-        m_client->setRadioState(1, m_radioStackState.Com2ReceiveEnabled &&
-                                m_radioStackState.AvionicsPowerOn ? (com2Alias > 0 ? com2Alias : m_radioStackState.Com2Frequency * 1000) : 0);
-        m_client->setClientPosition(m_userAircraftData.Latitude, m_userAircraftData.Longitude, m_userAircraftData.AltitudeMslM,
-                                    m_userAircraftData.AltitudeAglM);
+        int com1Freq = m_radioStackState.Com1ReceiveEnabled &&
+                m_radioStackState.AvionicsPowerOn ? (com1Alias > 0 ? com1Alias : m_radioStackState.Com1Frequency * 1000) : 0;
+        int com2Freq = m_radioStackState.Com2ReceiveEnabled &&
+                m_radioStackState.AvionicsPowerOn ? (com2Alias > 0 ? com2Alias : m_radioStackState.Com2Frequency * 1000) : 0;
+        UserAircraftData position = m_userAircraftData;
+
+        runOnEventLoop([this, com1Freq, com2Freq, position]{
+            m_client->setRadioState(0, com1Freq);
+            m_client->setRadioState(1, com2Freq);
+            m_client->setClientPosition(position.Latitude, position.Longitude, position.AltitudeMslM, position.AltitudeAglM);
+        });
     }
 
     void AudioForVatsim::setMicrophoneVolume(int volume)
     {
-        m_client->setMicrophoneVolume(volume);
+        runOnEventLoop([this, volume]{ m_client->setMicrophoneVolume(volume); });
     }
 
     void AudioForVatsim::settingsWindowOpened()
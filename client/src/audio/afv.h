@@ -12,6 +12,9 @@
 
 #include <thread>
 #include <memory>
+#include <mutex>
+#include <functional>
+#include <vector>
 
 #include "src/network/networkmanager.h"
 #include "src/simulator/xplane_adapter.h"
@@ -93,10 +96,19 @@ namespace xpilot
         void configureAudioDevices();
         void updateTransceivers();
 
+        // Queues a task to run on the libevent loop thread. afv_native::Client is not thread-safe,
+        // so every call that changes its state must go through here.
+        void runOnEventLoop(std::function<void()> task);
+        void runPendingTasks();
+        static void onEventLoopWakeup(evutil_socket_t fd, short events, void* arg);
+
     private:
         XplaneAdapter& m_xplaneAdapter;
         struct event_base* ev_base;
-        bool m_keepAlive = false;
+        struct event* m_wakeupEvent = nullptr;
+        evutil_socket_t m_wakeupSockets[2] = { -1, -1 };
+        std::mutex m_pendingTasksLock;
+        std::vector<std::function<void()>> m_pendingTasks;
         std::shared_ptr<afv_native::Client> m_client;
         QTimer m_transceiverTimer;
         QTimer m_eventTimer;
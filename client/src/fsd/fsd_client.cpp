@@ -6,6 +6,8 @@
 #include <src/fsd/pdu/pdu_auth_response.h>
 #include <src/fsd/pdu/pdu_change_server.h>
 
+#include <chrono>
+
 namespace xpilot
 {
     FsdClient::FsdClient(QObject * parent) : QObject(parent)
@@ -55,6 +57,10 @@ namespace xpilot
     {
         if(data.length() == 0) return;
 
+        // the plugin measures position latency from here, on the same clock as its own stamps
+        const qint64 receivedAt = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
         // Strip out trailing null, if any
         if(data.right(data.length() - 1) == "\0")
         {
@@ -92,7 +98,9 @@ namespace xpilot
                 else if(prefixChar == '^')
                 {
                     fields[0] = fields[0].mid(1);
-                    emit RaiseFastPilotPositionReceived(PDUFastPilotPosition::fromTokens(FastPilotPositionType::Fast, fields));
+                    PDUFastPilotPosition pdu = PDUFastPilotPosition::fromTokens(FastPilotPositionType::Fast, fields);
+                    pdu.ReceivedAt = receivedAt;
+                    emit RaiseFastPilotPositionReceived(pdu);
                 }
                 else if(prefixChar == '%')
                 {
@@ -200,11 +208,15 @@ namespace xpilot
                     }
                     else if(pduTypeId == "#SL")
                     {
-                        emit RaiseFastPilotPositionReceived(PDUFastPilotPosition::fromTokens(FastPilotPositionType::Slow, fields));
+                        PDUFastPilotPosition pdu = PDUFastPilotPosition::fromTokens(FastPilotPositionType::Slow, fields);
+                        pdu.ReceivedAt = receivedAt;
+                        emit RaiseFastPilotPositionReceived(pdu);
                     }
                     else if(pduTypeId == "#ST")
                     {
-                        emit RaiseFastPilotPositionReceived(PDUFastPilotPosition::fromTokens(FastPilotPositionType::Stopped, fields));
+                        PDUFastPilotPosition pdu = PDUFastPilotPosition::fromTokens(FastPilotPositionType::Stopped, fields);
+                        pdu.ReceivedAt = receivedAt;
+                        emit RaiseFastPilotPositionReceived(pdu);
                     }
                     else if(pduTypeId == "$XX")
                     {
@@ -49,6 +49,7 @@ public:
     double VelocityHeading;
     double VelocityBank;
     double NoseGearAngle;
+    qint64 ReceivedAt = 0; // steady clock microseconds when the packet was read from the socket
 
 private:
     PDUFastPilotPosition();
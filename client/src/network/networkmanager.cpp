@@ -1,8 +1,10 @@
 #include <algorithm>
+#include <cmath>
 #include <chrono>
 #include <random>
 #include <QRandomGenerator>
 #include <QDateTime>
+#include <QtMath>
 
 #include <src/fsd/pdu/pdu_metar_request.h>
 
@@ -18,6 +20,10 @@
 
 namespace xpilot
 {
+    // beyond this the snapshot is stale (e.g. the sim stalled) and is sent as it is
+    constexpr double MAX_POSITION_EXTRAPOLATION_SECS = 0.5;
+    constexpr double EARTH_RADIUS_M = 6371008.8;
+
     NetworkManager::NetworkManager(XplaneAdapter &xplaneAdapter, QObject *owner) :
         QObject(owner),
         m_xplaneAdapter(xplaneAdapter),
@@ -381,12 +387,12 @@ namespace xpilot
             rotationalVelocityVector.Y = pdu.VelocityHeading;
             rotationalVelocityVector.Z = pdu.VelocityBank;
 
-            emit fastPositionUpdateReceived(pdu.From, visualState, positionalVelocityVector, rotationalVelocityVector);
+            emit fastPositionUpdateReceived(pdu.From, visualState, positionalVelocityVector, rotationalVelocityVector, pdu.ReceivedAt);
         }
         else
         {
             VelocityVector zero{0,0,0};
-            emit fastPositionUpdateReceived(pdu.From, visualState, zero, zero);
+            emit fastPositionUpdateReceived(pdu.From, visualState, zero, zero, pdu.ReceivedAt);
         }
     }
 
@@ -598,26 +604,54 @@ namespace xpilot
         }
     }
 
+    UserAircraftData NetworkManager::ExtrapolateUserAircraftData() const
+    {
+        // the plugin's snapshot is timestamped, so move it forward to the moment we send it
+        UserAircraftData data = m_userAircraftData;
+        if(data.SampledAt <= 0)
+            return data;
+
+        const double elapsed = (getSteadyMicroseconds() - data.SampledAt) / 1000000.0;
+        if(elapsed <= 0.0 || elapsed > MAX_POSITION_EXTRAPOLATION_SECS)
+            return data;
+
+        const double latitudeRadians = qDegreesToRadians(data.Latitude);
+        data.Latitude += qRadiansToDegrees(data.LatitudeVelocity * elapsed / EARTH_RADIUS_M);
+        if(std::abs(std::cos(latitudeRadians)) > 1e-6) {
+            data.Longitude += qRadiansToDegrees(data.LongitudeVelocity * elapsed / (EARTH_RADIUS_M * std::cos(latitudeRadians)));
+        }
+        data.AltitudeMslM += data.AltitudeVelocity * elapsed;
+        data.AltitudeAglM += data.AltitudeVelocity * elapsed;
+
+        // the rotational velocities are already sign flipped for FSD
+        data.Pitch -= qRadiansToDegrees(data.PitchVelocity * elapsed);
+        data.Bank -= qRadiansToDegrees(data.BankVelocity * elapsed);
+        data.Heading = std::fmod(data.Heading + qRadiansToDegrees(data.HeadingVelocity * elapsed) + 360.0, 360.0);
+
+        return data;
+    }
+
     void NetworkManager::SendFastPositionPacket(bool sendSlowFast)
     {
         if(!m_connectInfo.ObserverMode && !m_connectInfo.TowerViewMode)
         {
+            const UserAircraftData data = ExtrapolateUserAircraftData();
             m_fsd.SendPDU(PDUFastPilotPosition(sendSlowFast ? FastPilotPositionType::Slow : FastPilotPositionType::Fast,
                                                m_connectInfo.Callsign,
-                                               m_userAircraftData.Latitude,
-                                               m_userAircraftData.Longitude,
-                                               m_userAircraftData.AltitudeMslM * 3.28084,
-                                               m_userAircraftData.AltitudeAglM * 3.28084,
-                                               m_userAircraftData.Pitch,
-                                               m_userAircraftData.Heading,
-                                               m_userAircraftData.Bank,
-                                               m_userAircraftData.LongitudeVelocity,
-                                               m_userAircraftData.AltitudeVelocity,
-                                               m_userAircraftData.LatitudeVelocity,
-                                               m_userAircraftData.PitchVelocity,
-                                               m_userAircraftData.HeadingVelocity,
-                                               m_userAircraftData.BankVelocity,
-                                               m_userAircraftData.NoseWheelAngle));
+                                               data.Latitude,
+                                               data.Longitude,
+                                               data.AltitudeMslM * 3.28084,
+                                               data.AltitudeAglM * 3.28084,
+                                               data.Pitch,
+                                               data.Heading,
+                                               data.Bank,
+                                               data.LongitudeVelocity,
+                                               data.AltitudeVelocity,
+                                               data.LatitudeVelocity,
+                                               data.PitchVelocity,
+                                               data.HeadingVelocity,
+                                               data.BankVelocity,
+                                               data.NoseWheelAngle));
         }
     }
 
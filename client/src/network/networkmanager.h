@@ -75,7 +75,7 @@ namespace xpilot
         void realNameReceived(QString callsign, QString name);
         void controllerAtisReceived(QString callsign, QStringList atis);
         void slowPositionUpdateReceived(QString callsign, AircraftVisualState visualState, double groundSpeed);
-        void fastPositionUpdateReceived(QString callsign, AircraftVisualState visualState, VelocityVector positionalVelocityVector, VelocityVector rotationalVelocityVector);
+        void fastPositionUpdateReceived(QString callsign, AircraftVisualState visualState, VelocityVector positionalVelocityVector, VelocityVector rotationalVelocityVector, qint64 receivedAt);
         void aircraftInfoReceived(QString callsign, QString equipment, QString airline);
         void microphoneCalibrationRequired();
 
@@ -84,7 +84,7 @@ namespace xpilot
         XplaneAdapter& m_xplaneAdapter;
         QTimer m_slowPositionTimer;
         QTimer m_fastPositionTimer;
-        UserAircraftData m_userAircraftData;
+        UserAircraftData m_userAircraftData{};
         UserAircraftConfigData m_userAircraftConfigData;
         RadioStackState m_radioStackState;
         ConnectInfo m_connectInfo{};
@@ -138,6 +138,7 @@ namespace xpilot
         void SendFastPositionPacket(bool sendSlowFast = false);
         void SendZeroVelocityFastPositionPacket();
         void SendStoppedFastPositionPacket();
+        UserAircraftData ExtrapolateUserAircraftData() const;
 
         void OnSlowPositionTimerElapsed();
         void OnFastPositionTimerElapsed();
@@ -4,6 +4,10 @@
 #include <msgpack.hpp>
 #include <string>
 #include <optional>
+#include <vector>
+#include <string_view>
+#include <unordered_map>
+#include <chrono>
 
 namespace xpilot {
 
@@ -15,6 +19,7 @@ namespace xpilot {
         const std::string DELETE_ALL_AIRCRAFT = "DELALL";
         const std::string AIRCRAFT_CONFIG = "ACCONF";
         const std::string FAST_POSITION_UPDATE = "FSTPOS";
+        const std::string POSITION_FRAME = "FSTPOSFRAME";
         const std::string HEARTBEAT = "HB";
         const std::string PLUGIN_VER = "VER";
         const std::string VALIDATE_CSL = "CSL";
@@ -32,6 +37,88 @@ namespace xpilot {
         const std::string DISCONNECTED = "DISCON";
         const std::string SHUTDOWN = "SHUTDOWN";
         const std::string STATION_CALLSIGN = "STATION_CALLSIGN";
+        const std::string USER_AIRCRAFT_STATE = "USERSTATE";
+
+        // Compact message ids, sent in place of the type names above once both sides
+        // have advertised PROTOCOL_VERSION in the PLUGIN_VER handshake.
+        // The values are part of the wire protocol, so new ids must only be appended.
+        enum class MessageId : uint8_t {
+            Unknown = 0,
+            AddAircraft = 1,
+            AircraftAdded = 2,
+            AircraftDeleted = 3,
+            DeleteAircraft = 4,
+            DeleteAllAircraft = 5,
+            AircraftConfig = 6,
+            FastPositionUpdate = 7,
+            PositionFrame = 8,
+            Heartbeat = 9,
+            PluginVersion = 10,
+            ValidateCsl = 11,
+            RadioMessageSent = 12,
+            RadioMessageReceived = 13,
+            NotificationPosted = 14,
+            PrivateMessageSent = 15,
+            PrivateMessageReceived = 16,
+            NearbyAtc = 17,
+            RequestMetar = 18,
+            RequestStationInfo = 19,
+            WallopSent = 20,
+            ForceDisconnect = 21,
+            Connected = 22,
+            Disconnected = 23,
+            Shutdown = 24,
+            StationCallsign = 25,
+            UserAircraftState = 26,
+            Count
+        };
+
+        // 1: compact message ids, fast position updates batched into POSITION_FRAME
+        // 2: aircraft are referred to by the handle assigned in ADD_AIRCRAFT instead of their callsign
+        // 3: the plugin streams USER_AIRCRAFT_STATE every frame
+        constexpr int PROTOCOL_VERSION = 3;
+
+        // lowest peer version for each feature
+        constexpr int PROTOCOL_VERSION_POSITION_FRAMES = 1;
+        constexpr int PROTOCOL_VERSION_HANDLES = 2;
+        constexpr int PROTOCOL_VERSION_USER_STATE = 3;
+
+        // handles are recycled by the client, so they stay below the peak number of aircraft;
+        // past this limit aircraft are sent by callsign only
+        constexpr uint32_t MAX_AIRCRAFT_HANDLES = 4096;
+
+        inline MessageId GetMessageId(std::string_view name) {
+            static const std::unordered_map<std::string_view, MessageId> ids = {
+                { ADD_AIRCRAFT, MessageId::AddAircraft },
+                { AIRCRAFT_ADDED, MessageId::AircraftAdded },
+                { AIRCRAFT_DELETED, MessageId::AircraftDeleted },
+                { DELETE_AIRCRAFT, MessageId::DeleteAircraft },
+                { DELETE_ALL_AIRCRAFT, MessageId::DeleteAllAircraft },
+                { AIRCRAFT_CONFIG, MessageId::AircraftConfig },
+                { FAST_POSITION_UPDATE, MessageId::FastPositionUpdate },
+                { POSITION_FRAME, MessageId::PositionFrame },
+                { HEARTBEAT, MessageId::Heartbeat },
+                { PLUGIN_VER, MessageId::PluginVersion },
+                { VALIDATE_CSL, MessageId::ValidateCsl },
+                { RADIO_MESSAGE_SENT, MessageId::RadioMessageSent },
+                { RADIO_MESSAGE_RECEIVED, MessageId::RadioMessageReceived },
+                { NOTIFICATION_POSTED, MessageId::NotificationPosted },
+                { PRIVATE_MESSAGE_SENT, MessageId::PrivateMessageSent },
+                { PRIVATE_MESSAGE_RECEIVED, MessageId::PrivateMessageReceived },
+                { NEARBY_ATC, MessageId::NearbyAtc },
+                { REQUEST_METAR, MessageId::RequestMetar },
+                { REQUEST_STATION_INFO, MessageId::RequestStationInfo },
+                { WALLOP_SENT, MessageId::WallopSent },
+                { FORCE_DISCONNECT, MessageId::ForceDisconnect },
+                { CONNECTED, MessageId::Connected },
+                { DISCONNECTED, MessageId::Disconnected },
+                { SHUTDOWN, MessageId::Shutdown },
+                { STATION_CALLSIGN, MessageId::StationCallsign },
+                { USER_AIRCRAFT_STATE, MessageId::UserAircraftState },
+            };
+            auto it = ids.find(name);
+            return it != ids.end() ? it->second : MessageId::Unknown;
+        }
     }
 
     using namespace dto;
@@ -42,6 +129,26 @@ namespace xpilot {
         MSGPACK_DEFINE(type, dto)
     };
 
+    // Same layout as BaseDto, with the type name replaced by its MessageId
+    struct CompactDto {
+        uint8_t id;
+        msgpack::object dto;
+        MSGPACK_DEFINE(id, dto)
+    };
+
+    // Optional trailer after the envelope's header and dto, used for latency and drop accounting.
+    // Peers that don't know about it ignore the extra array elements.
+    struct MessageStamp {
+        uint32_t sequence = 0; // counted per message type from 1, 0 if the message isn't stamped
+        int64_t sentAt = 0; // steady clock microseconds, only comparable on the same machine
+    };
+
+    inline int64_t getSteadyMicroseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
     struct AddAircraftDto {
         std::string callsign;
         std::string airline;
@@ -52,46 +159,68 @@ namespace xpilot {
         double heading;
         double bank;
         double pitch;
-        MSGPACK_DEFINE(callsign, airline, typeCode, latitude, longitude, altitudeTrue, heading, bank, pitch);
+        uint32_t handle = 0; // 0 when the client doesn't use aircraft handles
+        MSGPACK_DEFINE(callsign, airline, typeCode, latitude, longitude, altitudeTrue, heading, bank, pitch, handle);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return ADD_AIRCRAFT;
         }
+
+        static MessageId getId() {
+            return MessageId::AddAircraft;
+        }
     };
 
     struct AircraftAddedDto {
         std::string callsign;
         MSGPACK_DEFINE(callsign);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return AIRCRAFT_ADDED;
         }
+
+        static MessageId getId() {
+            return MessageId::AircraftAdded;
+        }
     };
 
     struct AircraftDeletedDto {
         std::string callsign;
         MSGPACK_DEFINE(callsign);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return AIRCRAFT_DELETED;
         }
+
+        static MessageId getId() {
+            return MessageId::AircraftDeleted;
+        }
     };
 
     struct DeleteAircraftDto {
         std::string callsign;
         std::string reason;
-        MSGPACK_DEFINE(callsign, reason);
+        uint32_t handle = 0;
+        MSGPACK_DEFINE(callsign, reason, handle);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return DELETE_AIRCRAFT;
         }
+
+        static MessageId getId() {
+            return MessageId::DeleteAircraft;
+        }
     };
 
     struct DeleteAllAircraftDto {
         MSGPACK_DEFINE();
-        static std::string getName() {
+        static const std::string& getName() {
             return DELETE_ALL_AIRCRAFT;
         }
+
+        static MessageId getId() {
+            return MessageId::DeleteAllAircraft;
+        }
     };
 
     struct AircraftConfigDto {
@@ -108,11 +237,16 @@ namespace xpilot {
         std::optional<bool> navLightsOn;
         std::optional<bool> strobeLightsOn;
         std::optional<bool> taxiLightsOn;
-        MSGPACK_DEFINE(callsign, fullConfig, enginesOn, enginesReversing, onGround, flaps, gearDown, beaconLightsOn, landingLightsOn, navLightsOn, strobeLightsOn, taxiLightsOn);
+        uint32_t handle = 0;
+        MSGPACK_DEFINE(callsign, fullConfig, enginesOn, enginesReversing, onGround, flaps, gearDown, beaconLightsOn, landingLightsOn, navLightsOn, strobeLightsOn, taxiLightsOn, handle);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return AIRCRAFT_CONFIG;
         }
+
+        static MessageId getId() {
+            return MessageId::AircraftConfig;
+        }
     };
 
     struct FastPositionUpdateDto {
@@ -132,47 +266,84 @@ namespace xpilot {
         double vb;
         double noseWheelAngle;
         double speed;
-        MSGPACK_DEFINE(callsign, latitude, longitude, altitudeTrue, altitudeAgl, heading, bank, pitch, vx, vy, vz, vp, vh, vb, noseWheelAngle, speed);
+        uint32_t handle = 0;
+        MSGPACK_DEFINE(callsign, latitude, longitude, altitudeTrue, altitudeAgl, heading, bank, pitch, vx, vy, vz, vp, vh, vb, noseWheelAngle, speed, handle);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return FAST_POSITION_UPDATE;
         }
+
+        static MessageId getId() {
+            return MessageId::FastPositionUpdate;
+        }
+    };
+
+    // All fast position updates gathered during one client tick, sent as a single message
+    struct PositionFrameDto {
+        std::vector<FastPositionUpdateDto> updates;
+        MSGPACK_DEFINE(updates);
+
+        static const std::string& getName() {
+            return POSITION_FRAME;
+        }
+
+        static MessageId getId() {
+            return MessageId::PositionFrame;
+        }
     };
 
     struct HeartbeatDto {
         std::string callsign;
-        MSGPACK_DEFINE(callsign);
+        uint32_t handle = 0;
+        MSGPACK_DEFINE(callsign, handle);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return HEARTBEAT;
         }
+
+        static MessageId getId() {
+            return MessageId::Heartbeat;
+        }
     };
 
     struct PluginVersionDto {
         int version;
-        MSGPACK_DEFINE(version);
+        int protocol = 0; // absent (0) for peers that only understand type names
+        MSGPACK_DEFINE(version, protocol);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return PLUGIN_VER;
         }
+
+        static MessageId getId() {
+            return MessageId::PluginVersion;
+        }
     };
 
     struct ValidateCslDto {
         bool isValid;
         MSGPACK_DEFINE(isValid);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return VALIDATE_CSL;
         }
+
+        static MessageId getId() {
+            return MessageId::ValidateCsl;
+        }
     };
 
     struct RadioMessageSentDto {
         std::string message;
         MSGPACK_DEFINE(message);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return RADIO_MESSAGE_SENT;
         }
+
+        static MessageId getId() {
+            return MessageId::RadioMessageSent;
+        }
     };
 
     struct RadioMessageReceivedDto {
@@ -181,9 +352,13 @@ namespace xpilot {
         bool isDirect;
         MSGPACK_DEFINE(from, message, isDirect);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return RADIO_MESSAGE_RECEIVED;
         }
+
+        static MessageId getId() {
+            return MessageId::RadioMessageReceived;
+        }
     };
 
     struct NotificationPostedDto {
@@ -191,9 +366,13 @@ namespace xpilot {
         int64_t color;
         MSGPACK_DEFINE(message, color);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return NOTIFICATION_POSTED;
         }
+
+        static MessageId getId() {
+            return MessageId::NotificationPosted;
+        }
     };
 
     struct PrivateMessageSentDto {
@@ -201,9 +380,13 @@ namespace xpilot {
         std::string message;
         MSGPACK_DEFINE(to, message);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return PRIVATE_MESSAGE_SENT;
         }
+
+        static MessageId getId() {
+            return MessageId::PrivateMessageSent;
+        }
     };
 
     struct PrivateMessageReceivedDto {
@@ -211,9 +394,13 @@ namespace xpilot {
         std::string message;
         MSGPACK_DEFINE(from, message);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return PRIVATE_MESSAGE_RECEIVED;
         }
+
+        static MessageId getId() {
+            return MessageId::PrivateMessageReceived;
+        }
     };
 
     struct NearbyAtcStationDto {
@@ -228,45 +415,65 @@ namespace xpilot {
         std::vector<NearbyAtcStationDto> stations;
         MSGPACK_DEFINE(stations);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return NEARBY_ATC;
         }
+
+        static MessageId getId() {
+            return MessageId::NearbyAtc;
+        }
     };
 
     struct RequestMetarDto {
         std::string station;
         MSGPACK_DEFINE(station);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return REQUEST_METAR;
         }
+
+        static MessageId getId() {
+            return MessageId::RequestMetar;
+        }
     };
 
     struct RequestStationInfoDto {
         std::string station;
         MSGPACK_DEFINE(station);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return REQUEST_STATION_INFO;
         }
+
+        static MessageId getId() {
+            return MessageId::RequestStationInfo;
+        }
     };
 
     struct WallopSentDto {
         std::string message;
         MSGPACK_DEFINE(message);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return WALLOP_SENT;
         }
+
+        static MessageId getId() {
+            return MessageId::WallopSent;
+        }
     };
 
     struct ForcedDisconnectDto {
         std::string reason;
         MSGPACK_DEFINE(reason);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return FORCE_DISCONNECT;
         }
+
+        static MessageId getId() {
+            return MessageId::ForceDisconnect;
+        }
     };
 
     struct ConnectedDto {
@@ -274,25 +481,37 @@ namespace xpilot {
         std::string selcal;
         MSGPACK_DEFINE(callsign, selcal);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return CONNECTED;
         }
+
+        static MessageId getId() {
+            return MessageId::Connected;
+        }
     };
 
     struct DisconnectedDto {
         MSGPACK_DEFINE();
 
-        static std::string getName() {
+        static const std::string& getName() {
             return DISCONNECTED;
         }
+
+        static MessageId getId() {
+            return MessageId::Disconnected;
+        }
     };
 
     struct ShutdownDto {
         MSGPACK_DEFINE();
 
-        static std::string getName() {
+        static const std::string& getName() {
             return SHUTDOWN;
         }
+
+        static MessageId getId() {
+            return MessageId::Shutdown;
+        }
     };
 
     struct ComStationCallsign {
@@ -300,31 +519,120 @@ namespace xpilot {
         std::string callsign;
         MSGPACK_DEFINE(com, callsign);
 
-        static std::string getName() {
+        static const std::string& getName() {
             return STATION_CALLSIGN;
         }
+
+        static MessageId getId() {
+            return MessageId::StationCallsign;
+        }
+    };
+
+    // Sampled by the plugin once per flight loop and streamed to clients that advertise
+    // PROTOCOL_VERSION_USER_STATE. Values are in X-Plane's units, the same as the equivalent
+    // RREF datarefs, so the client can convert both the same way.
+    struct UserAircraftStateDto {
+        int64_t sampledAt; // steady clock microseconds
+        double latitude;
+        double longitude;
+        double elevation; // meters MSL
+        double altitudeAgl; // meters
+        double pressureAltitude; // feet
+        double barometerSeaLevel; // inHg
+        double pitch;
+        double heading;
+        double bank;
+        double localVx; // m/s, local OpenGL axes
+        double localVy;
+        double localVz;
+        double pitchRate; // rad/s (Q)
+        double headingRate; // rad/s (R)
+        double bankRate; // rad/s (P)
+        double groundSpeed; // m/s
+        double noseWheelAngle;
+        int engineCount;
+        uint8_t enginesRunning; // one bit per engine, first four engines only
+        uint8_t enginesReversing;
+        bool onGround;
+        bool gearDown;
+        double flapRatio;
+        double speedbrakeRatio;
+        bool beaconLightsOn;
+        bool landingLightsOn;
+        bool taxiLightsOn;
+        bool navLightsOn;
+        bool strobeLightsOn;
+        MSGPACK_DEFINE(sampledAt, latitude, longitude, elevation, altitudeAgl, pressureAltitude, barometerSeaLevel,
+            pitch, heading, bank, localVx, localVy, localVz, pitchRate, headingRate, bankRate, groundSpeed,
+            noseWheelAngle, engineCount, enginesRunning, enginesReversing, onGround, gearDown, flapRatio,
+            speedbrakeRatio, beaconLightsOn, landingLightsOn, taxiLightsOn, navLightsOn, strobeLightsOn);
+
+        static const std::string& getName() {
+            return USER_AIRCRAFT_STATE;
+        }
+
+        static MessageId getId() {
+            return MessageId::UserAircraftState;
+        }
     };
 
     // -------------------------------------------------------------
 
+    // Packs the envelope and the dto straight into dtoBuf, without building an intermediate
+    // msgpack::object or temp buffer. The bytes are identical to packing a BaseDto/CompactDto,
+    // followed by the stamp if one is given.
     template<class T>
-    static bool encodeDto(msgpack::sbuffer &dtoBuf, const T &dto)
+    static bool encodeDto(msgpack::sbuffer &dtoBuf, const T &dto, bool compact = false, const MessageStamp *stamp = nullptr)
     {
-        msgpack::zone z;
-        BaseDto base{dto.getName(),msgpack::object(dto, z)};
+        const size_t start = dtoBuf.size();
+        msgpack::packer<msgpack::sbuffer> packer(dtoBuf);
+        packer.pack_array(stamp ? 4 : 2);
 
-        // because we don't know the dto size in advance, pack it into it's own
-        // temp buffer, then copy it into the actual payload buffer.
-        msgpack::sbuffer dtoTempBuf;
-        msgpack::pack(dtoTempBuf, base);
-        if (dtoTempBuf.size() > UINT16_MAX) {
-            return false;
+        // the handshake always goes out by name, the peer may not know the compact ids yet
+        if (compact && dto.getId() != MessageId::PluginVersion) {
+            packer.pack_uint8(static_cast<uint8_t>(dto.getId()));
+        }
+        else {
+            packer.pack(dto.getName());
         }
+        packer.pack(dto);
 
-        dtoBuf.write(dtoTempBuf.data(), dtoTempBuf.size());
+        if (stamp) {
+            packer.pack_uint32(stamp->sequence);
+            packer.pack_int64(stamp->sentAt);
+        }
+
+        return dtoBuf.size() - start <= UINT16_MAX;
+    }
+
+    // Reads the header of either wire form (BaseDto or CompactDto) without allocating,
+    // returning MessageId::Unknown if the message isn't recognised.
+    inline MessageId decodeDto(const msgpack::object &obj, msgpack::object &payload, MessageStamp *stamp = nullptr)
+    {
+        if (obj.type != msgpack::type::ARRAY || obj.via.array.size < 2) {
+            return MessageId::Unknown;
+        }
+
+        const msgpack::object &header = obj.via.array.ptr[0];
+        payload = obj.via.array.ptr[1];
+
+        if (stamp) {
+            *stamp = {};
+            if (obj.via.array.size >= 4
+                && obj.via.array.ptr[2].type == msgpack::type::POSITIVE_INTEGER
+                && obj.via.array.ptr[3].type == msgpack::type::POSITIVE_INTEGER) {
+                stamp->sequence = static_cast<uint32_t>(obj.via.array.ptr[2].via.u64);
+                stamp->sentAt = static_cast<int64_t>(obj.via.array.ptr[3].via.u64);
+            }
+        }
 
-        assert(dtoBuf.size() == dtoTempBuf.size());
-        return true;
+        if (header.type == msgpack::type::POSITIVE_INTEGER) {
+            return header.via.u64 < static_cast<uint64_t>(MessageId::Count) ? static_cast<MessageId>(header.via.u64) : MessageId::Unknown;
+        }
+        if (header.type == msgpack::type::STR) {
+            return GetMessageId(std::string_view(header.via.str.ptr, header.via.str.size));
+        }
+        return MessageId::Unknown;
     }
 }
 
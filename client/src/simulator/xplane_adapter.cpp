@@ -14,11 +14,21 @@
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <cmath>
+#include <chrono>
 
 using namespace xpilot;
 
 constexpr int HEARTBEAT_TIMEOUT_SECS = 15;
 
+// keeps a single position frame comfortably below the UINT16_MAX limit enforced by encodeDto
+constexpr size_t MAX_POSITION_FRAME_UPDATES = 200;
+
+// RREF values for the user aircraft are ignored while the plugin streams its own snapshot
+constexpr qint64 USER_AIRCRAFT_STATE_TIMEOUT_MS = 1000;
+
+// a sample time further back than this can't come from a plugin sharing our steady clock
+constexpr int64_t MAX_USER_AIRCRAFT_STATE_AGE_US = 1000000;
+
 enum DataRef
 {
     AvionicsPower,
@@ -66,7 +76,7 @@ enum DataRef
     GearDown,
     FlapRatio,
     SpeedbrakeRatio,
-    NoseWheelAngle,
+    NoseWheelAngle, // BeaconLights to NoseWheelAngle are also streamed by the plugin
     ReplayMode,
     Paused,
     PushToTalk,
@@ -99,11 +109,14 @@ XplaneAdapter::XplaneAdapter(QObject* parent) : QObject(parent)
     const QList<QString> localhostAddresses = {"127.0.0.1","localhost"};
     if(AppConfig::getInstance()->XplaneNetworkAddress.isEmpty() || localhostAddresses.contains(AppConfig::getInstance()->XplaneNetworkAddress.toLower())) {
         nng_dial(m_socket, "ipc:///tmp//xpilot.ipc", NULL, NNG_FLAG_NONBLOCK);
+        m_sharedMemory = std::make_unique<SharedMemoryTransport>(SharedMemoryTransport::Role::Guest);
     } else {
         QString url = QString("tcp://%1:%2").arg(AppConfig::getInstance()->XplaneNetworkAddress).arg(AppConfig::getInstance()->XplanePluginPort);
         nng_dial(m_socket, url.toStdString().c_str(), NULL, NNG_FLAG_NONBLOCK);
     }
 
+    registerPacketHandlers();
+
     m_keepSocketAlive = true;
     m_socketThread = std::make_unique<std::thread>([&]{
         while (m_keepSocketAlive) {
@@ -115,22 +128,34 @@ XplaneAdapter::XplaneAdapter(QObject* parent) : QObject(parent)
 
             if(err == 0)
             {
-                BaseDto dto;
-                auto obj = msgpack::unpack(reinterpret_cast<const char*>(buffer), bufferLen);
-
-                try {
-                    obj.get().convert(dto);
-                    processPacket(dto);
-                }
-                catch(const msgpack::type_error&e) {
-                    qDebug() << e.what();
-                }
-
+                handleMessage(buffer, bufferLen);
                 nng_free(buffer, bufferLen);
             }
         }
     });
 
+    if(m_sharedMemory) {
+        // the plugin may be started after us or restarted, so keep trying to attach
+        m_sharedMemoryThread = std::make_unique<std::thread>([&]{
+            std::vector<char> buffer;
+            while (m_keepSocketAlive) {
+                if(!m_sharedMemory->IsOpen()) {
+                    if(!m_sharedMemory->Open()) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                    }
+                    continue;
+                }
+
+                if(m_sharedMemory->Receive(buffer, 250)) {
+                    handleMessage(buffer.data(), buffer.size());
+                }
+                else if(!m_sharedMemory->IsPeerAlive()) {
+                    m_sharedMemory->Close();
+                }
+            }
+        });
+    }
+
     for(const QString &machine : qAsConst(AppConfig::getInstance()->VisualMachines)) {
 
         nng_socket _visualSocket;
@@ -187,6 +212,12 @@ XplaneAdapter::XplaneAdapter(QObject* parent) : QObject(parent)
         emit radioStackStateChanged(m_radioStackState);
     });
     m_xplaneDataTimer.start(50);
+
+    // fires once control returns to the event loop, so every position update
+    // received during the current tick goes out in a single frame
+    m_positionFrameTimer.setSingleShot(true);
+    m_positionFrameTimer.setInterval(0);
+    connect(&m_positionFrameTimer, &QTimer::timeout, this, &XplaneAdapter::flushPositionFrame);
 }
 
 XplaneAdapter::~XplaneAdapter()
@@ -204,13 +235,40 @@ XplaneAdapter::~XplaneAdapter()
         m_socketThread->join();
         m_socketThread.reset();
     }
+
+    if(m_sharedMemoryThread) {
+        m_sharedMemory->Interrupt();
+        m_sharedMemoryThread->join();
+        m_sharedMemoryThread.reset();
+    }
+    m_sharedMemory.reset();
 }
 
-void XplaneAdapter::processPacket(const BaseDto &packet)
+void XplaneAdapter::handleMessage(const char *data, size_t size)
 {
-    if(packet.type == dto::PLUGIN_VER) {
+    // both the nng and the shared memory thread deliver here
+    std::lock_guard<std::mutex> lock(m_receiveMutex);
+
+    auto obj = msgpack::unpack(data, size);
+
+    try {
+        msgpack::object payload;
+        MessageId id = decodeDto(obj.get(), payload);
+        processPacket(id, payload);
+    }
+    catch(const msgpack::type_error&e) {
+        qDebug() << e.what();
+    }
+}
+
+void XplaneAdapter::registerPacketHandlers()
+{
+    m_packetHandlers[static_cast<size_t>(MessageId::PluginVersion)] = [this](const msgpack::object &packet) {
         PluginVersionDto dto{};
-        packet.dto.convert(dto);
+        packet.convert(dto);
+
+        m_compactMessages = dto.protocol >= PROTOCOL_VERSION_HANDLES;
+        m_positionFrames = dto.protocol >= PROTOCOL_VERSION_POSITION_FRAMES;
 
         if(dto.version < BuildConfig::getVersionInt())
         {
@@ -218,10 +276,24 @@ void XplaneAdapter::processPacket(const BaseDto &packet)
             emit invalidPluginVersion();
         }
         m_initialHandshake = true;
-    }
-    if(packet.type == dto::VALIDATE_CSL) {
+    };
+
+    m_packetHandlers[static_cast<size_t>(MessageId::UserAircraftState)] = [this](const msgpack::object &packet) {
+        UserAircraftStateDto dto{};
+        packet.convert(dto);
+
+        // the plugin's sample time is only usable if it runs on this machine and shares our clock
+        const int64_t now = getSteadyMicroseconds();
+        const int64_t sampledAt = (dto.sampledAt > 0 && dto.sampledAt <= now && now - dto.sampledAt < MAX_USER_AIRCRAFT_STATE_AGE_US) ? dto.sampledAt : now;
+
+        QMetaObject::invokeMethod(this, [this, dto, sampledAt] {
+            applyUserAircraftState(dto, sampledAt);
+        }, Qt::QueuedConnection);
+    };
+
+    m_packetHandlers[static_cast<size_t>(MessageId::ValidateCsl)] = [this](const msgpack::object &packet) {
         ValidateCslDto dto{};
-        packet.dto.convert(dto);
+        packet.convert(dto);
 
         if(!dto.isValid) {
             m_validCsl = false;
@@ -231,63 +303,80 @@ void XplaneAdapter::processPacket(const BaseDto &packet)
             }
         }
         m_initialHandshake = true;
-    }
-    if(packet.type == dto::AIRCRAFT_ADDED) {
+    };
+
+    m_packetHandlers[static_cast<size_t>(MessageId::AircraftAdded)] = [this](const msgpack::object &packet) {
         AircraftAddedDto dto{};
-        packet.dto.convert(dto);
+        packet.convert(dto);
         if(!dto.callsign.empty()) {
             emit aircraftAddedToSim(dto.callsign.c_str());
         }
-    }
-    if(packet.type == dto::AIRCRAFT_DELETED) {
+    };
+
+    m_packetHandlers[static_cast<size_t>(MessageId::AircraftDeleted)] = [this](const msgpack::object &packet) {
         AircraftAddedDto dto{};
-        packet.dto.convert(dto);
+        packet.convert(dto);
         if(!dto.callsign.empty()) {
             emit aircraftRemovedFromSim(dto.callsign.c_str());
         }
-    }
-    if(packet.type == dto::REQUEST_STATION_INFO) {
+    };
+
+    m_packetHandlers[static_cast<size_t>(MessageId::RequestStationInfo)] = [this](const msgpack::object &packet) {
         RequestStationInfoDto dto{};
-        packet.dto.convert(dto);
+        packet.convert(dto);
         if(!dto.station.empty()) {
             emit requestStationInfo(dto.station.c_str());
         }
-    }
-    if(packet.type == dto::REQUEST_METAR) {
+    };
+
+    m_packetHandlers[static_cast<size_t>(MessageId::RequestMetar)] = [this](const msgpack::object &packet) {
         RequestMetarDto dto;
-        packet.dto.convert(dto);
+        packet.convert(dto);
         if(!dto.station.empty()) {
             emit requestMetar(dto.station.c_str());
         }
-    }
-    if(packet.type == dto::RADIO_MESSAGE_SENT) {
+    };
+
+    m_packetHandlers[static_cast<size_t>(MessageId::RadioMessageSent)] = [this](const msgpack::object &packet) {
         RadioMessageSentDto dto;
-        packet.dto.convert(dto);
+        packet.convert(dto);
         if(!dto.message.empty()) {
             emit radioMessageSent(dto.message.c_str());
         }
-    }
-    if(packet.type == dto::PRIVATE_MESSAGE_SENT) {
+    };
+
+    m_packetHandlers[static_cast<size_t>(MessageId::PrivateMessageSent)] = [this](const msgpack::object &packet) {
         PrivateMessageSentDto dto;
-        packet.dto.convert(dto);
+        packet.convert(dto);
         if(!dto.to.empty() && !dto.message.empty()) {
             emit privateMessageSent(dto.to.c_str(), dto.message.c_str());
         }
-    }
-    if(packet.type == dto::WALLOP_SENT) {
+    };
+
+    m_packetHandlers[static_cast<size_t>(MessageId::WallopSent)] = [this](const msgpack::object &packet) {
         WallopSentDto dto;
-        packet.dto.convert(dto);
+        packet.convert(dto);
         if(!dto.message.empty()) {
             emit sendWallop(dto.message.c_str());
         }
-    }
-    if(packet.type == dto::FORCE_DISCONNECT) {
+    };
+
+    m_packetHandlers[static_cast<size_t>(MessageId::ForceDisconnect)] = [this](const msgpack::object &packet) {
         ForcedDisconnectDto dto;
-        packet.dto.convert(dto);
+        packet.convert(dto);
         emit forceDisconnect(dto.reason.c_str());
-    }
-    if(packet.type == dto::SHUTDOWN) {
+    };
+
+    m_packetHandlers[static_cast<size_t>(MessageId::Shutdown)] = [this](const msgpack::object &packet) {
         clearSimConnection();
+    };
+}
+
+void XplaneAdapter::processPacket(MessageId id, const msgpack::object &packet)
+{
+    const auto &handler = m_packetHandlers[static_cast<size_t>(id)];
+    if(handler) {
+        handler(packet);
     }
 }
 
@@ -295,6 +384,8 @@ void XplaneAdapter::clearSimConnection()
 {
     emit simConnectionStateChanged(false);
     m_initialHandshake = false;
+    m_compactMessages = false;
+    m_positionFrames = false;
     m_simConnected = false;
     m_subscribedDataRefs.clear();
 }
@@ -450,10 +541,19 @@ void XplaneAdapter::OnDataReceived()
         int num_structs = (buffer.size() - 5) / sizeof(rref_data_type);
         const rref_data_type *f = reinterpret_cast<const rref_data_type*>(buffer.constData() + 5);
 
+        const bool userAircraftStreamed = isUserAircraftStateStreaming();
+        if(!userAircraftStreamed) {
+            m_userAircraftData.SampledAt = 0; // RREF values carry no usable sample time
+        }
+
         for(int i = 0; i < num_structs; i++)
         {
             float value = f[i].val;
 
+            // RREF only delivers floats, so prefer the plugin's double precision snapshot
+            if(userAircraftStreamed && f[i].idx >= DataRef::BeaconLights && f[i].idx <= DataRef::NoseWheelAngle)
+                continue;
+
             switch(f[i].idx)
             {
                 case DataRef::AvionicsPower:
@@ -636,9 +736,59 @@ void XplaneAdapter::OnDataReceived()
     }
 }
 
+bool XplaneAdapter::isUserAircraftStateStreaming() const
+{
+    return QDateTime::currentMSecsSinceEpoch() - m_lastUserAircraftState < USER_AIRCRAFT_STATE_TIMEOUT_MS;
+}
+
+void XplaneAdapter::applyUserAircraftState(const UserAircraftStateDto &dto, int64_t sampledAt)
+{
+    m_lastUserAircraftState = QDateTime::currentMSecsSinceEpoch();
+
+    // same conversions as the RREF path in OnDataReceived
+    m_userAircraftData.Latitude = dto.latitude;
+    m_userAircraftData.Longitude = dto.longitude;
+    m_userAircraftData.AltitudeMslM = dto.elevation;
+    m_userAircraftData.AltitudeAglM = dto.altitudeAgl;
+    m_userAircraftData.AltitudePressure = dto.pressureAltitude;
+    m_userAircraftData.BarometerSeaLevel = dto.barometerSeaLevel * 33.8639; // inHg to millibar
+    m_userAircraftData.Pitch = dto.pitch;
+    m_userAircraftData.Heading = dto.heading;
+    m_userAircraftData.Bank = dto.bank;
+    m_userAircraftData.LatitudeVelocity = dto.localVz * -1.0;
+    m_userAircraftData.AltitudeVelocity = dto.localVy;
+    m_userAircraftData.LongitudeVelocity = dto.localVx;
+    m_userAircraftData.PitchVelocity = dto.pitchRate * -1.0;
+    m_userAircraftData.HeadingVelocity = dto.headingRate;
+    m_userAircraftData.BankVelocity = dto.bankRate * -1.0;
+    m_userAircraftData.GroundSpeed = dto.groundSpeed * 1.94384; // mps -> knots
+    m_userAircraftData.NoseWheelAngle = dto.noseWheelAngle;
+    m_userAircraftData.SampledAt = sampledAt;
+
+    m_userAircraftConfigData.BeaconOn = dto.beaconLightsOn;
+    m_userAircraftConfigData.LandingLightsOn = dto.landingLightsOn;
+    m_userAircraftConfigData.TaxiLightsOn = dto.taxiLightsOn;
+    m_userAircraftConfigData.NavLightsOn = dto.navLightsOn;
+    m_userAircraftConfigData.StrobesOn = dto.strobeLightsOn;
+    m_userAircraftConfigData.EngineCount = dto.engineCount;
+    m_userAircraftConfigData.Engine1Running = dto.enginesRunning & 0x1;
+    m_userAircraftConfigData.Engine2Running = dto.enginesRunning & 0x2;
+    m_userAircraftConfigData.Engine3Running = dto.enginesRunning & 0x4;
+    m_userAircraftConfigData.Engine4Running = dto.enginesRunning & 0x8;
+    m_userAircraftConfigData.Engine1Reversing = dto.enginesReversing & 0x1;
+    m_userAircraftConfigData.Engine2Reversing = dto.enginesReversing & 0x2;
+    m_userAircraftConfigData.Engine3Reversing = dto.enginesReversing & 0x4;
+    m_userAircraftConfigData.Engine4Reversing = dto.enginesReversing & 0x8;
+    m_userAircraftConfigData.OnGround = dto.onGround;
+    m_userAircraftConfigData.GearDown = dto.gearDown;
+    m_userAircraftConfigData.FlapsRatio = dto.flapRatio;
+    m_userAircraftConfigData.SpeedbrakeRatio = dto.speedbrakeRatio;
+}
+
 void XplaneAdapter::requestPluginVersion()
 {
     PluginVersionDto dto{};
+    dto.protocol = PROTOCOL_VERSION;
     SendDto(dto);
 }
 
@@ -731,6 +881,7 @@ void XplaneAdapter::AddAircraftToSimulator(const NetworkAircraft &aircraft)
 {
     AddAircraftDto dto{};
     dto.callsign = aircraft.Callsign.toStdString();
+    dto.handle = acquireAircraftHandle(aircraft.Callsign);
     dto.airline = aircraft.Airline.toStdString();
     dto.typeCode = aircraft.TypeCode.toStdString();
     dto.latitude = aircraft.RemoteVisualState.Latitude;
@@ -745,7 +896,7 @@ void XplaneAdapter::AddAircraftToSimulator(const NetworkAircraft &aircraft)
 void XplaneAdapter::PlaneConfigChanged(const NetworkAircraft &aircraft)
 {
     AircraftConfigDto dto{};
-    dto.callsign = aircraft.Callsign.toStdString();
+    setAircraftIdentity(dto, aircraft.Callsign);
 
     if(!aircraft.Configuration->IsIncremental())
     {
@@ -813,16 +964,27 @@ void XplaneAdapter::PlaneConfigChanged(const NetworkAircraft &aircraft)
 
 void XplaneAdapter::DeleteAircraft(const NetworkAircraft &aircraft, QString reason)
 {
+    flushPositionFrame();
+
     DeleteAircraftDto dto{};
     dto.callsign = aircraft.Callsign.toStdString();
+    dto.handle = m_aircraftHandles.value(aircraft.Callsign, 0);
     dto.reason = reason.toStdString();
     SendDto(dto);
+
+    releaseAircraftHandle(aircraft.Callsign);
 }
 
 void XplaneAdapter::DeleteAllAircraft()
 {
+    m_pendingPositionFrame.updates.clear();
+
     DeleteAllAircraftDto dto{};
     SendDto(dto);
+
+    m_aircraftHandles.clear();
+    m_freeAircraftHandles.clear();
+    m_nextAircraftHandle = 1;
 }
 
 void XplaneAdapter::UpdateControllers(QList<Controller> &controllers)
@@ -849,10 +1011,10 @@ void XplaneAdapter::DeleteAllControllers()
     SendDto(dto);
 }
 
-void XplaneAdapter::SendFastPositionUpdate(const NetworkAircraft &aircraft, const AircraftVisualState &visualState, const VelocityVector &positionalVelocityVector, const VelocityVector &rotationalVelocityVector)
+void XplaneAdapter::SendFastPositionUpdate(const NetworkAircraft &aircraft, const AircraftVisualState &visualState, const VelocityVector &positionalVelocityVector, const VelocityVector &rotationalVelocityVector, int64_t receivedAt)
 {
     FastPositionUpdateDto dto{};
-    dto.callsign = aircraft.Callsign.toStdString();
+    setAircraftIdentity(dto, aircraft.Callsign);
     dto.latitude = visualState.Latitude;
     dto.longitude = visualState.Longitude;
     dto.altitudeTrue = visualState.Altitude;
@@ -869,13 +1031,68 @@ void XplaneAdapter::SendFastPositionUpdate(const NetworkAircraft &aircraft, cons
     dto.noseWheelAngle = visualState.NoseWheelAngle;
     dto.speed = aircraft.Speed;
 
-    SendDto(dto);
+    // plugins from before position frames only understand the individual update
+    if(!m_positionFrames) {
+        SendDto(dto, receivedAt);
+        return;
+    }
+
+    if(m_pendingPositionFrame.updates.empty()) {
+        m_pendingPositionFrameSince = receivedAt > 0 ? receivedAt : getSteadyMicroseconds();
+    }
+    m_pendingPositionFrame.updates.push_back(std::move(dto));
+
+    if(m_pendingPositionFrame.updates.size() >= MAX_POSITION_FRAME_UPDATES) {
+        flushPositionFrame();
+    } else if(!m_positionFrameTimer.isActive()) {
+        m_positionFrameTimer.start();
+    }
+}
+
+uint32_t XplaneAdapter::acquireAircraftHandle(const QString &callsign)
+{
+    auto it = m_aircraftHandles.constFind(callsign);
+    if(it != m_aircraftHandles.constEnd()) {
+        return it.value(); // re-added after the plugin dropped it, keep the same handle
+    }
+
+    // recycle the longest-released handle first, so a late message for the previous
+    // owner is unlikely to land on the new one
+    if(m_freeAircraftHandles.isEmpty() && m_nextAircraftHandle >= MAX_AIRCRAFT_HANDLES) {
+        return 0; // out of handles, this aircraft is addressed by callsign
+    }
+
+    uint32_t handle = m_freeAircraftHandles.isEmpty() ? m_nextAircraftHandle++ : m_freeAircraftHandles.dequeue();
+    m_aircraftHandles.insert(callsign, handle);
+    return handle;
+}
+
+void XplaneAdapter::releaseAircraftHandle(const QString &callsign)
+{
+    auto it = m_aircraftHandles.find(callsign);
+    if(it != m_aircraftHandles.end()) {
+        m_freeAircraftHandles.enqueue(it.value());
+        m_aircraftHandles.erase(it);
+    }
+}
+
+void XplaneAdapter::flushPositionFrame()
+{
+    m_positionFrameTimer.stop();
+
+    if(m_pendingPositionFrame.updates.empty())
+        return;
+
+    // stamped with the time the oldest update was received from FSD, so the plugin's latency
+    // covers the client's handling and batching too
+    SendDto(m_pendingPositionFrame, m_pendingPositionFrameSince);
+    m_pendingPositionFrame.updates.clear();
 }
 
 void XplaneAdapter::SendHeartbeat(const QString callsign)
 {
     HeartbeatDto dto{};
-    dto.callsign = callsign.toStdString();
+    setAircraftIdentity(dto, callsign);
 
     SendDto(dto);
 }
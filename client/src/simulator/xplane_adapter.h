@@ -11,6 +11,8 @@
 #include <vector>
 #include <thread>
 #include <deque>
+#include <array>
+#include <atomic>
 
 #include <QObject>
 #include <QUdpSocket>
@@ -21,6 +23,8 @@
 #include <QTextStream>
 #include <QMutex>
 #include <QTimer>
+#include <QHash>
+#include <QQueue>
 
 #include <msgpack.hpp>
 
@@ -34,6 +38,7 @@
 #include "src/aircrafts/user_aircraft_config_data.h"
 #include "src/aircrafts/radio_stack_state.h"
 #include "src/controllers/controller.h"
+#include "SharedMemoryTransport.h"
 #include "src/simulator/dto.h"
 
 using namespace xpilot;
@@ -66,7 +71,7 @@ public:
     void DeleteAllAircraft();
     void UpdateControllers(QList<Controller>& controllers);
     void DeleteAllControllers();
-    void SendFastPositionUpdate(const NetworkAircraft& aircraft, const AircraftVisualState& visualState, const VelocityVector& positionalVelocityVector, const VelocityVector& rotationalVelocityVector);
+    void SendFastPositionUpdate(const NetworkAircraft& aircraft, const AircraftVisualState& visualState, const VelocityVector& positionalVelocityVector, const VelocityVector& rotationalVelocityVector, int64_t receivedAt);
     void SendHeartbeat(const QString callsign);
     void SendRadioMessage(const QString message);
     void RadioMessageReceived(const QString from, const QString message, bool isDirect);
@@ -87,12 +92,32 @@ private:
     void sendCommand(std::string command);
 
     void processMessage(QString message);
-    void processPacket(const BaseDto& packet);
+    void registerPacketHandlers();
+    void processPacket(MessageId id, const msgpack::object& packet);
+    void handleMessage(const char *data, size_t size);
     void clearSimConnection();
 
     void requestPluginVersion();
     void validateCsl();
 
+    bool isUserAircraftStateStreaming() const;
+    void applyUserAircraftState(const UserAircraftStateDto& dto, int64_t sampledAt);
+
+    void flushPositionFrame();
+
+    uint32_t acquireAircraftHandle(const QString& callsign);
+    void releaseAircraftHandle(const QString& callsign);
+
+    // once the plugin understands handles, aircraft messages carry only the handle
+    template<class T>
+    void setAircraftIdentity(T& dto, const QString& callsign)
+    {
+        dto.handle = m_compactMessages ? m_aircraftHandles.value(callsign, 0) : 0;
+        if(dto.handle == 0) {
+            dto.callsign = callsign.toStdString();
+        }
+    }
+
 public slots:
     void OnDataReceived();
 
@@ -126,18 +151,28 @@ private:
     qint64 m_lastUdpTimestamp;
     bool m_simConnected = false;
     bool m_initialHandshake = false;
+    std::atomic_bool m_compactMessages{false};
+    std::atomic_bool m_positionFrames{false};
     bool m_validPluginVersion = true;
     bool m_cslValidated = false;
     bool m_validCsl = true;
     bool m_simPaused = false;
 
     UserAircraftData m_userAircraftData{};
+    qint64 m_lastUserAircraftState = 0; // msecs since epoch of the last streamed snapshot
     UserAircraftConfigData m_userAircraftConfigData{};
     RadioStackState m_radioStackState{};
 
     QList<QString> m_ignoreList;
     QTimer m_heartbeatTimer;
     QTimer m_xplaneDataTimer;
+    QTimer m_positionFrameTimer;
+    PositionFrameDto m_pendingPositionFrame{};
+    int64_t m_pendingPositionFrameSince = 0; // when the oldest update in the frame was received from FSD
+
+    QHash<QString, uint32_t> m_aircraftHandles;
+    QQueue<uint32_t> m_freeAircraftHandles;
+    uint32_t m_nextAircraftHandle = 1;
 
     QList<QString> m_subscribedDataRefs;
 
@@ -155,20 +190,37 @@ private:
     nng_socket m_socket;
     QList<nng_socket> m_visualSockets;
 
+    // local plugin only; preferred over nng for the main socket while the plugin is attached
+    std::unique_ptr<SharedMemoryTransport> m_sharedMemory;
+    std::unique_ptr<std::thread> m_sharedMemoryThread;
+    std::mutex m_receiveMutex;
+
+    typedef std::function<void(const msgpack::object&)> PacketHandler;
+    std::array<PacketHandler, static_cast<size_t>(MessageId::Count)> m_packetHandlers;
+
+    // counted per message type, so the plugin can tell which kind of message was dropped
+    std::array<std::atomic<uint32_t>, static_cast<size_t>(MessageId::Count)> m_sendSequence{};
+
+    // sentAt is when the message's data was received from the network, if it was held back
     template<class T>
-    void SendDto(const T& dto)
+    void SendDto(const T& dto, int64_t sentAt = 0)
     {
-        msgpack::sbuffer dtoBuf;
-        if (encodeDto(dtoBuf, dto))
-        {
-            if (dtoBuf.size() == 0)
-                return;
+        // reused by every send on this thread, so encoding doesn't allocate once it has grown
+        thread_local msgpack::sbuffer dtoBuf;
+        dtoBuf.clear();
+
+        MessageStamp stamp;
+        stamp.sequence = ++m_sendSequence[static_cast<size_t>(dto.getId())];
+        stamp.sentAt = sentAt > 0 ? sentAt : getSteadyMicroseconds();
 
-            std::vector<unsigned char> dgBuffer(dtoBuf.data(), dtoBuf.data() + dtoBuf.size());
-            nng_send(m_socket, reinterpret_cast<char*>(dgBuffer.data()), dgBuffer.size(), NNG_FLAG_NONBLOCK);
+        if (encodeDto(dtoBuf, dto, m_compactMessages, &stamp))
+        {
+            if(!m_sharedMemory || !m_sharedMemory->Send(dtoBuf.data(), dtoBuf.size())) {
+                nng_send(m_socket, dtoBuf.data(), dtoBuf.size(), NNG_FLAG_NONBLOCK);
+            }
 
             for(auto &visualSocket : m_visualSockets) {
-                nng_send(visualSocket, reinterpret_cast<char*>(dgBuffer.data()), dgBuffer.size(), NNG_FLAG_NONBLOCK);
+                nng_send(visualSocket, dtoBuf.data(), dtoBuf.size(), NNG_FLAG_NONBLOCK);
             }
         }
     }
@@ -247,6 +247,9 @@ protected:
     
     /// X-Plane instance handles for all objects making up the model
     std::list<XPLMInstanceRef> listInst;
+    /// `drawInfo` and `v` as last passed to the instances, so DoMove() can skip aircraft that haven't changed
+    XPLMDrawInfo_t      drawInfoInst;
+    std::vector<float>  vInst;
     /// Which `sim/cockpit2/tcas/targets`-index does this plane occupy? [1..63], `-1` if none
     int                 tcasTargetIdx = -1;
     
@@ -269,6 +272,7 @@ protected:
     
 private:
     bool bDestroyInst           = false;    ///< Instance to be destroyed in next flight loop callback?
+    size_t denseIdx             = SIZE_MAX; ///< position in the dense index `glob.acIdx`, `SIZE_MAX` if not listed there
 public:
     /// @brief Constructor creates a new aircraft object, which will be managed and displayed
     /// @exception XPMP2::XPMP2Error Mode S id invalid or duplicate, no model found during model matching
@@ -570,6 +574,8 @@ protected:
     friend void AIMultiUpdate ();
     friend size_t AIUpdateTCASTargets ();
     friend size_t AIUpdateMultiplayerDataRefs ();
+    // Maintains `denseIdx`
+    friend class AcDenseIdxTy;
 };
 
 /// Find aircraft by its plane ID, can return nullptr
@@ -699,6 +699,11 @@ bool XPMPDrawingAircraftLabels();
 /// @param _bCutOffAtVisibility Shall labels not be drawn further away than XP's reported visibility?
 void XPMPSetAircraftLabelDist (float _dist_nm, bool _bCutOffAtVisibility = true);
 
+/// @brief Configure the maximum number of labels drawn per frame
+/// @details If more aircraft qualify for a label, only the closest ones get one.
+/// @param _maxLabels Maximum number of labels, default is 100, `0` for no limit
+void XPMPSetAircraftLabelMax (int _maxLabels);
+
 //
 // MARK: MAP
 //       Enable or disable the drawing of icons on maps
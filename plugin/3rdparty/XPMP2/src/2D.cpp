@@ -45,18 +45,20 @@ static XPLMDataRef drFieldOfView    = nullptr;  ///< sim/graphics/view/field_of_
 static float gMatrixWrld[16];
 /// projection matrix (updated once per cycle)
 static float gMatrixProj[16];
+/// projection times world matrix, so that a position needs just one transformation (updated once per cycle)
+static float gMatrixWrldProj[16];
 /// Screen size (with, height)
 static float gScreenW, gScreenH;
 /// Field of view
 static float gFOV;
 
-/// 4x4 matrix transform of an XYZW coordinate - this matches OpenGL matrix conventions.
-static void mult_matrix_vec(float dst[4], const float m[16], const float v[4])
+/// 4x4 matrix product `dst = a * b` - this matches OpenGL matrix conventions.
+static void mult_matrix_matrix(float dst[16], const float a[16], const float b[16])
 {
-    dst[0] = v[0] * m[0] + v[1] * m[4] + v[2] * m[8] + v[3] * m[12];
-    dst[1] = v[0] * m[1] + v[1] * m[5] + v[2] * m[9] + v[3] * m[13];
-    dst[2] = v[0] * m[2] + v[1] * m[6] + v[2] * m[10] + v[3] * m[14];
-    dst[3] = v[0] * m[3] + v[1] * m[7] + v[2] * m[11] + v[3] * m[15];
+    for (int col = 0; col < 4; ++col)
+        for (int row = 0; row < 4; ++row)
+            dst[col*4+row] = a[row]    * b[col*4]   + a[4+row]  * b[col*4+1] +
+                             a[8+row]  * b[col*4+2] + a[12+row] * b[col*4+3];
 }
 
 
@@ -66,6 +68,7 @@ static void read_matrices ()
     // Read the model view and projection matrices from this frame
     XPLMGetDatavf(drMatrixWrld,gMatrixWrld,0,16);
     XPLMGetDatavf(drMatrixProj,gMatrixProj,0,16);
+    mult_matrix_matrix(gMatrixWrldProj, gMatrixProj, gMatrixWrld);
     
     // Read the screen size (won't change often if at all...but could!)
     gScreenW = (float)XPLMGetDatai(drScreenWidth);
@@ -75,37 +78,53 @@ static void read_matrices ()
     gFOV = XPLMGetDataf(drFieldOfView);
 }
 
-// This drawing callback will draw a label to the screen where the
-
-/// @brief Converts 3D local coordinates to 2D screen coordinates
+/// @brief Label candidates of the current frame, in structure-of-arrays form for the projection pass
+/// @details Kept from frame to frame, so that after the first frames no allocations are needed
+struct LabelCandidatesTy {
+    std::vector<size_t> vecIdx;         ///< index into `glob.acIdx`
+    std::vector<float>  vecX;           ///< local coordinates of the label's anchor
+    std::vector<float>  vecY;
+    std::vector<float>  vecZ;
+    std::vector<float>  vecClipX;       ///< clip coordinates of the label's anchor
+    std::vector<float>  vecClipY;
+    std::vector<float>  vecClipZ;
+    std::vector<float>  vecClipW;
+};
+static LabelCandidatesTy gLblCand;
+
+/// A label that survived culling and is to be drawn
+struct LabelTy {
+    size_t  idx;                        ///< index into `glob.acIdx`
+    float   camDist;                    ///< [m] distance to camera
+    int     x, y;                       ///< screen coordinates
+};
+static std::vector<LabelTy> gLabels;
+
+/// @brief Simulates the OpenGL transformation of all label candidates to clip coordinates in one go
+/// @details A branch-free loop over contiguous arrays, which the compiler vectorises
 /// @note Requires matrices to be set up already by a call to read_matrices()
-/// @return Are coordinates visible? (Otherwise they are "in the back" of the camera)
-static bool ConvertTo2d(const float x, const float y, const float z,
-                        int& out_x, int& out_y)
+static void ProjectLabelCandidates ()
 {
-    // the position to convert
-    const float afPos[4] = { x, y, z, 1.0f };
-    float afEye[4], afNdc[4];
-    
-    // Simulate the OpenGL transformation to get screen coordinates.
-    mult_matrix_vec(afEye, gMatrixWrld, afPos);
-    mult_matrix_vec(afNdc, gMatrixProj, afEye);
-    
-    afNdc[3] = 1.0f / afNdc[3];
-    afNdc[0] *= afNdc[3];
-    afNdc[1] *= afNdc[3];
-    afNdc[2] *= afNdc[3];
-    
-    out_x = (int)std::lround(gScreenW * (afNdc[0] * 0.5f + 0.5f));
-    out_y = (int)std::lround(gScreenH * (afNdc[1] * 0.5f + 0.5f));
+    const size_t n = gLblCand.vecIdx.size();
+    gLblCand.vecClipX.resize(n);
+    gLblCand.vecClipY.resize(n);
+    gLblCand.vecClipZ.resize(n);
+    gLblCand.vecClipW.resize(n);
     
-    // afNdc[2] is basically the Z value
-    if (glob.UsingModernGraphicsDriver())
-        // Vulkan z-axis NDC is [0,1]
-        return 0.0f <= afNdc[2] && afNdc[2] <= 1.0f;
-    else
-        // OGL z-axis is [-1,1]
-        return -1.0f <= afNdc[2] && afNdc[2] <= 1.0;
+    const float* m = gMatrixWrldProj;
+    const float* px = gLblCand.vecX.data();
+    const float* py = gLblCand.vecY.data();
+    const float* pz = gLblCand.vecZ.data();
+    float* cx = gLblCand.vecClipX.data();
+    float* cy = gLblCand.vecClipY.data();
+    float* cz = gLblCand.vecClipZ.data();
+    float* cw = gLblCand.vecClipW.data();
+    for (size_t i = 0; i < n; ++i) {
+        cx[i] = px[i] * m[0] + py[i] * m[4] + pz[i] * m[8]  + m[12];
+        cy[i] = px[i] * m[1] + py[i] * m[5] + pz[i] * m[9]  + m[13];
+        cz[i] = px[i] * m[2] + py[i] * m[6] + pz[i] * m[10] + m[14];
+        cw[i] = px[i] * m[3] + py[i] * m[7] + pz[i] * m[11] + m[15];
+    }
 }
 
 //
@@ -113,6 +132,9 @@ static bool ConvertTo2d(const float x, const float y, const float z,
 //
 
 /// @brief Write the labels of all aircraft
+/// @details Candidates are culled by distance first, then projected in one pass and culled
+///          against the view frustum. If more labels remain than `glob.maxLabels`,
+///          only the closest ones are drawn.
 /// @see This code bases on the last part of `XPMPDefaultPlaneRenderer` of the original libxplanemp
 /// @author Ben Supnik, Chris Serio, Chris Collins, Birger Hoppe
 void TwoDDrawLabels ()
@@ -132,18 +154,23 @@ void TwoDDrawLabels ()
                                          (glob.bLabelCutOffAtVisibility && drVisibility) ? XPLMGetDataf(drVisibility) : glob.maxLabelDist)
                                 * posCamera.zoom);    // Labels get easier to see when users zooms.
     
-    // Loop over all aircraft and draw their labels
-    for (auto& p: glob.mapAc)
+    // 1. Collect the candidates: rendered aircraft with labels within distance
+    gLblCand.vecIdx.clear();
+    gLblCand.vecX.clear();
+    gLblCand.vecY.clear();
+    gLblCand.vecZ.clear();
+    for (size_t i = 0; i < glob.acIdx.size(); ++i)
     {
-        Aircraft& ac = *p.second;
+        // Skip if aircraft is farther away from camera than we would draw labels for,
+        // tested on the dense index first, so distant aircraft aren't even touched
+        if (glob.acIdx.vecCamDist[i] > maxLabelDist)
+            continue;
+
+        Aircraft& ac = *glob.acIdx.vecAc[i];
         try {
             // skip if a/c is not rendered or label not to be drawn
             if (!ac.IsRendered() || !ac.ShallDrawLabel())
                 continue;
-        
-            // Exit if aircraft is father away from camera than we would draw labels for
-            if (ac.GetCameraDist() > maxLabelDist)
-                continue;
             
             // Vertical label offset: Idea is to place the label _above_ the plane
             // (as opposed to across), but finding the exact height of the plane
@@ -158,21 +185,65 @@ void TwoDDrawLabels ()
                     case 'H': vertLabelOfs = 8.0f; break;
                 }
             }
+            
+            const XPLMDrawInfo_t& drawPos = glob.acIdx.vecDrawPos[i];
+            gLblCand.vecIdx.push_back(i);
+            gLblCand.vecX.push_back(drawPos.x);
+            gLblCand.vecY.push_back(drawPos.y + vertLabelOfs);     // make the label appear above the plane
+            gLblCand.vecZ.push_back(drawPos.z);
+        }
+        CATCH_AC(ac)
+    }
+    
+    // 2. Map the 3D coordinates of all candidates to 2D coordinates of the flat screen
+    ProjectLabelCandidates();
+    
+    // 3. Cull what's not visible
+    // Vulkan z-axis NDC is [0,1], OGL z-axis is [-1,1]
+    const float zMin = glob.UsingModernGraphicsDriver() ? 0.0f : -1.0f;
+    // Text extends to the right of and above its anchor
+    int charW = 0, charH = 0;
+    XPLMGetFontDimensions(xplmFont_Basic, &charW, &charH, nullptr);
+    gLabels.clear();
+    for (size_t c = 0; c < gLblCand.vecIdx.size(); ++c)
+    {
+        const float w = gLblCand.vecClipW[c];
+        if (w <= 0.0f)                                      // behind the camera
+            continue;
+        const float z = gLblCand.vecClipZ[c];
+        if (z < zMin * w || z > w)                          // before near or beyond far plane
+            continue;
         
-            // Map the 3D coordinates of the aircraft to 2D coordinates of the flat screen
-            int x = -1, y = -1;
-            if (!ConvertTo2d(ac.drawInfo.x,
-                             ac.drawInfo.y + vertLabelOfs,  // make the label appear above the plane
-                             ac.drawInfo.z, x, y))
-                continue;                           // label not visible
-
+        const int x = (int)std::lround(gScreenW * (gLblCand.vecClipX[c] / w * 0.5f + 0.5f));
+        const int y = (int)std::lround(gScreenH * (gLblCand.vecClipY[c] / w * 0.5f + 0.5f));
+        if (x > (int)gScreenW || y > (int)gScreenH || y < -charH)
+            continue;
+        const size_t i = gLblCand.vecIdx[c];
+        if (x < 0 && x + charW * (int)glob.acIdx.vecAc[i]->label.size() < 0)
+            continue;
+        
+        gLabels.push_back({ i, glob.acIdx.vecCamDist[i], x, y });
+    }
+    
+    // 4. Too many? Then only the closest ones are drawn
+    if (glob.maxLabels > 0 && gLabels.size() > (size_t)glob.maxLabels) {
+        std::nth_element(gLabels.begin(), gLabels.begin() + glob.maxLabels, gLabels.end(),
+                         [](const LabelTy& a, const LabelTy& b){ return a.camDist < b.camDist; });
+        gLabels.resize((size_t)glob.maxLabels);
+    }
+    
+    // 5. Draw the labels
+    for (const LabelTy& lbl: gLabels)
+    {
+        Aircraft& ac = *glob.acIdx.vecAc[lbl.idx];
+        try {
             // Determine text color:
             // It stays as defined by application for half the way to maxLabelDist.
             // For the other half, it gradually fades to gray.
             // `rat` determines how much it faded already (factor from 0..1)
             const float rat =
-            ac.GetCameraDist() < maxLabelDist*0.8f ? 0.0f :                 // first 80%: no fading
-            (ac.GetCameraDist() - maxLabelDist*0.8f) / (maxLabelDist*0.2f); // last  20%: fade to gray (remember: acDist <= maxLabelDist!)
+            lbl.camDist < maxLabelDist*0.8f ? 0.0f :                        // first 80%: no fading
+            (lbl.camDist - maxLabelDist*0.8f) / (maxLabelDist*0.2f);        // last  20%: fade to gray (remember: acDist <= maxLabelDist!)
             constexpr float gray[4] = {0.6f, 0.6f, 0.6f, 1.0f};
             float c[4] = {
                 (1.0f-rat) * ac.colLabel[0] + rat * gray[0],     // red
@@ -182,7 +253,7 @@ void TwoDDrawLabels ()
             };
         
             // Finally: Draw the label
-            XPLMDrawString(c, x, y, (char*)ac.label.c_str(), NULL, xplmFont_Basic);
+            XPLMDrawString(c, lbl.x, lbl.y, (char*)ac.label.c_str(), NULL, xplmFont_Basic);
         }
         CATCH_AC(ac)
     }
@@ -290,3 +361,9 @@ void XPMPSetAircraftLabelDist (float _dist_nm, bool _bCutOffAtVisibility)
     glob.maxLabelDist = std::max(_dist_nm,1.0f) * M_per_NM; // store in meter
 }
 
+// Configure the maximum number of labels drawn per frame
+void XPMPSetAircraftLabelMax (int _maxLabels)
+{
+    glob.maxLabels = std::max(_maxLabels, 0);
+}
+
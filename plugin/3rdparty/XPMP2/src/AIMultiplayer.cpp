@@ -31,6 +31,7 @@
 ///             THE SOFTWARE.
 
 #include "XPMP2.h"
+#include "TcasTargets.h"
 
 #define INFO_AI_CONTROL         "Have control now over AI/Multiplayer planes"
 #define INFO_AI_CONTROL_ENDS    "Released control of AI/Multiplayer planes"
@@ -195,10 +196,10 @@ static std::vector<multiDataRefsTy> gMultiRef;
 /// Keeps the dataRef handles for one of the up to 63 shared data slots ("sim/multiplayer/position/plane#...")
 static std::vector<infoDataRefsTy>  gInfoRef;
 
-/// Map of Aircrafts, sorted by (priority-biased) distance
-typedef std::map<float,XPMPPlaneID> mapAcByDistTy;
-/// Map of Aircrafts, sorted by (priority-biased) distance
-static mapAcByDistTy gMapAcByDist;
+/// Aircraft to show as AI planes, the closest `numSlots` of them first and sorted by (priority-biased) distance
+static std::vector<acByDistTy> gAcByDist;
+/// Number of aircraft when `gAcByDist` was last sorted
+static size_t gNumAcSorted = 0;
 /// Vector of actual (verified) aircraft, ordered by distance
 static std::vector<Aircraft*> vAcByDist;
 
@@ -211,6 +212,36 @@ static float tLastSlotSwitching = 0.0f;
 // How many planes did we produce last cycle?
 static size_t numTargetsLastTime = 0;
 
+// Arrays we need every frame over and over again, so we keep them static for performance
+// data arrays for providing TCAS target values
+static TcasArrayTy<int>   vModeS;
+static TcasArrayTy<int>   vModeC;
+static TcasArrayTy<float> vX;
+static TcasArrayTy<float> vY;
+static TcasArrayTy<float> vZ;
+static TcasArrayTy<float> vVertSpeed;
+static TcasArrayTy<float> vHeading;
+static TcasArrayTy<float> vPitch;
+static TcasArrayTy<float> vRoll;
+static TcasArrayTy<float> vGear;
+static TcasArrayTy<float> vFlap;
+static TcasArrayTy<float> vFlap2;
+static TcasArrayTy<float> vSpeedbrake;
+static TcasArrayTy<float> vSlat;
+static TcasArrayTy<float> vWingSweep;
+static TcasArrayTy<float> vThrottle;
+static TcasArrayTy<float> vYokePitch;
+static TcasArrayTy<float> vYokeRoll;
+static TcasArrayTy<float> vYokeYaw;
+static TcasArrayTy<int>   vLights;
+static TcasArrayTy<int>   vWeightOnWheels;
+static TcasArrayTy<float> vWakeWingSpan;
+static TcasArrayTy<float> vWakeWingArea;
+static TcasArrayTy<int>   vWakeCat;
+static TcasArrayTy<float> vWakeMass;
+static TcasArrayTy<float> vWakeAoA;
+static TcasArrayTy<float> vWakeLift;
+
 //
 // MARK: Aircraft functions related to TCAS
 //
@@ -346,35 +377,6 @@ size_t AIUpdateMultiplayerDataRefs()
 /// @return Number of TCAS targets produced (incl. user's plane)
 size_t AIUpdateTCASTargets ()
 {
-    // Arrays we need every frame over and over again, so we keep them static for performance
-    // data arrays for providing TCAS target values
-    static std::vector<int>   vModeS;      
-    static std::vector<int>   vModeC;      
-    static std::vector<float> vX;          
-    static std::vector<float> vY;          
-    static std::vector<float> vZ;          
-    static std::vector<float> vVertSpeed;  
-    static std::vector<float> vHeading;    
-    static std::vector<float> vPitch;      
-    static std::vector<float> vRoll;       
-    static std::vector<float> vGear;       
-    static std::vector<float> vFlap;       
-    static std::vector<float> vSpeedbrake; 
-    static std::vector<float> vSlat;       
-    static std::vector<float> vWingSweep;  
-    static std::vector<float> vThrottle;   
-    static std::vector<float> vYokePitch;  
-    static std::vector<float> vYokeRoll;   
-    static std::vector<float> vYokeYaw;    
-    static std::vector<int>   vLights;  
-    static std::vector<int>   vWeightOnWheels;
-    static std::vector<float> vWakeWingSpan;
-    static std::vector<float> vWakeWingArea;
-    static std::vector<int>   vWakeCat;
-    static std::vector<float> vWakeMass;
-    static std::vector<float> vWakeAoA;
-    static std::vector<float> vWakeLift;
-
     // Start filling up TCAS targets, ordered by distance,
     // so that the closest planes are in the lower slots,
     // mirrored to the legacy multiplayer slots
@@ -389,6 +391,7 @@ size_t AIUpdateTCASTargets ()
     vRoll.clear();          vRoll.reserve(numSlots);
     vGear.clear();          vGear.reserve(numSlots);
     vFlap.clear();          vFlap.reserve(numSlots);
+    vFlap2.clear();         vFlap2.reserve(numSlots);
     vSpeedbrake.clear();    vSpeedbrake.reserve(numSlots);
     vSlat.clear();          vSlat.reserve(numSlots);
     vWingSweep.clear();     vWingSweep.reserve(numSlots);
@@ -434,6 +437,7 @@ size_t AIUpdateTCASTargets ()
             // configuration
             vGear.push_back(ac.v[V_CONTROLS_GEAR_RATIO]);
             vFlap.push_back(ac.v[V_CONTROLS_FLAP_RATIO]);
+            vFlap2.push_back(ac.v[V_CONTROLS_FLAP_RATIO]);
             vSpeedbrake.push_back(ac.v[V_CONTROLS_SPEED_BRAKE_RATIO]);
             vSlat.push_back(ac.v[V_CONTROLS_SLAT_RATIO]);
             vWingSweep.push_back(ac.v[V_CONTROLS_WING_SWEEP_RATIO]);
@@ -526,8 +530,8 @@ size_t AIUpdateTCASTargets ()
         CATCH_AC(ac)
     }
     
-    // Feed the dataRefs to X-Plane for TCAS target tracking
-#define SET_DR(ty, dr) XPLMSetData##ty(drTcas##dr, v##dr.data(), 1, (int)v##dr.size())
+    // Feed the dataRefs to X-Plane for TCAS target tracking, as far as values changed
+#define SET_DR(ty, dr) v##dr.SetChanged(drTcas##dr)
     SET_DR(vi, ModeS);
     SET_DR(vi, ModeC);
     SET_DR(vf, X);
@@ -539,7 +543,7 @@ size_t AIUpdateTCASTargets ()
     SET_DR(vf, Roll);
     SET_DR(vf, Gear);
     SET_DR(vf, Flap);
-    XPLMSetDatavf(drTcasFlap2, vFlap.data(), 1, (int)vFlap.size());
+    SET_DR(vf, Flap2);
     SET_DR(vf, Speedbrake);
     SET_DR(vf, Slat);
     SET_DR(vf, WingSweep);
@@ -621,45 +625,50 @@ void AIMultiUpdate ()
     // only every few seconds rearrange slots, ie. add/remove planes or
     // move planes between lower and upper section of AI slots:
     if (CheckEverySoOften(tLastSlotSwitching, AISLOT_CHANGE_PERIOD) ||
-        glob.mapAc.size() != gMapAcByDist.size())
+        glob.acIdx.size() != gNumAcSorted)
     {
-        // Sort all planes by prioritized distance
-        gMapAcByDist.clear();
-        for (const auto& pair: glob.mapAc) {
-            const Aircraft& ac = *pair.second;
+        // Collect all planes with their prioritized distance
+        gAcByDist.clear();
+        for (size_t i = 0; i < glob.acIdx.size(); ++i) {
+            const Aircraft& ac = *glob.acIdx.vecAc[i];
             // only consider planes that require being shown as AI aircraft
             // (these excludes invisible planes and those with transponder off)
             if (ac.ShowAsAIPlane())
                 // Priority distance means that we add artificial distance for higher-numbered AI priorities
-                gMapAcByDist.emplace(ac.GetCameraDist() + ac.aiPrio * AI_PRIO_MULTIPLIER,
-                                     ac.GetModeS_ID());
+                gAcByDist.emplace_back(glob.acIdx.vecCamDist[i] + ac.aiPrio * AI_PRIO_MULTIPLIER,
+                                       ac.GetModeS_ID());
         }
+        gNumAcSorted = glob.acIdx.size();
+        
+        AISortClosest(gAcByDist, numSlots);
     }
     
-    // Aircraft come and go, so the entries in gMapAcByDist can be outdated
+    // Aircraft come and go, so the entries in gAcByDist can be outdated
     // Here we verify existence of aircraft and compile the definitive
     // list of aircraft to show
     vAcByDist.clear();
     vAcByDist.reserve(numSlots);
-    for (const auto& p: gMapAcByDist)
+    for (const acByDistTy& p: gAcByDist)
     {
+        if (vAcByDist.size() >= numSlots)
+            break;
         mapAcTy::const_iterator iterAc = glob.mapAc.find(p.second);
         if (iterAc == glob.mapAc.end() ||       // not found any longer?
             !iterAc->second->ShowAsAIPlane())   // or no longer to be shown on TCAS?
         {
-            tLastSlotSwitching = 0.0f;          // ensure we reinit the map next time
+            tLastSlotSwitching = 0.0f;          // ensure we resort next time
         } else {
-            // Plane exists!
-            // If there's still room: add it to the list
-            if (vAcByDist.size() < numSlots)
-                vAcByDist.push_back(iterAc->second);
-            else {
-                // else reset the TCAS target index of the plane is it will not be shown
-                if (iterAc->second->IsCurrentlyShownAsTcasTarget())
-                    iterAc->second->SetTcasTargetIdx(-1);
-            }
+            // Plane exists and there's still room: add it to the list
+            // (beyond numSlots the list is unsorted, but then we resort next time anyway)
+            vAcByDist.push_back(iterAc->second);
         }
     }
+    
+    // Reset the TCAS target index of all other planes as they will not be shown
+    for (Aircraft* pAc: glob.acIdx.vecAc)
+        if (pAc->IsCurrentlyShownAsTcasTarget() &&
+            std::find(vAcByDist.begin(), vAcByDist.end(), pAc) == vAcByDist.end())
+            pAc->SetTcasTargetIdx(-1);
     const size_t numAcToShow = vAcByDist.size();
     LOG_ASSERT(numAcToShow <= numSlots);
     
@@ -670,7 +679,8 @@ void AIMultiUpdate ()
     gSlots.assign(numSlots+1, nullptr);
     
     // There are up to 2 passes:
-    std::vector<size_t> vLimits;
+    static std::vector<size_t> vLimits;
+    vLimits.clear();
     if (GoTCASOverride()) {
         // TCAS override: number of multiplayer dataRefs (19); number of TCAS targets (63)
         if (gMultiRef.size()-1 < numAcToShow)
@@ -812,6 +822,15 @@ void AIMultiClearTcasDataRefs ()
         std::vector<int> nullArr (numSlots, 0);
         XPLMSetDatavi(drTcasModeS, nullArr.data(), 1, (int)numSlots);
     }
+    
+    // X-Plane's values are no longer what we sent, so the next update writes everything again
+    for (TcasArrayTy<int>* pArr: {&vModeS, &vModeC, &vLights, &vWeightOnWheels, &vWakeCat})
+        pArr->Invalidate();
+    for (TcasArrayTy<float>* pArr: {&vX, &vY, &vZ, &vVertSpeed, &vHeading, &vPitch, &vRoll,
+                                    &vGear, &vFlap, &vFlap2, &vSpeedbrake, &vSlat, &vWingSweep,
+                                    &vThrottle, &vYokePitch, &vYokeRoll, &vYokeYaw,
+                                    &vWakeWingSpan, &vWakeWingArea, &vWakeMass, &vWakeAoA, &vWakeLift})
+        pArr->Invalidate();
 }
 
 /// Reset all (controlled) multiplayer dataRef values of all planes
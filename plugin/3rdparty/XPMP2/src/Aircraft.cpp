@@ -225,8 +225,9 @@ Aircraft::~Aircraft ()
     if (pCSLMdl)
         pCSLMdl->DecRefCnt();
 
-    // remove myself from the global map of planes
+    // remove myself from the global map and index of planes
     glob.mapAc.erase(modeS_id);
+    glob.acIdx.Remove(*this);
     
     // remove the Y Probe
     if (hProbe) {
@@ -296,8 +297,9 @@ void Aircraft::Create (const std::string& _callsign,
         ChangeModel(_icaoType, _icaoAirline, _livery);
     LOG_ASSERT(pCSLMdl);
     
-    // add the aircraft to our global map and inform observers
+    // add the aircraft to our global map and index and inform observers
     glob.mapAc.emplace(modeS_id,this);
+    glob.acIdx.Add(*this);
     XPMPSendNotification(*this, xpmp_PlaneNotification_Created);
     
     // make sure the flight loop callback gets called if this was the first a/c
@@ -513,8 +515,9 @@ float Aircraft::FlightLoopCB(float _elapsedSinceLastCall, float, int _flCounter,
         RemoteAcEnqueueStarts(now);            // give remote model the chance for some prep work
 
         // Update positional and configurational values
-        for (mapAcTy::value_type& pair : glob.mapAc) {
-            Aircraft& ac = *pair.second;
+        // (by index, as the app might create aircraft while we call into it)
+        for (size_t i = 0; i < glob.acIdx.size(); ++i) {
+            Aircraft& ac = *glob.acIdx.vecAc[i];
             // Catch up with instance destroy
             if (ac.bDestroyInst)
                 ac.DestroyInstances();
@@ -536,6 +539,7 @@ float Aircraft::FlightLoopCB(float _elapsedSinceLastCall, float, int _flCounter,
                     }
                     // Actually move the plane, ie. the instance that represents it
                     ac.DoMove();
+                    glob.acIdx.SetDrawPos(ac, ac.drawInfo);
                     // Feed remote connections
                     RemoteAcEnqueue(ac);
                 }
@@ -573,9 +577,15 @@ void Aircraft::DoMove ()
     if (IsRendered()) {
         // Already have instances? 
         if (!listInst.empty() || CreateInstances()) {
+            // Nothing changed since the last move, like for a parked plane? Then spare XP the update
+            if (!vInst.empty() && vInst == v &&
+                !memcmp(&drawInfoInst, &drawInfo, sizeof(drawInfo)))
+                return;
             // Move the instances (this is probably the single most important line of code ;-) )
             for (XPLMInstanceRef hInst: listInst)
                  XPLMInstanceSetPosition(hInst, &drawInfo, v.data());
+            drawInfoInst = drawInfo;
+            vInst = v;
         }
     }
 }
@@ -620,6 +630,7 @@ void Aircraft::UpdateDistBearingCamera (const XPLMCameraPosition_t& posCam)
                       drawInfo.x, drawInfo.y, drawInfo.z);
     // Bearing (note: x points east, z points south
     camBearing = angleLocCoord(posCam.x, posCam.z, drawInfo.x, drawInfo.z);
+    glob.acIdx.SetCameraDist(*this, camDist);
 }
 
 
@@ -670,6 +681,7 @@ void Aircraft::DestroyInstances ()
         return;
     }
 
+    vInst.clear();                      // new instances need their position set
     if (!listInst.empty()) {
         while (!listInst.empty()) {
             XPLMInstanceRef hRef = listInst.back();
@@ -1032,6 +1044,7 @@ void AcCleanup ()
     if (!glob.mapAc.empty()) {
         LOG_MSG(logWARN, WARN_PLANES_LEFT_EXIT, (unsigned long)glob.mapAc.size());
         glob.mapAc.clear();
+        glob.acIdx.Clear();
     }
     
     // Destroy flight loop
@@ -1047,6 +1060,47 @@ void AcCleanup ()
     ahDataRefs.clear();
 }
 
+// Adds an aircraft, which must not yet be in the index
+void AcDenseIdxTy::Add (Aircraft& ac)
+{
+    LOG_ASSERT(ac.denseIdx == SIZE_MAX);
+    ac.denseIdx = vecAc.size();
+    vecAc.push_back(&ac);
+    vecCamDist.push_back(ac.GetCameraDist());
+    vecDrawPos.push_back(ac.drawInfo);
+}
+
+// Removes an aircraft, if in the index
+void AcDenseIdxTy::Remove (Aircraft& ac)
+{
+    if (ac.denseIdx >= vecAc.size())
+        return;
+    
+    // move the last aircraft into the gap
+    const size_t idx = ac.denseIdx;
+    const size_t last = vecAc.size() - 1;
+    if (idx != last) {
+        vecAc[idx]      = vecAc[last];
+        vecCamDist[idx] = vecCamDist[last];
+        vecDrawPos[idx] = vecDrawPos[last];
+        vecAc[idx]->denseIdx = idx;
+    }
+    vecAc.pop_back();
+    vecCamDist.pop_back();
+    vecDrawPos.pop_back();
+    ac.denseIdx = SIZE_MAX;
+}
+
+// Removes all aircraft
+void AcDenseIdxTy::Clear ()
+{
+    for (Aircraft* pAc: vecAc)
+        pAc->denseIdx = SIZE_MAX;
+    vecAc.clear();
+    vecCamDist.clear();
+    vecDrawPos.clear();
+}
+
 // Find aircraft by its plane ID, can return nullptr
 Aircraft* AcFindByID (XPMPPlaneID _id)
 {
@@ -56,6 +56,36 @@ public:
 ///         Plugin (the one using this library) is expected to own and destroy the object
 typedef std::map<XPMPPlaneID,Aircraft*> mapAcTy;
 
+/// @brief Dense index of all aircraft, walked by the loops that run every frame
+/// @details `mapAc` stays for lookup by id. The per-frame loops walk this index instead:
+///          the aircraft pointers are contiguous, and the values those loops filter on
+///          are kept in parallel arrays, so that skipping an aircraft doesn't touch the object.
+///          Removing an aircraft moves the last one into its place, so the order is arbitrary.
+class AcDenseIdxTy {
+public:
+    std::vector<Aircraft*>      vecAc;      ///< all aircraft, in arbitrary order
+    std::vector<float>          vecCamDist; ///< [m] Aircraft::GetCameraDist() of the aircraft at the same index
+    std::vector<XPLMDrawInfo_t> vecDrawPos; ///< Aircraft::drawInfo of the aircraft at the same index as last moved
+
+public:
+    /// Number of aircraft in the index
+    size_t size () const { return vecAc.size(); }
+    /// No aircraft in the index?
+    bool empty () const { return vecAc.empty(); }
+    /// Adds an aircraft, which must not yet be in the index
+    void Add (Aircraft& ac);
+    /// Removes an aircraft, if in the index
+    void Remove (Aircraft& ac);
+    /// Removes all aircraft
+    void Clear ();
+    /// Updates the camera distance of an aircraft
+    void SetCameraDist (const Aircraft& ac, float _dist)
+    { if (ac.denseIdx < vecCamDist.size()) vecCamDist[ac.denseIdx] = _dist; }
+    /// Updates the drawing position of an aircraft
+    void SetDrawPos (const Aircraft& ac, const XPLMDrawInfo_t& _drawInfo)
+    { if (ac.denseIdx < vecDrawPos.size()) vecDrawPos[ac.denseIdx] = _drawInfo; }
+};
+
 //
 // MARK: Global Functions
 //
@@ -212,8 +212,8 @@ void MapIconDrawingCB (XPLMMapLayerID       inLayer,
                                       MAP_MIN_ICON_SIZE * mapUnitsPerUserInterfaceUnit);
 
         // Draw icons for all (visible) aircraft
-        for (const auto& p : glob.mapAc) {
-            Aircraft& ac = *p.second;
+        for (Aircraft* pAc : glob.acIdx.vecAc) {
+            Aircraft& ac = *pAc;
             try {
                 if (ac.IsVisible()) {
                     ac.MapPreparePos(projection, inMapBoundsLeftTopRightBottom);
@@ -251,12 +251,12 @@ void MapLabelDrawingCB (XPLMMapLayerID       inLayer,
                                     MAP_MIN_ICON_SIZE * mapUnitsPerUserInterfaceUnit) / -1.75f;
 
         // Draw labels for all (visible) aircraft
-        for (const auto& p : glob.mapAc) {
+        for (Aircraft* pAc : glob.acIdx.vecAc) {
             try {
-                if (p.second->IsVisible())
-                    p.second->MapDrawLabel(inLayer, yOfs);
+                if (pAc->IsVisible())
+                    pAc->MapDrawLabel(inLayer, yOfs);
             }
-            CATCH_AC(*p.second);
+            CATCH_AC(*pAc);
         }
     }
     catch (const std::exception& e) { LOG_MSG(logFATAL, ERR_EXCEPTION, e.what()); }
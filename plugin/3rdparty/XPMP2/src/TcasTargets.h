@@ -0,0 +1,98 @@
+/// @file       TcasTargets.h
+/// @brief      Choosing the aircraft for the AI/TCAS slots and writing the TCAS target dataRefs
+/// @details    Kept apart from AIMultiplayer.cpp and free of XPMP2 globals,
+///             so that a benchmark can drive them with stubbed dataRef writes.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2020 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#ifndef _TcasTargets_h_
+#define _TcasTargets_h_
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "XPLMDataAccess.h"
+#include "XPMPMultiplayer.h"
+
+namespace XPMP2 {
+
+//
+// MARK: Slot selection
+//
+
+/// Aircraft id with its (priority-biased) distance
+typedef std::pair<float,XPMPPlaneID> acByDistTy;
+
+/// @brief Moves the closest `numSlots` aircraft to the front of `v`, sorted by distance
+/// @details Only the closest planes get a slot, so only they need sorting;
+///          the order of the rest is unspecified.
+inline void AISortClosest (std::vector<acByDistTy>& v, size_t numSlots)
+{
+    if (v.size() > numSlots) {
+        std::nth_element(v.begin(), v.begin() + (long)numSlots, v.end());
+        std::sort(v.begin(), v.begin() + (long)numSlots);
+    } else {
+        std::sort(v.begin(), v.end());
+    }
+}
+
+//
+// MARK: TCAS target dataRefs
+//
+
+/// @brief Values for one of the `sim/cockpit2/tcas/targets` array dataRefs, and what X-Plane got last time
+/// @details Most values don't change from one frame to the next, think parked aircraft,
+///          so only the range from the first to the last changed value is written.
+template <class T>
+class TcasArrayTy {
+public:
+    std::vector<T> v;           ///< this frame's values, index 0 is slot 1
+    std::vector<T> vSent;       ///< values last written to X-Plane
+public:
+    void clear () { v.clear(); }
+    void reserve (size_t n) { v.reserve(n); vSent.reserve(n); }
+    void push_back (T val) { v.push_back(val); }
+    /// Forget what was sent, so that the next SetChanged() writes all values
+    void Invalidate () { vSent.clear(); }
+    /// Write the values that differ from what X-Plane got last time
+    void SetChanged (XPLMDataRef dr)
+    {
+        const size_t common = std::min(v.size(), vSent.size());
+        size_t first = 0;
+        while (first < common && Same(v[first], vSent[first]))
+            ++first;
+        size_t last = v.size();
+        if (last <= vSent.size())
+            while (last > first && Same(v[last-1], vSent[last-1]))
+                --last;
+        if (first < last)
+            SetDatav(dr, v.data() + first, int(first) + 1, int(last - first));
+        vSent = v;              // no allocation once capacity is reserved
+    }
+private:
+    /// Bitwise equal, which is what matters for not resending a value
+    static bool Same (const T& a, const T& b) { return std::memcmp(&a, &b, sizeof(T)) == 0; }
+    static void SetDatav (XPLMDataRef dr, float* p, int ofs, int n) { XPLMSetDatavf(dr, p, ofs, n); }
+    static void SetDatav (XPLMDataRef dr, int* p,   int ofs, int n) { XPLMSetDatavi(dr, p, ofs, n); }
+};
+
+}
+
+#endif
@@ -171,10 +171,14 @@ public:
     
     /// Global map of all created planes
     mapAcTy         mapAc;
+    /// The same planes in a dense index for the per-frame loops
+    AcDenseIdxTy    acIdx;
     /// Shall we draw aircraft labels?
     bool            bDrawLabels = true;
     /// Maximum distance for drawing labels? [m], defaults to 3nm
     float           maxLabelDist = 5556.0f;
+    /// Maximum number of labels drawn per frame, closest aircraft first, `0` for no limit
+    int             maxLabels = 100;
     /// Cut off labels at XP's reported visibility mit?
     bool            bLabelCutOffAtVisibility = true;
     /// Label font scaling factor
@@ -21,12 +21,18 @@
 
 #include "XPilot.h"
 #include "NetworkAircraft.h"
+#include "AircraftStateQueue.h"
+#include "TerrainElevationCache.h"
 #include "DataRefAccess.h"
 #include "AudioEngine.h"
+#include "DrainQueue.h"
 
+#include <chrono>
 #include <string>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 namespace xpilot {
 	typedef std::map<std::string, std::unique_ptr<NetworkAircraft>> mapPlanesTy;
@@ -38,19 +44,54 @@ namespace xpilot {
 	}
 	mapPlanesTy::iterator mapGetAircraftByIndex(int idx);
 
+	struct FastPositionUpdate
+	{
+		uint32_t Handle;
+		std::string Callsign;
+		AircraftVisualState VisualState;
+		Vector3 PositionalVelocities;
+		Vector3 RotationalVelocities;
+		double Speed;
+		int64_t SentAt; // steady clock microseconds when the client received it from FSD, 0 if unknown
+	};
+	typedef std::vector<FastPositionUpdate> PositionFrame;
+
+	// an ADD_AIRCRAFT that is waiting for its turn to be created, along with any updates received meanwhile
+	struct PendingAircraft
+	{
+		std::string Callsign;
+		uint32_t Handle;
+		std::string Airline;
+		std::string TypeCode;
+		AircraftVisualState VisualState;
+		Vector3 PositionalVelocities;
+		Vector3 RotationalVelocities;
+		double Speed = 0.0;
+		bool HasPosition = false;
+		AircraftConfig Config;
+		bool HasConfig = false;
+		double UserDistance = 0.0;
+	};
+
 	class AircraftManager
 	{
 	public:
 		AircraftManager(XPilot* instance);
 		virtual ~AircraftManager();
 
-		void HandleAddPlane(const std::string& callsign, const AircraftVisualState& visualState, const std::string& airline, const std::string& typeCode);
-		void HandleAircraftConfig(const std::string& callsign, const AircraftConfigDto& config);
-		void HandleFastPositionUpdate(const std::string& callsign, const AircraftVisualState& visualState, Vector3 positionalVector, Vector3 rotationalVector, double speed);
-		void HandleHeartbeat(const std::string& callsign);
-		void HandleRemovePlane(const std::string& callsign);
+		void HandleAddPlane(const std::string& callsign, uint32_t handle, const AircraftVisualState& visualState, const std::string& airline, const std::string& typeCode);
+		void HandleAircraftConfig(uint32_t handle, const std::string& callsign, const AircraftConfig& config);
+		void HandleFastPositionUpdate(uint32_t handle, const std::string& callsign, const AircraftVisualState& visualState, Vector3 positionalVector, Vector3 rotationalVector, double speed);
+		void HandlePositionFrame(const PositionFrame& frame);
+		void HandleHeartbeat(uint32_t handle, const std::string& callsign);
+		void HandleRemovePlane(uint32_t handle, const std::string& callsign);
 		void RemoveAllPlanes();
 
+		// spread over frames by XPilot::InvokeQueuedCallbacks, each stops once its deadline has passed
+		void QueueAircraftConfig(uint32_t handle, const AircraftConfig& config);
+		void ApplyQueuedConfigs(std::chrono::steady_clock::time_point deadline);
+		void CreatePendingAircraft(std::chrono::steady_clock::time_point deadline);
+
 	protected:
 		DataRefAccess<int> m_soundOn;
 		DataRefAccess<int> m_simPaused;
@@ -62,12 +103,32 @@ namespace xpilot {
 		DataRefAccess<int> m_isViewExternal;
 		DataRefAccess<float> m_canopyOpenRatio;
 		DataRefAccess<std::vector<float>> m_userDoorOpenRatio;
+		DataRefAccess<double> m_userLatitude;
+		DataRefAccess<double> m_userLongitude;
 
 	private:
 		XPilot* mEnv;
 		std::unique_ptr<CAudioEngine> m_audioEngine;
+		std::vector<ChannelUpdate> m_soundUpdates;
+		TerrainElevationCache m_terrainCache;
+
+		// aircraft indexed by the handle the client assigned in ADD_AIRCRAFT; the planes
+		// themselves are still owned by mapPlanes
+		std::vector<NetworkAircraft*> m_aircraftSlots;
+		void ReleaseHandle(const NetworkAircraft* aircraft);
+
+		// ADD_AIRCRAFT only records the aircraft; constructing it, CSL matching and creating the
+		// instances happen in CreatePendingAircraft, a few per frame
+		std::vector<std::unique_ptr<PendingAircraft>> m_pendingAircraft;
+		std::vector<PendingAircraft*> m_pendingSlots; // the same, indexed by handle like m_aircraftSlots
+		DrainQueue<std::pair<uint32_t, AircraftConfig>> m_queuedConfigs;
+		PendingAircraft* GetPendingAircraft(uint32_t handle, const std::string& callsign);
+		void ReleasePendingHandle(const PendingAircraft* pending);
+		void CreateAircraft(const PendingAircraft& pending);
+		void DiscardQueuedConfigs(uint32_t handle);
 
 		NetworkAircraft* GetAircraft(const std::string& callsign);
+		NetworkAircraft* GetAircraft(uint32_t handle, const std::string& callsign);
 		static float AircraftMaintenanceCallback(float, float, int, void* ref);
 		static void AircraftNotifierCallback(XPMPPlaneID inPlaneID, XPMPPlaneNotification inNotification, void* ref);
 
@@ -0,0 +1,147 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef AircraftStateQueue_h
+#define AircraftStateQueue_h
+
+#include "NetworkAircraft.h"
+#include "SpscQueue.h"
+#include "Dto.h"
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace xpilot {
+	struct AircraftConfig
+	{
+		std::optional<bool> EnginesOn;
+		std::optional<bool> EnginesReversing;
+		std::optional<bool> OnGround;
+		std::optional<float> Flaps;
+		std::optional<bool> SpoilersDeployed;
+		std::optional<bool> GearDown;
+		std::optional<bool> BeaconLightsOn;
+		std::optional<bool> LandingLightsOn;
+		std::optional<bool> NavLightsOn;
+		std::optional<bool> StrobeLightsOn;
+		std::optional<bool> TaxiLightsOn;
+
+		static AircraftConfig FromDto(const AircraftConfigDto& dto);
+
+		// overlays the values present in a newer (possibly incremental) config
+		void Merge(const AircraftConfig& newer);
+	};
+
+	struct AircraftState
+	{
+		AircraftVisualState VisualState;
+		Vector3 PositionalVelocities;
+		Vector3 RotationalVelocities;
+		double Speed;
+		int64_t PositionSentAt; // see FastPositionUpdate::SentAt
+		AircraftConfig Config;
+
+		// cleared when the handle is (re)assigned, so nothing from a previous owner is applied
+		bool HasPosition;
+		bool HasConfig;
+		bool HasHeartbeat;
+
+		uint32_t PositionRevision;
+		uint32_t ConfigRevision;
+		uint32_t HeartbeatRevision;
+	};
+
+	/**
+	 * Hands position, config and heartbeat updates from the socket thread to the flight loop
+	 * without locks. Every aircraft handle owns a slot that the socket thread overwrites (config
+	 * is merged), so the flight loop applies at most one state per aircraft per frame no matter
+	 * how many updates were received in between. Slots are guarded by a sequence counter and
+	 * announced through an SPSC queue of handles, each handle being queued at most once.
+	 */
+	class AircraftStateQueue
+	{
+	public:
+		AircraftStateQueue();
+
+		// socket thread
+		void PostPosition(uint32_t handle, const AircraftVisualState& visualState, const Vector3& positionalVelocities,
+			const Vector3& rotationalVelocities, double speed, int64_t sentAt);
+		void PostConfig(uint32_t handle, const AircraftConfig& config);
+		void PostHeartbeat(uint32_t handle);
+		void Reset(uint32_t handle);
+		void ResetAll();
+
+		static bool IsValidHandle(uint32_t handle) {
+			return handle > 0 && handle < MAX_AIRCRAFT_HANDLES;
+		}
+
+		// flight loop; apply(handle, state, positionChanged, configChanged, heartbeatChanged) until
+		// outOfTime() returns true, the remaining handles stay queued for the next call
+		template<typename F, typename T>
+		void Drain(F&& apply, T&& outOfTime) {
+			uint32_t handle;
+			while (!outOfTime() && m_pendingHandles.Pop(handle)) {
+				Slot& slot = m_slots[handle];
+				slot.Queued.store(false);
+
+				AircraftState state;
+				Read(slot, state);
+
+				AppliedRevisions& applied = m_applied[handle];
+				bool positionChanged = state.HasPosition && state.PositionRevision != applied.Position;
+				bool configChanged = state.HasConfig && state.ConfigRevision != applied.Config;
+				bool heartbeatChanged = state.HasHeartbeat && state.HeartbeatRevision != applied.Heartbeat;
+				applied = { state.PositionRevision, state.ConfigRevision, state.HeartbeatRevision };
+
+				if (positionChanged || configChanged || heartbeatChanged) {
+					apply(handle, state, positionChanged, configChanged, heartbeatChanged);
+				}
+			}
+		}
+
+	private:
+		static_assert(std::is_trivially_copyable<AircraftState>::value, "AircraftState is copied under a sequence lock");
+
+		struct Slot
+		{
+			std::atomic<uint32_t> Sequence{ 0 };
+			std::atomic<bool> Queued{ false };
+			AircraftState State{};
+		};
+
+		struct AppliedRevisions
+		{
+			uint32_t Position;
+			uint32_t Config;
+			uint32_t Heartbeat;
+		};
+
+		template<typename F>
+		void Write(uint32_t handle, F&& update);
+		static void Read(const Slot& slot, AircraftState& state);
+
+		std::unique_ptr<Slot[]> m_slots;
+		std::vector<AppliedRevisions> m_applied; // flight loop only
+		SpscQueue<uint32_t> m_pendingHandles;
+	};
+}
+
+#endif // !AircraftStateQueue_h
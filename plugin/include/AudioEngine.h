@@ -23,6 +23,7 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <math.h>
 #include <iostream>
@@ -38,6 +39,16 @@ struct AudioVector3 {
 	}
 };
 
+// per frame state of one engine sound, see CAudioEngine::UpdateChannels
+struct ChannelUpdate {
+	int channelId;
+	AudioVector3 position; // relative to the listener
+	float volume;
+	bool audible; // engines running and sound not paused
+};
+
+// Every engine sound is a virtual voice; only the closest audible ones are given an FMOD channel,
+// up to the voice cap, so the cost depends on the cap rather than the number of aircraft.
 class CAudioEngine {
 public:
 	CAudioEngine();
@@ -47,9 +58,7 @@ public:
 	void LoadSound(const std::string& soundName, const std::string& soundFilePath, bool bLooping = true);
 	void UnloadSound(const std::string& soundName);
 	int CreateSoundChannel(const std::string& soundName, float fVolumedB = 0.0f);
-	void SetChannel3dPosition(int nChannelId, const AudioVector3& pos);
-	void SetChannelVolume(int nChannelId, float fVolumedB);
-	void SetChannelPaused(int channel, bool paused);
+	void UpdateChannels(const std::vector<ChannelUpdate>& updates, size_t maxVoices);
 	void StopChannel(int channel);
 	void StopAllChannels();
 	void SetListenerPosition();
@@ -57,12 +66,24 @@ public:
 
 	FMOD::System* SoundSystem;
 	std::map<std::string, FMOD::Sound*> SoundMap;
-	std::map<int, FMOD::Channel*> ChannelMap;
 
 	static int ErrorCheck(const std::string& method, FMOD_RESULT result);
 
 private:
+	struct Voice {
+		FMOD::Sound* sound = nullptr;
+		FMOD::Channel* channel = nullptr; // only while the voice is real
+		FMOD_VECTOR position{};
+		float volume = 0.0f;
+		bool audible = false;
+		float distanceSq = 0.0f;
+	};
+
+	void ReleaseChannel(Voice& voice);
+
 	int mNextChannelId;
+	std::unordered_map<int, Voice> mVoices;
+	std::vector<Voice*> mAudibleVoices;
 	std::mutex mChannelMapMutex;
 	std::mutex mSoundMapMutex;
 };
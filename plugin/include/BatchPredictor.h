@@ -0,0 +1,98 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef BatchPredictor_h
+#define BatchPredictor_h
+
+#include "WorkerPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace xpilot {
+	class NetworkAircraft;
+
+	/**
+	 * Predicted state of every aircraft in structure-of-arrays form, so the extrapolation can
+	 * process several aircraft per instruction. Arrays are padded to a multiple of the SIMD width.
+	 */
+	struct PredictionLanes
+	{
+		std::vector<double> Lat;
+		std::vector<double> Lon;
+		std::vector<double> Altitude;   // [ft]
+		std::vector<double> Pitch;      // [deg]
+		std::vector<double> Heading;    // [deg]
+		std::vector<double> Bank;       // [deg]
+		std::vector<double> VelocityX;  // [m/s] east
+		std::vector<double> VelocityY;  // [m/s] up
+		std::vector<double> VelocityZ;  // [m/s] north
+		std::vector<double> RotationX;  // [rad/s] pitch
+		std::vector<double> RotationY;  // [rad/s] heading
+		std::vector<double> RotationZ;  // [rad/s] bank
+		std::vector<double> Interval;   // [s] time to advance each lane by
+
+		// count rounded up to a whole number of SIMD vectors
+		static size_t PaddedCount(size_t count);
+		void Resize(size_t count);
+	};
+
+	/**
+	 * Advances the predicted position of many aircraft in one pass instead of one
+	 * NetworkAircraft::ExtrapolatePosition call per aircraft. The pass uses AVX2, SSE2 or NEON,
+	 * whichever the plugin was compiled for, and a scalar fallback otherwise; all of them share
+	 * one implementation of the maths, including polynomial sin/cos/atan2 for the quaternion
+	 * conversions.
+	 *
+	 * Results match ExtrapolatePose (the maths behind ExtrapolatePosition) within 1e-9 degrees for
+	 * lat/lon and attitude and 1e-6 ft for altitude per step; tests/BatchPredictorTest.cpp checks it. The one intended difference is that every aircraft uses the same
+	 * timestamp for the error velocity cut-off, taken when the pass runs.
+	 *
+	 * With enough traffic the pass is split into runs of whole SIMD vectors that worker threads
+	 * and the X-Plane thread work on side by side. Each run only touches its own aircraft, so
+	 * the results are the same for any number of threads (tests/BatchPredictorThreadingTest.cpp
+	 * checks it), and a PredictionThreads setting of 1 runs the pass inline in aircraft order.
+	 * Nothing in it calls the X-Plane SDK.
+	 */
+	class BatchPredictor
+	{
+	public:
+		// Updates PredictedVisualState of the given aircraft, each by its LodElapsed interval.
+		void Advance(const std::vector<NetworkAircraft*>& aircraft);
+
+		// The extrapolation kernel: advances lanes [begin, end) by their interval; begin must be
+		// a multiple of the SIMD width. It lives in BatchPredictorKernel.cpp, apart from the SDK.
+		static void Extrapolate(PredictionLanes& lanes, size_t begin, size_t end);
+
+		static const char* GetInstructionSet();
+
+		// joins the worker threads, they are started again by the next Advance
+		void StopWorkers() { m_workers.Stop(); }
+
+	private:
+		void AdvanceLanes(size_t begin, size_t end);
+
+		std::vector<NetworkAircraft*> m_batch;
+		PredictionLanes m_lanes;
+		WorkerPool m_workers;
+		int64_t m_timestamp = 0;
+	};
+}
+
+#endif // !BatchPredictor_h
@@ -0,0 +1,71 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef BulkDataSnapshot_h
+#define BulkDataSnapshot_h
+
+#include "XPilotAPI.h"
+
+#include <XPLMDataAccess.h>
+
+#include <vector>
+
+namespace xpilot {
+	/**
+	 * Serves xpilot/bulk/quick and xpilot/bulk/expensive to other plugins from contiguous copies of
+	 * every aircraft's bulk data, so a read is a memcpy instead of a walk over mapPlanes. Each copy
+	 * is built at most once per flight loop cycle, by the first read, so nothing is spent while no
+	 * plugin is reading.
+	 *
+	 * The quick data is double buffered: a new build goes into the back buffer and only replaces the
+	 * front one, bumping xpilot/bulk/generation, if anything changed. Readers polling every frame can
+	 * compare the generation and skip the bulk read when it hasn't moved.
+	 */
+	class BulkDataSnapshot
+	{
+	public:
+		BulkDataSnapshot();
+		~BulkDataSnapshot();
+
+		BulkDataSnapshot(const BulkDataSnapshot&) = delete;
+		BulkDataSnapshot& operator=(const BulkDataSnapshot&) = delete;
+
+	private:
+		static int GetQuickData(void* inRefcon, void* outData, int inStartPos, int inNumBytes);
+		static int GetExpensiveData(void* inRefcon, void* outData, int inStartPos, int inNumBytes);
+		static int GetGeneration(void* inRefcon);
+
+		void RefreshQuick();
+		void RefreshTexts();
+
+		XPLMDataRef m_quickRef{}, m_expensiveRef{}, m_generationRef{};
+
+		std::vector<XPilotAPIAircraft::XPilotAPIBulkData> m_quick;
+		std::vector<XPilotAPIAircraft::XPilotAPIBulkData> m_quickBack;
+		std::vector<XPilotAPIAircraft::XPilotAPIBulkInfoTexts> m_texts;
+		int m_quickCycle = -1;
+		int m_textsCycle = -1;
+		int m_generation = 0;
+
+		// struct sizes the reader announced, which may differ from ours
+		int m_quickSize = 0;
+		int m_textsSize = 0;
+	};
+}
+
+#endif // !BulkDataSnapshot_h
@@ -124,6 +124,14 @@ namespace xpilot {
 
 		void SetAircraftSoundVolume(int volume) { m_aircraftSoundsVolume = volume; }
 		int GetAircraftSoundVolume() const { return std::max(0, std::min(m_aircraftSoundsVolume, 100)); }
+		void SetAircraftUpdateBudget(float milliseconds) { m_aircraftUpdateBudget = std::max(0.5f, std::min(milliseconds, 10.0f)); }
+		float GetAircraftUpdateBudget() const { return m_aircraftUpdateBudget; }
+		void SetEngineSoundVoices(int voices) { m_engineSoundVoices = std::max(1, std::min(voices, 128)); }
+		int GetEngineSoundVoices() const { return m_engineSoundVoices; }
+		void SetLocalFrameExtrapolation(bool enabled) { m_localFrameExtrapolation = enabled; }
+		bool GetLocalFrameExtrapolation() const { return m_localFrameExtrapolation; }
+		void SetPredictionThreads(int threads) { m_predictionThreads = std::max(0, std::min(threads, 16)); }
+		int GetPredictionThreads() const { return m_predictionThreads; }
 
 	private:
 		Config() = default;
@@ -145,6 +153,10 @@ namespace xpilot {
 		bool m_transmitIndicatorEnabled = false;
 		bool m_aircraftSoundsEnabled = true;
 		int m_aircraftSoundsVolume = 50;
+		float m_aircraftUpdateBudget = 2.0f; // [ms] per frame for distant aircraft, see LodScheduler
+		int m_engineSoundVoices = 32; // closest aircraft whose engines are actually played, see CAudioEngine
+		bool m_localFrameExtrapolation = true; // see NetworkAircraft::SetPredictedLocation
+		int m_predictionThreads = 0; // 0=Automatic, 1=X-Plane thread only, see BatchPredictor
 		int m_logLevel = 2; // 0=Debug, 1=Info, 2=Warning, 3=Error, 4=Fatal, 5=Msg
 	};
 }
@@ -0,0 +1,63 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef DrainQueue_h
+#define DrainQueue_h
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace xpilot {
+	/**
+	 * FIFO that is filled between frames and drained in time slices. Drained items are erased
+	 * from the front in one go, so the storage keeps its capacity and, once it has grown to the
+	 * busiest frame, refilling it never allocates (a std::deque frees and reallocates its blocks).
+	 */
+	template<typename T>
+	class DrainQueue
+	{
+	public:
+		void Push(const T& item) { m_items.push_back(item); }
+
+		// calls apply(item) in order until it returns false or the queue is empty; the item
+		// apply returned false for is still consumed
+		template<typename Apply>
+		void Drain(Apply apply) {
+			size_t applied = 0;
+			while (applied < m_items.size()) {
+				if (!apply(m_items[applied++])) break;
+			}
+			m_items.erase(m_items.begin(), m_items.begin() + applied);
+		}
+
+		template<typename Predicate>
+		void RemoveIf(Predicate predicate) {
+			m_items.erase(std::remove_if(m_items.begin(), m_items.end(), predicate), m_items.end());
+		}
+
+		size_t Size() const { return m_items.size(); }
+		bool IsEmpty() const { return m_items.empty(); }
+		void Clear() { m_items.clear(); }
+
+	private:
+		std::vector<T> m_items;
+	};
+}
+
+#endif // !DrainQueue_h
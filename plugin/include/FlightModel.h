@@ -0,0 +1,50 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef FlightModel_h
+#define FlightModel_h
+
+#include <string>
+#include <vector>
+
+namespace xpilot {
+	struct FlightModelInfo
+	{
+		std::string category;
+		std::string regex;
+	};
+
+	class FlightModel
+	{
+	public:
+		std::string modelCategory;
+		double GEAR_DURATION = 10000;       // [ms] time for gear up/down
+		double GEAR_DEFLECTION = 0.5;       // [m]  main gear deflection on meters during touchdown
+		double FLAPS_DURATION = 5000;       // [ms] time for full flaps extension from 0% to 100%
+
+	public:
+		static void InitializeModels();
+		static std::vector<FlightModelInfo> modelMatches;
+
+		// The flight model for a Doc8643 wake category, classification and ICAO type, matched
+		// against modelMatches. Results are cached per combination; InitializeModels must have run.
+		static FlightModel ForClassification(const std::string& wtc, const std::string& classification, const std::string& icaoType);
+	};
+}
+
+#endif // !FlightModel_h
@@ -0,0 +1,103 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef IpcStats_h
+#define IpcStats_h
+
+#include "OwnedDataRef.h"
+#include "Dto.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace xpilot {
+	/**
+	 * Latency and drop accounting for messages from the client, published as xpilot/stats/...
+	 * datarefs and in a periodic log line.
+	 *
+	 * Per message type latency is measured from the client's send stamp to the moment the socket
+	 * thread decodes the message. Positions are stamped with the time the client received them from
+	 * FSD (for position frames, the oldest update), and are measured a second time when the flight
+	 * loop applies them to the aircraft, which is the end-to-end delay of a network position.
+	 * Both use log2 buckets in microseconds. The stamp uses the steady clock, so latency is only
+	 * meaningful when the client runs on the same machine; implausible samples are discarded.
+	 * Drops are gaps in the per message type sequence numbers.
+	 */
+	class IpcStats
+	{
+	public:
+		IpcStats();
+
+		IpcStats(const IpcStats&) = delete;
+		IpcStats& operator=(const IpcStats&) = delete;
+
+		// receive threads (serialized by the caller)
+		void RecordReceived(MessageId id, const MessageStamp& stamp, int64_t receivedAt);
+
+		// flight loop, once per position applied to an aircraft
+		void RecordPositionApplied(int64_t sentAt, int64_t appliedAt);
+
+		// any thread
+		void RecordSendDropped() { m_sendsDropped++; }
+
+		// flight loop; publishes the datarefs every second and logs a summary every minute
+		void Update(float elapsedSinceLastCall, uint64_t sharedMemoryDropped);
+
+	private:
+		static constexpr size_t BUCKET_COUNT = 24; // the last bucket holds everything above ~4 s
+		static constexpr size_t TYPE_COUNT = static_cast<size_t>(MessageId::Count);
+
+		typedef std::array<uint32_t, BUCKET_COUNT> Histogram;
+
+		struct TypeCounters
+		{
+			std::array<std::atomic<uint32_t>, BUCKET_COUNT> Buckets{}; // reset every window
+			std::atomic<uint64_t> Received{ 0 };
+			std::atomic<uint64_t> Dropped{ 0 };
+			uint32_t LastSequence = 0; // receive threads only
+		};
+
+		static size_t BucketIndex(int64_t latencyMicroseconds);
+		static float Percentile(const Histogram& histogram, uint64_t total, double fraction);
+
+		std::array<TypeCounters, TYPE_COUNT> m_types;
+		std::atomic<uint64_t> m_sendsDropped{ 0 };
+
+		float m_publishTimer = 0.0f;
+		float m_logTimer = 0.0f;
+		std::array<Histogram, TYPE_COUNT> m_logWindow{}; // flight loop only
+		Histogram m_positionWindow{}; // flight loop only, reset every publish
+		Histogram m_positionLogWindow{};
+
+		OwnedDataRef<int> m_messagesReceived;
+		OwnedDataRef<int> m_messagesDropped;
+		OwnedDataRef<int> m_sendsDroppedRef;
+		OwnedDataRef<float> m_latencyP50;
+		OwnedDataRef<float> m_latencyP99;
+		OwnedDataRef<float> m_positionLatencyP50;
+		OwnedDataRef<float> m_positionLatencyP99;
+		OwnedDataRef<std::vector<float>> m_receivedByType;
+		OwnedDataRef<std::vector<float>> m_droppedByType;
+		OwnedDataRef<std::vector<float>> m_latencyP50ByType;
+		OwnedDataRef<std::vector<float>> m_latencyP99ByType;
+	};
+}
+
+#endif // !IpcStats_h
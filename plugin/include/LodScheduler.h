@@ -0,0 +1,93 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef LodScheduler_h
+#define LodScheduler_h
+
+#include "BatchPredictor.h"
+#include "DataRefAccess.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace xpilot {
+	class NetworkAircraft;
+
+	/**
+	 * Decides every frame which network aircraft get the full update (extrapolation, ground
+	 * clamping, animation) and which only get dead reckoned from their last full update.
+	 *
+	 * Aircraft within 3 km of the camera, or in front of it within 20 km, are updated every
+	 * frame. Further out they are updated every 2nd, 4th or 8th frame, staggered so the work is
+	 * spread evenly. Distant aircraft that are due share the per-frame time budget from the
+	 * settings, nearest first; whatever doesn't fit is deferred to the next frame, but never for
+	 * more than a second.
+	 *
+	 * Parked aircraft (see NetworkAircraft::IsParked) are left out altogether until a position or
+	 * config update, or a shift of X-Plane's local coordinate origin, wakes them up.
+	 */
+	class LodScheduler
+	{
+	public:
+		static constexpr size_t TIER_COUNT = 4;
+
+		static LodScheduler& GetInstance();
+
+		void Register(NetworkAircraft* aircraft);
+		void Unregister(NetworkAircraft* aircraft);
+
+		// Called from every NetworkAircraft::UpdatePosition; only the first call of a flight loop
+		// cycle does any work. Sets IsFullUpdateDue on every aircraft and extrapolates those due.
+		void BeginFrame(int flightLoopCounter, float frameRatePeriod);
+
+		// reports how long a full NetworkAircraft::UpdatePosition took
+		void RecordFullUpdate(int64_t microseconds);
+
+		// aircraft per tier in the last frame, tier 0 is updated every frame
+		std::array<int, TIER_COUNT> GetTierCounts() const { return m_tierCounts; }
+		int GetDeferredCount() const { return m_deferredCount; }
+		int GetParkedCount() const { return m_parkedCount; }
+
+	private:
+		LodScheduler();
+
+		size_t GetTier(const NetworkAircraft* aircraft, float cameraHeading) const;
+
+		std::vector<NetworkAircraft*> m_aircraft;
+		std::vector<NetworkAircraft*> m_due;
+		std::vector<NetworkAircraft*> m_candidates;
+		BatchPredictor m_predictor;
+
+		int m_lastFlightLoopCounter = -1;
+		uint32_t m_frame = 0;
+		uint32_t m_nextPhase = 0;
+		double m_averageCost = 20.0; // [us] per full update
+
+		std::array<int, TIER_COUNT> m_tierCounts{};
+		int m_deferredCount = 0;
+		int m_parkedCount = 0;
+
+		DataRefAccess<float> m_latRef;
+		DataRefAccess<float> m_lonRef;
+		float m_lastLatRef = 0.0f;
+		float m_lastLonRef = 0.0f;
+	};
+}
+
+#endif // !LodScheduler_h
@@ -20,7 +20,9 @@
 #define NetworkAircraft_h
 
 #include "XPilotAPI.h"
-#include "TerrainProbe.h"
+#include "FlightModel.h"
+#include "TerrainElevationCache.h"
+#include "TerrainHistory.h"
 #include "Utilities.h"
 #include "Vector3.hpp"
 #include "XPCAircraft.h"
@@ -47,18 +49,17 @@ namespace xpilot {
 		double NoseWheelAngle;
 	};
 
-	struct WorldPoint
+	// where an aircraft's predicted lat/lon/altitude was last converted to X-Plane's local frame,
+	// and how the local position changes per degree from there
+	struct LocalFrameAnchor
 	{
-		double Latitude;
-		double Longitude;
-	};
-
-	struct TerrainElevationData
-	{
-		int64_t Timestamp;
-		WorldPoint Location;
-		double RemoteValue;
-		double LocalValue;
+		bool Valid;
+		double Lat;
+		double Lon;
+		double AltitudeTrue;  // [ft]
+		Vector3 Position;     // [m] local
+		Vector3 PerDegreeLat; // [m/deg] local
+		Vector3 PerDegreeLon; // [m/deg] local
 	};
 
 	enum class EngineClassType
@@ -70,34 +71,13 @@ namespace xpilot {
 		Unknown
 	};
 
-	struct FlightModelInfo
-	{
-		std::string category;
-		std::string regex;
-	};
-
-	class FlightModel
-	{
-	public:
-		std::string modelCategory;
-		double GEAR_DURATION = 10000;       // [ms] time for gear up/down
-		double GEAR_DEFLECTION = 0.5;       // [m]  main gear deflection on meters during touchdown
-		double FLAPS_DURATION = 5000;       // [ms] time for full flaps extension from 0% to 100%
-
-	public:
-		static void InitializeModels();
-		static std::vector<FlightModelInfo> modelMatches;
-	};
-
-	constexpr long TERRAIN_ELEVATION_DATA_USABLE_AGE = 2000;
-	constexpr double MAX_USABLE_ALTITUDE_AGL = 100.0;
-	constexpr double TERRAIN_ELEVATION_MAX_SLOPE = 3.0;
-
 	class NetworkAircraft : public XPMP2::Aircraft
 	{
 	public:
 		NetworkAircraft(const std::string& _callsign, const AircraftVisualState& _visualState, const std::string& _icaoType,
-			const std::string& _icaoAirline, const std::string& _livery, XPMPPlaneID _modeS_id, const std::string& _modelName);
+			const std::string& _icaoAirline, const std::string& _livery, XPMPPlaneID _modeS_id, const std::string& _modelName,
+			TerrainElevationCache& _terrainCache);
+		virtual ~NetworkAircraft();
 
 		void copyBulkData(XPilotAPIAircraft::XPilotAPIBulkData* pOut, size_t size) const;
 		void copyBulkData(XPilotAPIAircraft::XPilotAPIBulkInfoTexts* pOut, size_t size) const;
@@ -105,6 +85,7 @@ namespace xpilot {
 		void UpdateErrorVectors(double currentTimestamp);
 		void RecordTerrainElevationHistory(double currentTimestamp);
 		void UpdateVelocityVectors();
+		void PrepareExtrapolation(int64_t currentTimestamp, Vector3& positionalVelocities, Vector3& rotationalVelocities);
 
 		float GetLift() const override;
 
@@ -129,13 +110,13 @@ namespace xpilot {
 
 		FlightModel flightModel;
 
-		TerrainProbe LocalTerrainProbe;
+		TerrainElevationCache& TerrainCache;
 		std::optional<double> LocalTerrainElevation = {};
 		std::optional<double> AdjustedAltitude = {};
 		double TargetTerrainOffset = 0.0;
 		double TerrainOffset = 0.0;
 		double TerrainOffsetMagnitude = 0.0;
-		std::list<TerrainElevationData> TerrainElevationHistory;
+		TerrainHistory TerrainElevationHistory;
 		bool HasUsableTerrainElevationData;
 
 		int64_t LastUpdated;
@@ -152,12 +133,35 @@ namespace xpilot {
 		int SoundChannelId;
 		EngineClassType EngineClass;
 
+		uint32_t Handle = 0; // assigned by the client in ADD_AIRCRAFT, 0 if it only uses callsigns
+
+		// see LodScheduler
+		int LodTier = 0;
+		uint32_t LodPhase = 0;
+		double LodElapsed = 0.0; // [s] since the last full update
+		bool LodDeferred = false;
+		bool IsFullUpdateDue = true;
+
+		// the next SetPredictedLocation converts to the local frame again, after a network position
+		// update or a shift of the local origin
+		void InvalidateLocalFrame() { LocalAnchor.Valid = false; }
+
+		// nothing moves or animates, so UpdatePosition leaves the aircraft alone until WakeUp()
+		bool IsParked = false;
+		void WakeUp();
+
 	protected:
 		virtual void UpdatePosition(float, int) override;
+		// scalar reference for BatchPredictor, which does the per-frame extrapolation
 		AircraftVisualState ExtrapolatePosition(Vector3 velocityVector, Vector3 rotationVector, double interval);
+		void UpdateLodPosition();
 		void PerformGroundClamping(float frameRate);
 		void EnsureAboveGround();
 		void ClearRotationalVelocities();
+		bool CanPark(int64_t currentTimestamp) const;
+		void SetPredictedLocation(double lat, double lon, double altitudeTrue);
+		void AnchorLocalFrame(double lat, double lon, double altitudeTrue);
+		LocalFrameAnchor LocalAnchor{};
 	};
 }
 
@@ -0,0 +1,44 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef PositionExtrapolation_h
+#define PositionExtrapolation_h
+
+#include "Vector3.hpp"
+
+namespace xpilot {
+	// the part of AircraftVisualState that the extrapolation moves
+	struct ExtrapolatedPose
+	{
+		double Lat;
+		double Lon;
+		double AltitudeTrue; // [ft]
+		double Pitch;        // [deg]
+		double Heading;      // [deg]
+		double Bank;         // [deg]
+	};
+
+	double NormalizeDegrees(double value, double lowerBound, double upperBound);
+
+	// Advances a pose by interval seconds of velocity [m/s] and rotation [rad/s]. This is the
+	// scalar reference that BatchPredictor::Extrapolate has to match; it doesn't use the X-Plane SDK.
+	ExtrapolatedPose ExtrapolatePose(const ExtrapolatedPose& pose, const Vector3& velocityVector,
+		const Vector3& rotationVector, double interval);
+}
+
+#endif // !PositionExtrapolation_h
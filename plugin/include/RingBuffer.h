@@ -0,0 +1,62 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef RingBuffer_h
+#define RingBuffer_h
+
+#include <array>
+#include <cstddef>
+
+namespace xpilot {
+	/**
+	 * Fixed-capacity FIFO that lives inside its owner, so pushing and popping never allocates.
+	 * Once full, a push overwrites the oldest item.
+	 */
+	template<typename T, size_t Capacity>
+	class RingBuffer
+	{
+	public:
+		void Push(const T& item) {
+			if (m_size == Capacity) {
+				PopFront();
+			}
+			m_items[(m_head + m_size) % Capacity] = item;
+			m_size++;
+		}
+
+		void PopFront() {
+			m_head = (m_head + 1) % Capacity;
+			m_size--;
+		}
+
+		// only valid while not empty
+		const T& Front() const { return m_items[m_head]; }
+		const T& Back() const { return m_items[(m_head + m_size - 1) % Capacity]; }
+
+		size_t Size() const { return m_size; }
+		bool IsEmpty() const { return m_size == 0; }
+		void Clear() { m_head = 0; m_size = 0; }
+
+	private:
+		std::array<T, Capacity> m_items{};
+		size_t m_head = 0;
+		size_t m_size = 0;
+	};
+}
+
+#endif // !RingBuffer_h
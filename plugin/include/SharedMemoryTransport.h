@@ -0,0 +1,98 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef SharedMemoryTransport_h
+#define SharedMemoryTransport_h
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace xpilot {
+	/**
+	 * Optional local transport between the plugin (host) and the client (guest): one shared
+	 * memory segment holding a single-reader ring buffer per direction, with a futex doorbell
+	 * so an idle reader sleeps in the kernel instead of polling. Messages are the same msgpack
+	 * encoded DTOs that go over nng. Only available on Linux; Open() fails elsewhere and both
+	 * ends keep using nng.
+	 *
+	 * The client builds this same file, so both ends always agree on the segment layout.
+	 * tests/SharedMemoryLatencyBenchmark.cpp compares its round trip with nng.
+	 */
+	class SharedMemoryTransport
+	{
+	public:
+		enum class Role
+		{
+			Host,
+			Guest
+		};
+
+		static constexpr const char* DEFAULT_SEGMENT_NAME = "/xpilot-ipc";
+
+		explicit SharedMemoryTransport(Role role, std::string segmentName = DEFAULT_SEGMENT_NAME);
+		~SharedMemoryTransport();
+
+		SharedMemoryTransport(const SharedMemoryTransport&) = delete;
+		SharedMemoryTransport& operator=(const SharedMemoryTransport&) = delete;
+
+		// The host creates the segment, the guest attaches to a running host. Close() must not
+		// race with Receive(), so call it from the reader thread or after it has stopped.
+		bool Open();
+		void Close();
+		bool IsOpen() const { return m_segment != nullptr; }
+
+		// Queues a message for the peer. Returns false if the peer isn't attached, in which case
+		// the caller should use nng instead. A full ring drops the message, like NNG_FLAG_NONBLOCK.
+		bool Send(const char* data, size_t size);
+
+		// Single reader only. Waits up to timeoutMs for the next message.
+		bool Receive(std::vector<char>& message, int timeoutMs);
+
+		// wakes a reader blocked in Receive()
+		void Interrupt();
+
+		// checks the peer process is still alive, at most once a second; requires an open segment
+		bool IsPeerAlive();
+
+		uint64_t GetDroppedMessages() const { return m_droppedMessages; }
+
+	private:
+		struct SegmentHeader;
+		struct RingHeader;
+
+		RingHeader& OutgoingRing() const;
+		RingHeader& IncomingRing() const;
+		uint8_t* RingData(const RingHeader& ring) const;
+
+		Role m_role;
+		std::string m_segmentName;
+		SegmentHeader* m_segment = nullptr;
+		size_t m_segmentSize = 0;
+		std::mutex m_sendMutex;
+		std::atomic_bool m_interrupted{ false };
+		std::atomic<int64_t> m_lastPeerCheck{ 0 };
+		std::atomic_bool m_peerAlive{ false };
+		std::atomic<uint64_t> m_droppedMessages{ 0 };
+	};
+}
+
+#endif // !SharedMemoryTransport_h
@@ -0,0 +1,81 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef SpscQueue_h
+#define SpscQueue_h
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+namespace xpilot {
+	/**
+	 * Bounded lock-free queue for exactly one producer thread and one consumer thread.
+	 * Slots are allocated up front, so neither side allocates or blocks.
+	 */
+	template<typename T>
+	class SpscQueue
+	{
+	public:
+		explicit SpscQueue(size_t capacity) :
+			m_buffer(capacity + 1) {
+		}
+
+		SpscQueue(const SpscQueue&) = delete;
+		SpscQueue& operator=(const SpscQueue&) = delete;
+
+		// producer only; returns false if the queue is full
+		bool Push(T&& item) {
+			const size_t tail = m_tail.load(std::memory_order_relaxed);
+			const size_t next = Next(tail);
+			if (next == m_head.load(std::memory_order_acquire)) {
+				return false;
+			}
+			m_buffer[tail] = std::move(item);
+			m_tail.store(next, std::memory_order_release);
+			return true;
+		}
+
+		// consumer only; returns false if the queue is empty
+		bool Pop(T& item) {
+			const size_t head = m_head.load(std::memory_order_relaxed);
+			if (head == m_tail.load(std::memory_order_acquire)) {
+				return false;
+			}
+			item = std::move(m_buffer[head]);
+			m_buffer[head] = T();
+			m_head.store(Next(head), std::memory_order_release);
+			return true;
+		}
+
+		bool IsEmpty() const {
+			return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+		}
+
+	private:
+		size_t Next(size_t index) const {
+			return (index + 1) == m_buffer.size() ? 0 : index + 1;
+		}
+
+		std::vector<T> m_buffer;
+		alignas(64) std::atomic<size_t> m_head{ 0 };
+		alignas(64) std::atomic<size_t> m_tail{ 0 };
+	};
+}
+
+#endif // !SpscQueue_h
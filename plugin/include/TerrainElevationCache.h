@@ -0,0 +1,91 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef TerrainElevationCache_h
+#define TerrainElevationCache_h
+
+#include "TerrainProbe.h"
+#include "DataRefAccess.h"
+#include "OwnedDataRef.h"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+namespace xpilot {
+	/**
+	 * Terrain elevation shared by all network aircraft. Elevation is probed on a fixed lat/lon
+	 * grid (about 27 m between nodes) and interpolated bilinearly, so aircraft parked at the same
+	 * airport reuse each other's probes instead of probing every frame.
+	 *
+	 * Samples are re-probed after a while, sooner where no scenery was loaded yet, and the whole
+	 * grid is dropped when X-Plane shifts its local coordinate origin, since that reloads scenery.
+	 * New probes are capped per frame; past the cap, lookups fall back to older or neighbouring
+	 * samples. Counters are published as xpilot/stats/terrain_cache_... datarefs.
+	 */
+	class TerrainElevationCache
+	{
+	public:
+		TerrainElevationCache();
+
+		TerrainElevationCache(const TerrainElevationCache&) = delete;
+		TerrainElevationCache& operator=(const TerrainElevationCache&) = delete;
+
+		// [ft], X-Plane thread only. Empty if none of the surrounding samples found scenery (or
+		// none could be probed yet); unlike the old per-aircraft probe this doesn't report 0 ft
+		// then, so aircraft aren't clamped to sea level where no scenery is loaded.
+		std::optional<double> GetTerrainElevation(double degLat, double degLon);
+
+		// once per frame: resets the probe budget, handles invalidation and publishes the counters
+		void Update(float elapsedSinceLastCall);
+
+	private:
+		struct Sample
+		{
+			double Elevation;
+			int64_t ProbedAt;
+			bool HitTerrain;
+		};
+
+		const Sample* GetSample(int64_t latIndex, int64_t lonIndex, int64_t now, bool& missed);
+
+		TerrainProbe m_probe;
+		std::unordered_map<uint64_t, Sample> m_samples;
+		int m_probeBudget = 0;
+		float m_publishTimer = 0.0f;
+		int64_t m_lastSweep = 0;
+		float m_lastLatRef = 0.0f;
+		float m_lastLonRef = 0.0f;
+
+		uint64_t m_hits = 0;
+		uint64_t m_misses = 0;
+		uint64_t m_probes = 0;
+		uint64_t m_deferred = 0;
+
+		DataRefAccess<float> m_latRef;
+		DataRefAccess<float> m_lonRef;
+
+		OwnedDataRef<int> m_hitsRef;
+		OwnedDataRef<int> m_missesRef;
+		OwnedDataRef<int> m_probesRef;
+		OwnedDataRef<int> m_deferredRef;
+		OwnedDataRef<int> m_sizeRef;
+	};
+}
+
+#endif // !TerrainElevationCache_h
@@ -0,0 +1,67 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef TerrainHistory_h
+#define TerrainHistory_h
+
+#include "RingBuffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace xpilot {
+	struct WorldPoint
+	{
+		double Latitude;
+		double Longitude;
+	};
+
+	struct TerrainElevationData
+	{
+		int64_t Timestamp;
+		WorldPoint Location;
+		double RemoteValue;
+		double LocalValue;
+	};
+
+	constexpr long TERRAIN_ELEVATION_DATA_USABLE_AGE = 2000;
+	constexpr double MAX_USABLE_ALTITUDE_AGL = 100.0;
+	constexpr double TERRAIN_ELEVATION_MAX_SLOPE = 3.0;
+	constexpr size_t TERRAIN_ELEVATION_HISTORY_CAPACITY = 64; // well over TERRAIN_ELEVATION_DATA_USABLE_AGE worth of position updates
+
+	/**
+	 * The last TERRAIN_ELEVATION_DATA_USABLE_AGE of terrain samples under a network aircraft, used to
+	 * decide whether the local terrain is flat enough to trust for ground clamping. Samples are kept
+	 * inline, so recording never allocates.
+	 */
+	class TerrainHistory
+	{
+	public:
+		// Adds a sample taken at the given position and drops the outdated ones. Returns whether
+		// the history now spans enough time with a gentle enough slope to be used.
+		bool Record(double timestamp, double lat, double lon, std::optional<double> altitudeAgl, double localElevation);
+
+		size_t Size() const { return m_samples.Size(); }
+
+	private:
+		RingBuffer<TerrainElevationData, TERRAIN_ELEVATION_HISTORY_CAPACITY> m_samples;
+	};
+}
+
+#endif // !TerrainHistory_h
@@ -23,6 +23,7 @@
 #include <XPLMGraphics.h>
 
 #include <array>
+#include <optional>
 
 namespace xpilot {
 	class TerrainProbe
@@ -30,7 +31,8 @@ namespace xpilot {
 	public:
 		TerrainProbe();
 		~TerrainProbe();
-		double GetTerrainElevation(double degLat, double degLon)const;
+		// [ft], empty if there's no terrain loaded at that location
+		std::optional<double> GetTerrainElevation(double degLat, double degLon)const;
 	private:
 		XPLMProbeRef m_probeRef = nullptr;
 	};
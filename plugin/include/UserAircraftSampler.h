@@ -0,0 +1,74 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef UserAircraftSampler_h
+#define UserAircraftSampler_h
+
+#include "DataRefAccess.h"
+#include "Dto.h"
+
+#include <vector>
+
+namespace xpilot {
+	/**
+	 * Reads the user aircraft's position, attitude, velocities and configuration in a single
+	 * pass, so the client gets a consistent, double precision snapshot instead of assembling one
+	 * from RREF packets that deliver every value as a float.
+	 */
+	class UserAircraftSampler
+	{
+	public:
+		UserAircraftSampler();
+
+		// X-Plane thread only
+		void Sample(UserAircraftStateDto& state) const;
+
+	protected:
+		DataRefAccess<double> m_latitude;
+		DataRefAccess<double> m_longitude;
+		DataRefAccess<double> m_elevation;
+		DataRefAccess<float> m_altitudeAgl;
+		DataRefAccess<float> m_pressureAltitude;
+		DataRefAccess<float> m_barometerSeaLevel;
+		DataRefAccess<float> m_pitch;
+		DataRefAccess<float> m_heading;
+		DataRefAccess<float> m_bank;
+		DataRefAccess<float> m_localVx;
+		DataRefAccess<float> m_localVy;
+		DataRefAccess<float> m_localVz;
+		DataRefAccess<float> m_pitchRate;
+		DataRefAccess<float> m_headingRate;
+		DataRefAccess<float> m_bankRate;
+		DataRefAccess<float> m_groundSpeed;
+		DataRefAccess<std::vector<float>> m_tireSteerAngle;
+		DataRefAccess<int> m_engineCount;
+		DataRefAccess<std::vector<int>> m_engineRunning;
+		DataRefAccess<std::vector<int>> m_enginePropMode;
+		DataRefAccess<int> m_onGround;
+		DataRefAccess<int> m_gearHandle;
+		DataRefAccess<float> m_flapRatio;
+		DataRefAccess<float> m_speedbrakeRatio;
+		DataRefAccess<int> m_beaconLights;
+		DataRefAccess<int> m_landingLights;
+		DataRefAccess<int> m_taxiLights;
+		DataRefAccess<int> m_navLights;
+		DataRefAccess<int> m_strobeLights;
+	};
+}
+
+#endif // !UserAircraftSampler_h
@@ -0,0 +1,74 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef WorkerPool_h
+#define WorkerPool_h
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xpilot {
+	/**
+	 * A small fork-join pool: Run hands out numbered chunks of work to the worker threads and
+	 * the calling thread alike and returns once every chunk is done, so the caller can treat it
+	 * like a plain loop. Workers are started lazily and sleep between runs.
+	 */
+	class WorkerPool
+	{
+	public:
+		WorkerPool() = default;
+		~WorkerPool();
+
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		// total number of threads working on a run, including the calling thread; 1 runs everything inline
+		void SetThreadCount(size_t threads);
+		size_t GetThreadCount() const { return m_threads.size() + 1; }
+
+		// calls job(chunk) for every chunk in [0, chunks) and waits for all of them
+		void Run(size_t chunks, const std::function<void(size_t)>& job);
+
+		// splits [0, count) into at most one range per thread, each at least minCount long and
+		// starting at a multiple of granularity, and calls job(begin, end) for every range. The
+		// ranges depend on the thread count only, so with one thread it is a single inline call.
+		void RunRanges(size_t count, size_t granularity, size_t minCount, const std::function<void(size_t, size_t)>& job);
+
+		// joins the worker threads; the next SetThreadCount starts them again
+		void Stop();
+
+	private:
+		void Work();
+
+		std::vector<std::thread> m_threads;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_done;
+		const std::function<void(size_t)>* m_job = nullptr;
+		size_t m_chunks = 0;
+		size_t m_nextChunk = 0;
+		size_t m_pending = 0;
+		bool m_stopping = false;
+	};
+}
+
+#endif // !WorkerPool_h
@@ -32,11 +32,16 @@
 #include "Utilities.h"
 
 #include "Dto.h"
+#include "SpscQueue.h"
+#include "SharedMemoryTransport.h"
+#include "IpcStats.h"
+#include "UserAircraftSampler.h"
 #include <msgpack.hpp>
 
 #include <nng/nng.h>
 #include <nng/protocol/pair1/pair.h>
 
+#include <array>
 #include <deque>
 #include <thread>
 #include <mutex>
@@ -47,15 +52,10 @@
 #include <iostream>
 
 namespace xpilot {
-	enum class dataRefs
-	{
-		DR_BULK_QUICK,
-		DR_BULK_EXPENSIVE,
-		DR_NUM_AIRCRAFT
-	};
-
 	class FrameRateMonitor;
+	class BulkDataSnapshot;
 	class AircraftManager;
+	class AircraftStateQueue;
 	class NotificationPanel;
 	class TextMessageConsole;
 	class NearbyATCWindow;
@@ -141,15 +141,40 @@ namespace xpilot {
 		std::unique_ptr<std::thread> m_socketThread;
 
 		void SocketWorker();
-		void ProcessPacket(const BaseDto& dto);
-
-		std::mutex m_mutex;
-		std::deque<std::function<void()>> m_queuedCallbacks;
+		void SharedMemoryWorker();
+		void HandleMessage(const char* data, size_t size);
+
+		// used instead of nng while a local client is attached to it
+		std::unique_ptr<SharedMemoryTransport> m_sharedMemory;
+		std::unique_ptr<std::thread> m_sharedMemoryThread;
+		std::mutex m_receiveMutex; // both receive threads feed the same single-producer queues
+		MessageStamp m_receivedStamp; // of the message being handled, guarded by m_receiveMutex
+		void RegisterPacketHandlers();
+		void ProcessPacket(MessageId id, const msgpack::object& packet);
+
+		typedef std::function<void(const msgpack::object&)> PacketHandler;
+		std::array<PacketHandler, static_cast<size_t>(MessageId::Count)> m_packetHandlers;
+		std::atomic_bool m_compactMessages{ false };
+
+		// callbacks from the socket thread go through a lock-free queue, callbacks queued by
+		// X-Plane's own thread (e.g. from a window) are simply deferred to the next flight loop
+		std::thread::id m_xplaneThread;
+		SpscQueue<std::function<void()>> m_socketCallbacks{ 4096 };
+		std::deque<std::function<void()>> m_deferredCallbacks;
 		void InvokeQueuedCallbacks();
-		void QueueCallback(const std::function<void()>& cb);
+		void QueueCallback(std::function<void()> cb);
 
-		XPLMDataRef m_bulkDataQuick{}, m_bulkDataExpensive{};
-		static int GetBulkData(void* inRefcon, void* outData, int inStartPos, int inNumBytes);
+		// latest position, config and heartbeat per aircraft handle, applied once per frame
+		std::unique_ptr<AircraftStateQueue> m_aircraftStates;
+
+		std::unique_ptr<IpcStats> m_ipcStats;
+
+		// streamed to the client every frame once it has asked for it in the handshake
+		std::unique_ptr<UserAircraftSampler> m_userAircraftSampler;
+		std::atomic_bool m_streamUserAircraftState{ false };
+		UserAircraftStateDto m_userAircraftState{};
+
+		std::unique_ptr<BulkDataSnapshot> m_bulkDataSnapshot;
 
 		std::unique_ptr<FrameRateMonitor> m_frameRateMonitor;
 		std::unique_ptr<AircraftManager> m_aircraftManager;
@@ -160,13 +185,16 @@ namespace xpilot {
 
 		template<class T>
 		void SendDto(const T& dto) {
-			msgpack::sbuffer dtoBuf;
-			if (encodeDto(dtoBuf, dto)) {
-				if (dtoBuf.size() == 0)
+			// reused by every send on this thread, so encoding doesn't allocate once it has grown
+			thread_local msgpack::sbuffer dtoBuf;
+			dtoBuf.clear();
+
+			if (encodeDto(dtoBuf, dto, m_compactMessages)) {
+				if (m_sharedMemory && m_sharedMemory->Send(dtoBuf.data(), dtoBuf.size()))
 					return;
 
-				std::vector<unsigned char> dgBuffer(dtoBuf.data(), dtoBuf.data() + dtoBuf.size());
-				nng_send(_socket, reinterpret_cast<char*>(dgBuffer.data()), dgBuffer.size(), NNG_FLAG_NONBLOCK);
+				if (nng_send(_socket, dtoBuf.data(), dtoBuf.size(), NNG_FLAG_NONBLOCK) != 0)
+					m_ipcStats->RecordSendDropped();
 			}
 		}
 	};
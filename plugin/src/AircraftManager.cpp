@@ -22,6 +22,7 @@
 #include "GeoCalc.hpp"
 #include "Quaternion.hpp"
 #include "XPilot.h"
+#include <algorithm>
 #include <chrono>
 
 namespace xpilot {
@@ -52,7 +53,9 @@ namespace xpilot {
 		m_environmentVolumeRatio("sim/operation/sound/enviro_volume_ratio", ReadOnly),
 		m_isViewExternal("sim/graphics/view/view_is_external", ReadOnly),
 		m_canopyOpenRatio("sim/operation/sound/users_canopy_open_ratio", ReadOnly),
-		m_userDoorOpenRatio("sim/operation/sound/users_door_open_ratio", ReadOnly) {
+		m_userDoorOpenRatio("sim/operation/sound/users_door_open_ratio", ReadOnly),
+		m_userLatitude("sim/flightmodel/position/latitude", ReadOnly),
+		m_userLongitude("sim/flightmodel/position/longitude", ReadOnly) {
 		FlightModel::InitializeModels();
 
 		m_audioEngine = std::make_unique<CAudioEngine>();
@@ -73,16 +76,52 @@ namespace xpilot {
 		XPMPUnregisterPlaneNotifierFunc(&AircraftManager::AircraftNotifierCallback, nullptr);
 	}
 
-	void AircraftManager::HandleAddPlane(const std::string& callsign, const AircraftVisualState& visualState,
+	void AircraftManager::HandleAddPlane(const std::string& callsign, uint32_t handle, const AircraftVisualState& visualState,
 		const std::string& airline, const std::string& typeCode) {
 		auto planeIt = mapPlanes.find(callsign);
 		if (planeIt != mapPlanes.end()) {
-			HandleRemovePlane(callsign); // remove plane, the client will try adding it again
+			HandleRemovePlane(0, callsign); // remove plane, the client will try adding it again
 			return;
 		}
+		if (GetPendingAircraft(0, callsign)) {
+			HandleRemovePlane(0, callsign);
+			return;
+		}
+
+		if (handle >= MAX_AIRCRAFT_HANDLES) {
+			LOG_MSG(logERROR, "Invalid aircraft handle %u for %s", handle, callsign.c_str());
+			return;
+		}
+
+		auto pending = std::make_unique<PendingAircraft>();
+		pending->Callsign = callsign;
+		pending->Handle = handle;
+		pending->Airline = airline;
+		pending->TypeCode = typeCode;
+		pending->VisualState = visualState;
+
+		if (handle > 0) {
+			if (handle >= m_pendingSlots.size()) {
+				m_pendingSlots.resize(handle + 1, nullptr);
+			}
+			m_pendingSlots[handle] = pending.get();
+		}
+		m_pendingAircraft.push_back(std::move(pending));
+	}
 
-		NetworkAircraft* plane = new NetworkAircraft(callsign.c_str(), visualState, typeCode.c_str(), airline.c_str(), "", 0, "");
-		mapPlanes.emplace(callsign, std::move(plane));
+	void AircraftManager::CreateAircraft(const PendingAircraft& pending) {
+		const uint32_t handle = pending.Handle;
+		NetworkAircraft* plane = new NetworkAircraft(pending.Callsign.c_str(), pending.VisualState, pending.TypeCode.c_str(),
+			pending.Airline.c_str(), "", 0, "", m_terrainCache);
+		mapPlanes.emplace(pending.Callsign, std::move(plane));
+
+		if (plane && handle > 0) {
+			if (handle >= m_aircraftSlots.size()) {
+				m_aircraftSlots.resize(handle + 1, nullptr);
+			}
+			m_aircraftSlots[handle] = plane;
+			plane->Handle = handle;
+		}
 
 		if (plane) {
 			std::string engineSound = "JetEngine";
@@ -104,87 +143,182 @@ namespace xpilot {
 				break;
 			}
 			plane->SoundChannelId = m_audioEngine->CreateSoundChannel(engineSound, 1.0f);
+
+			// whatever arrived while the aircraft was waiting to be created
+			if (pending.HasPosition) {
+				HandleFastPositionUpdate(handle, pending.Callsign, pending.VisualState, pending.PositionalVelocities,
+					pending.RotationalVelocities, pending.Speed);
+			}
+			if (pending.HasConfig) {
+				HandleAircraftConfig(handle, pending.Callsign, pending.Config);
+			}
 		}
 	}
 
-	void AircraftManager::HandleAircraftConfig(const std::string& callsign, const AircraftConfigDto& config) {
-		auto planeIt = mapPlanes.find(callsign);
-		if (planeIt == mapPlanes.end()) return;
+	void AircraftManager::CreatePendingAircraft(std::chrono::steady_clock::time_point deadline) {
+		if (m_pendingAircraft.empty()) return;
+
+		// nearest to the user at the back, so they are created first
+		const double userLat = m_userLatitude;
+		const double userLon = m_userLongitude;
+		for (auto& pending : m_pendingAircraft) {
+			pending->UserDistance = GreatCircleDistance(userLon, userLat, pending->VisualState.Lon, pending->VisualState.Lat);
+		}
+		std::sort(m_pendingAircraft.begin(), m_pendingAircraft.end(), [](const auto& a, const auto& b) {
+			return a->UserDistance > b->UserDistance;
+		});
+
+		// at least one per frame, however slow
+		do {
+			std::unique_ptr<PendingAircraft> pending = std::move(m_pendingAircraft.back());
+			m_pendingAircraft.pop_back();
+			ReleasePendingHandle(pending.get());
+			CreateAircraft(*pending);
+		} while (!m_pendingAircraft.empty() && std::chrono::steady_clock::now() < deadline);
+	}
+
+	PendingAircraft* AircraftManager::GetPendingAircraft(uint32_t handle, const std::string& callsign) {
+		if (handle > 0) {
+			return handle < m_pendingSlots.size() ? m_pendingSlots[handle] : nullptr;
+		}
+
+		auto it = std::find_if(m_pendingAircraft.begin(), m_pendingAircraft.end(), [&](const auto& pending) {
+			return pending->Callsign == callsign;
+		});
+		return it != m_pendingAircraft.end() ? it->get() : nullptr;
+	}
+
+	void AircraftManager::ReleasePendingHandle(const PendingAircraft* pending) {
+		if (pending->Handle > 0 && pending->Handle < m_pendingSlots.size() && m_pendingSlots[pending->Handle] == pending) {
+			m_pendingSlots[pending->Handle] = nullptr;
+		}
+	}
+
+	void AircraftManager::QueueAircraftConfig(uint32_t handle, const AircraftConfig& config) {
+		m_queuedConfigs.Push({ handle, config });
+	}
+
+	void AircraftManager::ApplyQueuedConfigs(std::chrono::steady_clock::time_point deadline) {
+		m_queuedConfigs.Drain([&](const std::pair<uint32_t, AircraftConfig>& queued) {
+			HandleAircraftConfig(queued.first, {}, queued.second);
+			return std::chrono::steady_clock::now() < deadline;
+		});
+	}
+
+	void AircraftManager::DiscardQueuedConfigs(uint32_t handle) {
+		if (handle == 0) return;
+		m_queuedConfigs.RemoveIf([handle](const auto& queued) {
+			return queued.first == handle;
+		});
+	}
+
+	void AircraftManager::HandleAircraftConfig(uint32_t handle, const std::string& callsign, const AircraftConfig& config) {
+		NetworkAircraft* plane = GetAircraft(handle, callsign);
+		if (!plane) {
+			if (PendingAircraft* pending = GetPendingAircraft(handle, callsign)) {
+				pending->Config.Merge(config);
+				pending->HasConfig = true;
+			}
+			return;
+		}
 
-		NetworkAircraft* plane = planeIt->second.get();
-		if (!plane) return;
+		plane->WakeUp();
 
-		if (config.flaps.has_value()) {
-			if (config.flaps.value() != plane->TargetFlapsPosition) {
-				plane->TargetFlapsPosition = config.flaps.value();
+		if (config.Flaps.has_value()) {
+			if (config.Flaps.value() != plane->TargetFlapsPosition) {
+				plane->TargetFlapsPosition = config.Flaps.value();
 			}
 		}
-		if (config.gearDown.has_value()) {
-			if (config.gearDown.value() != plane->IsGearDown) {
-				plane->IsGearDown = config.gearDown.value();
+		if (config.GearDown.has_value()) {
+			if (config.GearDown.value() != plane->IsGearDown) {
+				plane->IsGearDown = config.GearDown.value();
 			}
 		}
-		if (config.spoilersDeployed.has_value()) {
-			if (config.spoilersDeployed.value() != plane->IsSpoilersDeployed) {
-				plane->IsSpoilersDeployed = config.spoilersDeployed.value();
+		if (config.SpoilersDeployed.has_value()) {
+			if (config.SpoilersDeployed.value() != plane->IsSpoilersDeployed) {
+				plane->IsSpoilersDeployed = config.SpoilersDeployed.value();
 			}
 		}
-		if (config.strobeLightsOn.has_value()) {
-			if (config.strobeLightsOn.value() != plane->Surfaces.lights.strbLights) {
-				plane->Surfaces.lights.strbLights = config.strobeLightsOn.value();
+		if (config.StrobeLightsOn.has_value()) {
+			if (config.StrobeLightsOn.value() != plane->Surfaces.lights.strbLights) {
+				plane->Surfaces.lights.strbLights = config.StrobeLightsOn.value();
 			}
 		}
-		if (config.taxiLightsOn.has_value()) {
-			if (config.taxiLightsOn.value() != plane->Surfaces.lights.taxiLights) {
-				plane->Surfaces.lights.taxiLights = config.taxiLightsOn.value();
+		if (config.TaxiLightsOn.has_value()) {
+			if (config.TaxiLightsOn.value() != plane->Surfaces.lights.taxiLights) {
+				plane->Surfaces.lights.taxiLights = config.TaxiLightsOn.value();
 			}
 		}
-		if (config.navLightsOn.has_value()) {
-			if (config.navLightsOn.value() != plane->Surfaces.lights.navLights) {
-				plane->Surfaces.lights.navLights = config.navLightsOn.value();
+		if (config.NavLightsOn.has_value()) {
+			if (config.NavLightsOn.value() != plane->Surfaces.lights.navLights) {
+				plane->Surfaces.lights.navLights = config.NavLightsOn.value();
 			}
 		}
-		if (config.landingLightsOn.has_value()) {
-			if (config.landingLightsOn.value() != plane->Surfaces.lights.landLights) {
-				plane->Surfaces.lights.landLights = config.landingLightsOn.value();
+		if (config.LandingLightsOn.has_value()) {
+			if (config.LandingLightsOn.value() != plane->Surfaces.lights.landLights) {
+				plane->Surfaces.lights.landLights = config.LandingLightsOn.value();
 			}
 		}
-		if (config.beaconLightsOn.has_value()) {
-			if (config.beaconLightsOn.value() != plane->Surfaces.lights.bcnLights) {
-				plane->Surfaces.lights.bcnLights = config.beaconLightsOn.value();
+		if (config.BeaconLightsOn.has_value()) {
+			if (config.BeaconLightsOn.value() != plane->Surfaces.lights.bcnLights) {
+				plane->Surfaces.lights.bcnLights = config.BeaconLightsOn.value();
 			}
 		}
-		if (config.enginesOn.has_value()) {
-			if (config.enginesOn.value() != plane->IsEnginesRunning) {
-				plane->IsEnginesRunning = config.enginesOn.value();
+		if (config.EnginesOn.has_value()) {
+			if (config.EnginesOn.value() != plane->IsEnginesRunning) {
+				plane->IsEnginesRunning = config.EnginesOn.value();
 			}
 		}
-		if (config.enginesReversing.has_value()) {
-			if (config.enginesReversing.value() != plane->IsEnginesReversing) {
-				plane->IsEnginesReversing = config.enginesReversing.value();
+		if (config.EnginesReversing.has_value()) {
+			if (config.EnginesReversing.value() != plane->IsEnginesReversing) {
+				plane->IsEnginesReversing = config.EnginesReversing.value();
 			}
 		}
-		if (config.onGround.has_value()) {
-			if (config.onGround.value() != plane->IsReportedOnGround) {
-				plane->IsReportedOnGround = config.onGround.value();
+		if (config.OnGround.has_value()) {
+			if (config.OnGround.value() != plane->IsReportedOnGround) {
+				plane->IsReportedOnGround = config.OnGround.value();
 			}
 		}
 	}
 
-	void AircraftManager::HandleRemovePlane(const std::string& callsign) {
-		auto aircraft = GetAircraft(callsign);
+	void AircraftManager::HandleRemovePlane(uint32_t handle, const std::string& callsign) {
+		if (PendingAircraft* pending = GetPendingAircraft(handle, callsign)) {
+			DiscardQueuedConfigs(pending->Handle);
+			ReleasePendingHandle(pending);
+			m_pendingAircraft.erase(std::find_if(m_pendingAircraft.begin(), m_pendingAircraft.end(), [pending](const auto& queued) {
+				return queued.get() == pending;
+			}));
+			return;
+		}
+
+		auto aircraft = GetAircraft(handle, callsign);
 		if (!aircraft) return;
 
+		// the callsign might not have been sent along with the handle
+		const std::string planeCallsign = aircraft->label;
+
 		m_audioEngine->StopChannel(aircraft->SoundChannelId);
-		mapPlanes.erase(callsign);
-		mEnv->AircraftDeleted(callsign);
+		ReleaseHandle(aircraft);
+		mapPlanes.erase(planeCallsign);
+		mEnv->AircraftDeleted(planeCallsign);
 	}
 
 	void AircraftManager::RemoveAllPlanes() {
 		m_audioEngine->StopAllChannels();
+		m_pendingAircraft.clear();
+		m_pendingSlots.clear();
+		m_queuedConfigs.Clear();
+		m_aircraftSlots.clear();
 		mapPlanes.clear();
 	}
 
+	void AircraftManager::ReleaseHandle(const NetworkAircraft* aircraft) {
+		DiscardQueuedConfigs(aircraft->Handle);
+		if (aircraft->Handle > 0 && aircraft->Handle < m_aircraftSlots.size() && m_aircraftSlots[aircraft->Handle] == aircraft) {
+			m_aircraftSlots[aircraft->Handle] = nullptr;
+		}
+	}
+
 	float AircraftManager::AircraftMaintenanceCallback(float, float inElapsedTimeSinceLastFlightLoop, int, void* ref) {
 		auto* instance = static_cast<AircraftManager*>(ref);
 
@@ -204,9 +338,13 @@ namespace xpilot {
 				}
 			}
 			for (auto plane : stalePlanes) {
+				instance->m_audioEngine->StopChannel(mapPlanes[plane]->SoundChannelId);
+				instance->ReleaseHandle(mapPlanes[plane].get());
 				mapPlanes.erase(plane);
 			}
 
+			instance->m_terrainCache.Update(inElapsedTimeSinceLastFlightLoop);
+
 			float soundVolume = 1.0f;
 			float doorSum = 0;
 			bool anyDoorOpen = false;
@@ -232,22 +370,23 @@ namespace xpilot {
 			XPLMCameraPosition_t camera;
 			XPLMReadCameraPosition(&camera);
 
+			instance->m_soundUpdates.clear();
 			for (mapPlanesTy::iterator iter = mapPlanes.begin(); iter != mapPlanes.end(); ++iter) {
-				int channel = iter->second->SoundChannelId;
-
-				AudioVector3 soundPos{};
-				soundPos.x = camera.x - iter->second->drawInfo.x;
-				soundPos.y = camera.y - iter->second->drawInfo.y;
-				soundPos.z = camera.z - iter->second->drawInfo.z;
-
-				if (instance->m_audioEngine != nullptr && soundPos.isNonZero()) {
-					instance->m_audioEngine->SetChannel3dPosition(channel, soundPos);
-					instance->m_audioEngine->SetChannelPaused(channel, ShouldPauseSound || !iter->second->IsEnginesRunning);
-					instance->m_audioEngine->SetChannelVolume(channel, soundVolume);
+				ChannelUpdate update{};
+				update.channelId = iter->second->SoundChannelId;
+				update.position.x = camera.x - iter->second->drawInfo.x;
+				update.position.y = camera.y - iter->second->drawInfo.y;
+				update.position.z = camera.z - iter->second->drawInfo.z;
+				update.volume = soundVolume;
+				update.audible = !ShouldPauseSound && iter->second->IsEnginesRunning;
+
+				if (update.position.isNonZero()) {
+					instance->m_soundUpdates.push_back(update);
 				}
 			}
 
 			if (instance->m_audioEngine != nullptr) {
+				instance->m_audioEngine->UpdateChannels(instance->m_soundUpdates, Config::GetInstance().GetEngineSoundVoices());
 				instance->m_audioEngine->SetListenerPosition();
 				instance->m_audioEngine->Update();
 			}
@@ -269,11 +408,19 @@ namespace xpilot {
 		}
 	}
 
-	void AircraftManager::HandleFastPositionUpdate(const std::string& callsign, const AircraftVisualState& visualState,
+	void AircraftManager::HandleFastPositionUpdate(uint32_t handle, const std::string& callsign, const AircraftVisualState& visualState,
 		Vector3 positionalVector, Vector3 rotationalVector, double speed) {
-		auto aircraft = GetAircraft(callsign);
-		if (!aircraft)
+		auto aircraft = GetAircraft(handle, callsign);
+		if (!aircraft) {
+			if (PendingAircraft* pending = GetPendingAircraft(handle, callsign)) {
+				pending->VisualState = visualState;
+				pending->PositionalVelocities = positionalVector;
+				pending->RotationalVelocities = rotationalVector;
+				pending->Speed = speed;
+				pending->HasPosition = true;
+			}
 			return;
+		}
 
 		aircraft->PositionalVelocities = positionalVector;
 		aircraft->RotationalVelocities = rotationalVector;
@@ -282,8 +429,15 @@ namespace xpilot {
 		aircraft->UpdateVelocityVectors();
 	}
 
-	void AircraftManager::HandleHeartbeat(const std::string& callsign) {
-		auto aircraft = GetAircraft(callsign);
+	void AircraftManager::HandlePositionFrame(const PositionFrame& frame) {
+		for (const auto& update : frame) {
+			HandleFastPositionUpdate(update.Handle, update.Callsign, update.VisualState,
+				update.PositionalVelocities, update.RotationalVelocities, update.Speed);
+		}
+	}
+
+	void AircraftManager::HandleHeartbeat(uint32_t handle, const std::string& callsign) {
+		auto aircraft = GetAircraft(handle, callsign);
 		if (!aircraft)
 			return;
 
@@ -295,4 +449,11 @@ namespace xpilot {
 		if (planeIt == mapPlanes.end()) return nullptr;
 		return planeIt->second.get();
 	}
+
+	NetworkAircraft* AircraftManager::GetAircraft(uint32_t handle, const std::string& callsign) {
+		if (handle > 0) {
+			return handle < m_aircraftSlots.size() ? m_aircraftSlots[handle] : nullptr;
+		}
+		return GetAircraft(callsign);
+	}
 }
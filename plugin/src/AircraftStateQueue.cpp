@@ -0,0 +1,142 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "AircraftStateQueue.h"
+
+#include <thread>
+
+namespace xpilot {
+	AircraftConfig AircraftConfig::FromDto(const AircraftConfigDto& dto) {
+		AircraftConfig config{};
+		config.EnginesOn = dto.enginesOn;
+		config.EnginesReversing = dto.enginesReversing;
+		config.OnGround = dto.onGround;
+		config.Flaps = dto.flaps;
+		config.SpoilersDeployed = dto.spoilersDeployed;
+		config.GearDown = dto.gearDown;
+		config.BeaconLightsOn = dto.beaconLightsOn;
+		config.LandingLightsOn = dto.landingLightsOn;
+		config.NavLightsOn = dto.navLightsOn;
+		config.StrobeLightsOn = dto.strobeLightsOn;
+		config.TaxiLightsOn = dto.taxiLightsOn;
+		return config;
+	}
+
+	void AircraftConfig::Merge(const AircraftConfig& newer) {
+		if (newer.EnginesOn.has_value()) EnginesOn = newer.EnginesOn;
+		if (newer.EnginesReversing.has_value()) EnginesReversing = newer.EnginesReversing;
+		if (newer.OnGround.has_value()) OnGround = newer.OnGround;
+		if (newer.Flaps.has_value()) Flaps = newer.Flaps;
+		if (newer.SpoilersDeployed.has_value()) SpoilersDeployed = newer.SpoilersDeployed;
+		if (newer.GearDown.has_value()) GearDown = newer.GearDown;
+		if (newer.BeaconLightsOn.has_value()) BeaconLightsOn = newer.BeaconLightsOn;
+		if (newer.LandingLightsOn.has_value()) LandingLightsOn = newer.LandingLightsOn;
+		if (newer.NavLightsOn.has_value()) NavLightsOn = newer.NavLightsOn;
+		if (newer.StrobeLightsOn.has_value()) StrobeLightsOn = newer.StrobeLightsOn;
+		if (newer.TaxiLightsOn.has_value()) TaxiLightsOn = newer.TaxiLightsOn;
+	}
+
+	AircraftStateQueue::AircraftStateQueue() :
+		m_slots(new Slot[MAX_AIRCRAFT_HANDLES]),
+		m_applied(MAX_AIRCRAFT_HANDLES, AppliedRevisions{}),
+		m_pendingHandles(MAX_AIRCRAFT_HANDLES) {
+	}
+
+	template<typename F>
+	void AircraftStateQueue::Write(uint32_t handle, F&& update) {
+		Slot& slot = m_slots[handle];
+
+		const uint32_t sequence = slot.Sequence.load(std::memory_order_relaxed);
+		slot.Sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		update(slot.State);
+
+		slot.Sequence.store(sequence + 2, std::memory_order_release);
+
+		// a handle is only queued once until the flight loop picks it up, so the queue can't overflow
+		if (!slot.Queued.exchange(true)) {
+			m_pendingHandles.Push(std::move(handle));
+		}
+	}
+
+	void AircraftStateQueue::Read(const Slot& slot, AircraftState& state) {
+		uint32_t sequence;
+		do {
+			sequence = slot.Sequence.load(std::memory_order_acquire);
+			if (sequence & 1) {
+				std::this_thread::yield(); // socket thread is mid-write
+				continue;
+			}
+			state = slot.State;
+			std::atomic_thread_fence(std::memory_order_acquire);
+		} while ((sequence & 1) || slot.Sequence.load(std::memory_order_relaxed) != sequence);
+	}
+
+	void AircraftStateQueue::PostPosition(uint32_t handle, const AircraftVisualState& visualState,
+		const Vector3& positionalVelocities, const Vector3& rotationalVelocities, double speed, int64_t sentAt) {
+		if (!IsValidHandle(handle)) return;
+
+		Write(handle, [&](AircraftState& state) {
+			state.VisualState = visualState;
+			state.PositionalVelocities = positionalVelocities;
+			state.RotationalVelocities = rotationalVelocities;
+			state.Speed = speed;
+			state.PositionSentAt = sentAt;
+			state.HasPosition = true;
+			state.PositionRevision++;
+		});
+	}
+
+	void AircraftStateQueue::PostConfig(uint32_t handle, const AircraftConfig& config) {
+		if (!IsValidHandle(handle)) return;
+
+		Write(handle, [&](AircraftState& state) {
+			state.Config.Merge(config);
+			state.HasConfig = true;
+			state.ConfigRevision++;
+		});
+	}
+
+	void AircraftStateQueue::PostHeartbeat(uint32_t handle) {
+		if (!IsValidHandle(handle)) return;
+
+		Write(handle, [&](AircraftState& state) {
+			state.HasHeartbeat = true;
+			state.HeartbeatRevision++;
+		});
+	}
+
+	void AircraftStateQueue::Reset(uint32_t handle) {
+		if (!IsValidHandle(handle)) return;
+
+		// revisions keep counting, so the flight loop never mistakes a reset slot for an update
+		Write(handle, [&](AircraftState& state) {
+			state.Config = {};
+			state.HasPosition = false;
+			state.HasConfig = false;
+			state.HasHeartbeat = false;
+		});
+	}
+
+	void AircraftStateQueue::ResetAll() {
+		for (uint32_t handle = 1; handle < MAX_AIRCRAFT_HANDLES; handle++) {
+			Reset(handle);
+		}
+	}
+}
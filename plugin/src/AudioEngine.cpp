@@ -19,6 +19,8 @@
 #include "AudioEngine.h"
 #include "Utilities.h"
 
+#include <algorithm>
+
 CAudioEngine::CAudioEngine() :
 	mNextChannelId(0) {
 	CAudioEngine::ErrorCheck("Implementation::System_Create", FMOD::System_Create(&SoundSystem));
@@ -32,7 +34,7 @@ CAudioEngine::~CAudioEngine() {
 	SoundMap.clear();
 
 	std::lock_guard channelLock(mChannelMapMutex);
-	ChannelMap.clear();
+	mVoices.clear();
 }
 
 void CAudioEngine::Update() {
@@ -74,62 +76,94 @@ int CAudioEngine::CreateSoundChannel(const std::string& soundName, float volumeD
 		return mChannelId;
 	}
 
-	FMOD::Channel* pChannel = nullptr;
-	CAudioEngine::ErrorCheck("CreateSoundChannel::playSound", SoundSystem->playSound(foundIt->second, nullptr, true, &pChannel));
-	if (pChannel) {
-		std::lock_guard channelLock(mChannelMapMutex);
-		{
-			CAudioEngine::ErrorCheck("CreateSoundChannel::set3DMinMaxDistance", pChannel->set3DMinMaxDistance(3.0f, 10000.0f));
-			ChannelMap[mChannelId] = pChannel;
-		}
-	}
+	// starts out virtual, UpdateChannels plays it once it's among the closest audible voices
+	std::lock_guard channelLock(mChannelMapMutex);
+	Voice& voice = mVoices[mChannelId];
+	voice.sound = foundIt->second;
+	voice.volume = volumeDb;
 
 	return mChannelId;
 }
 
-void CAudioEngine::SetChannel3dPosition(int channelId, const AudioVector3& pos) {
-	std::lock_guard channelLock(mChannelMapMutex);
-	auto foundIt = ChannelMap.find(channelId);
-	if (foundIt == ChannelMap.end()) {
-		return;
+void CAudioEngine::ReleaseChannel(Voice& voice) {
+	if (voice.channel) {
+		CAudioEngine::ErrorCheck("ReleaseChannel", voice.channel->stop());
+		voice.channel = nullptr;
 	}
-
-	FMOD_VECTOR position = VectorToFmod(pos);
-	CAudioEngine::ErrorCheck("SetChannel3dPosition", foundIt->second->set3DAttributes(&position, NULL));
 }
 
-void CAudioEngine::SetChannelVolume(int channelId, float volume) {
+void CAudioEngine::UpdateChannels(const std::vector<ChannelUpdate>& updates, size_t maxVoices) {
 	std::lock_guard channelLock(mChannelMapMutex);
-	auto tFoundIt = ChannelMap.find(channelId);
-	if (tFoundIt == ChannelMap.end())
-		return;
 
-	CAudioEngine::ErrorCheck("SetChannelVolume", tFoundIt->second->setVolume(volume));
-}
+	for (const ChannelUpdate& update : updates) {
+		auto foundIt = mVoices.find(update.channelId);
+		if (foundIt == mVoices.end())
+			continue;
+
+		Voice& voice = foundIt->second;
+		voice.position = VectorToFmod(update.position);
+		voice.volume = update.volume;
+		voice.audible = update.audible;
+		voice.distanceSq = update.position.x * update.position.x + update.position.y * update.position.y
+			+ update.position.z * update.position.z;
+	}
 
-void CAudioEngine::SetChannelPaused(int channel, bool paused) {
-	std::lock_guard channelLock(mChannelMapMutex);
-	auto tFoundIt = ChannelMap.find(channel);
-	if (tFoundIt == ChannelMap.end())
-		return;
+	mAudibleVoices.clear();
+	for (auto& [id, voice] : mVoices) {
+		if (voice.audible) {
+			mAudibleVoices.push_back(&voice);
+		} else {
+			ReleaseChannel(voice);
+		}
+	}
+
+	// only the closest voices get a real channel
+	if (mAudibleVoices.size() > maxVoices) {
+		std::nth_element(mAudibleVoices.begin(), mAudibleVoices.begin() + maxVoices, mAudibleVoices.end(),
+			[](const Voice* a, const Voice* b) { return a->distanceSq < b->distanceSq; });
+		for (size_t i = maxVoices; i < mAudibleVoices.size(); i++) {
+			ReleaseChannel(*mAudibleVoices[i]);
+		}
+		mAudibleVoices.resize(maxVoices);
+	}
 
-	CAudioEngine::ErrorCheck("SetChannelPaused", tFoundIt->second->setPaused(paused));
+	for (Voice* voice : mAudibleVoices) {
+		const bool started = !voice->channel;
+		if (started) {
+			CAudioEngine::ErrorCheck("UpdateChannels::playSound", SoundSystem->playSound(voice->sound, nullptr, true, &voice->channel));
+			if (!voice->channel)
+				continue;
+			CAudioEngine::ErrorCheck("UpdateChannels::set3DMinMaxDistance", voice->channel->set3DMinMaxDistance(3.0f, 10000.0f));
+		}
+		FMOD_RESULT result = voice->channel->set3DAttributes(&voice->position, NULL);
+		if (result == FMOD_ERR_INVALID_HANDLE) {
+			voice->channel = nullptr; // FMOD stole the channel, it's played again next frame
+			continue;
+		}
+		CAudioEngine::ErrorCheck("UpdateChannels::set3DAttributes", result);
+		CAudioEngine::ErrorCheck("UpdateChannels::setVolume", voice->channel->setVolume(voice->volume));
+		if (started) {
+			CAudioEngine::ErrorCheck("UpdateChannels::setPaused", voice->channel->setPaused(false));
+		}
+	}
 }
 
 void CAudioEngine::StopChannel(int channel) {
 	std::lock_guard channelLock(mChannelMapMutex);
-	auto iter = ChannelMap.find(channel);
-	if (iter == ChannelMap.end())
+	auto iter = mVoices.find(channel);
+	if (iter == mVoices.end())
 		return;
 
-	CAudioEngine::ErrorCheck("RemoveChannel", iter->second->stop());
+	ReleaseChannel(iter->second);
+	mVoices.erase(iter);
 }
 
 void CAudioEngine::StopAllChannels() {
 	std::lock_guard channelLock(mChannelMapMutex);
-	for (auto it = ChannelMap.begin(), itEnd = ChannelMap.end(); it != itEnd; ++it) {
-		it->second->stop();
+	for (auto& [id, voice] : mVoices) {
+		ReleaseChannel(voice);
 	}
+	mVoices.clear();
 }
 
 void CAudioEngine::SetListenerPosition() {
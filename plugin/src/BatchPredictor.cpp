@@ -0,0 +1,95 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "BatchPredictor.h"
+#include "NetworkAircraft.h"
+#include "Config.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace xpilot {
+	namespace {
+		// below this many aircraft per thread, waking a worker costs more than it saves
+		constexpr size_t MIN_CHUNK_LANES = 64;
+
+		size_t PredictionThreadCount() {
+			const int configured = Config::GetInstance().GetPredictionThreads();
+			if (configured > 0) return static_cast<size_t>(configured);
+
+			// automatic: leave most cores to X-Plane's own threads
+			const size_t cores = std::thread::hardware_concurrency();
+			return (std::max)(size_t(1), (std::min)(cores / 4, size_t(4)));
+		}
+	}
+
+	void BatchPredictor::Advance(const std::vector<NetworkAircraft*>& aircraft) {
+		m_timestamp = PrecisionTimestamp();
+
+		m_batch.clear();
+		for (NetworkAircraft* plane : aircraft) {
+			if (!plane->IsFirstRenderPending) {
+				m_batch.push_back(plane);
+			}
+		}
+		m_lanes.Resize(m_batch.size());
+
+		// runs of whole SIMD vectors, see tests/BatchPredictorThreadingTest.cpp
+		m_workers.SetThreadCount(PredictionThreadCount());
+		m_workers.RunRanges(m_batch.size(), PredictionLanes::PaddedCount(1), MIN_CHUNK_LANES, [this](size_t begin, size_t end) {
+			AdvanceLanes(begin, end);
+		});
+	}
+
+	void BatchPredictor::AdvanceLanes(size_t begin, size_t end) {
+		for (size_t lane = begin; lane < end; lane++) {
+			NetworkAircraft* plane = m_batch[lane];
+
+			Vector3 positionalVelocities;
+			Vector3 rotationalVelocities;
+			plane->PrepareExtrapolation(m_timestamp, positionalVelocities, rotationalVelocities);
+
+			const AircraftVisualState& state = plane->PredictedVisualState;
+			m_lanes.Lat[lane] = state.Lat;
+			m_lanes.Lon[lane] = state.Lon;
+			m_lanes.Altitude[lane] = state.AltitudeTrue;
+			m_lanes.Pitch[lane] = state.Pitch;
+			m_lanes.Heading[lane] = state.Heading;
+			m_lanes.Bank[lane] = state.Bank;
+			m_lanes.VelocityX[lane] = positionalVelocities.X;
+			m_lanes.VelocityY[lane] = positionalVelocities.Y;
+			m_lanes.VelocityZ[lane] = positionalVelocities.Z;
+			m_lanes.RotationX[lane] = rotationalVelocities.X;
+			m_lanes.RotationY[lane] = rotationalVelocities.Y;
+			m_lanes.RotationZ[lane] = rotationalVelocities.Z;
+			m_lanes.Interval[lane] = plane->LodElapsed;
+		}
+
+		Extrapolate(m_lanes, begin, end);
+
+		for (size_t lane = begin; lane < end; lane++) {
+			AircraftVisualState& state = m_batch[lane]->PredictedVisualState;
+			state.Lat = m_lanes.Lat[lane];
+			state.Lon = m_lanes.Lon[lane];
+			state.AltitudeTrue = m_lanes.Altitude[lane];
+			state.Pitch = m_lanes.Pitch[lane];
+			state.Heading = m_lanes.Heading[lane];
+			state.Bank = m_lanes.Bank[lane];
+		}
+	}
+}
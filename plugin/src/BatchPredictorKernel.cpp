@@ -0,0 +1,429 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "BatchPredictor.h"
+#include "GeoCalc.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// define XPILOT_NO_SIMD to build the scalar fallback on any platform
+#if !defined(XPILOT_NO_SIMD) && defined(__AVX2__)
+#define XPILOT_SIMD_AVX2
+#include <immintrin.h>
+#elif !defined(XPILOT_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#define XPILOT_SIMD_SSE2
+#include <emmintrin.h>
+#elif !defined(XPILOT_NO_SIMD) && (defined(__aarch64__) || defined(_M_ARM64)) && defined(__ARM_NEON)
+#define XPILOT_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace xpilot {
+	namespace {
+#if defined(XPILOT_SIMD_AVX2)
+		constexpr const char* INSTRUCTION_SET = "AVX2";
+
+		struct Vec
+		{
+			static constexpr size_t Width = 4;
+			__m256d v;
+			Vec(__m256d x) : v(x) {}
+			Vec(double x) : v(_mm256_set1_pd(x)) {}
+			static Vec Load(const double* p) { return _mm256_loadu_pd(p); }
+			void Store(double* p) const { _mm256_storeu_pd(p, v); }
+		};
+
+		struct Mask
+		{
+			__m256d m;
+		};
+
+		inline Vec operator+(Vec a, Vec b) { return _mm256_add_pd(a.v, b.v); }
+		inline Vec operator-(Vec a, Vec b) { return _mm256_sub_pd(a.v, b.v); }
+		inline Vec operator*(Vec a, Vec b) { return _mm256_mul_pd(a.v, b.v); }
+		inline Vec operator/(Vec a, Vec b) { return _mm256_div_pd(a.v, b.v); }
+		inline Vec operator-(Vec a) { return _mm256_xor_pd(a.v, _mm256_set1_pd(-0.0)); }
+		inline Mask operator<(Vec a, Vec b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ) }; }
+		inline Mask operator>(Vec a, Vec b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ) }; }
+		inline Mask operator>=(Vec a, Vec b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ) }; }
+		inline Mask operator==(Vec a, Vec b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ) }; }
+		inline Mask operator!=(Vec a, Vec b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_NEQ_UQ) }; }
+		inline Mask operator&(Mask a, Mask b) { return { _mm256_and_pd(a.m, b.m) }; }
+		inline Mask operator|(Mask a, Mask b) { return { _mm256_or_pd(a.m, b.m) }; }
+		inline bool Any(Mask a) { return _mm256_movemask_pd(a.m) != 0; }
+		inline Vec Select(Mask m, Vec a, Vec b) { return _mm256_blendv_pd(b.v, a.v, m.m); }
+		inline Vec Sqrt(Vec a) { return _mm256_sqrt_pd(a.v); }
+		inline Vec Min(Vec a, Vec b) { return _mm256_min_pd(a.v, b.v); }
+		inline Vec Max(Vec a, Vec b) { return _mm256_max_pd(a.v, b.v); }
+		inline Vec Round(Vec a) { return _mm256_round_pd(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+		inline Vec Abs(Vec a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v); }
+		inline Vec CopySign(Vec magnitude, Vec sign) {
+			const __m256d signBit = _mm256_set1_pd(-0.0);
+			return _mm256_or_pd(_mm256_andnot_pd(signBit, magnitude.v), _mm256_and_pd(signBit, sign.v));
+		}
+#elif defined(XPILOT_SIMD_SSE2)
+		constexpr const char* INSTRUCTION_SET = "SSE2";
+
+		struct Vec
+		{
+			static constexpr size_t Width = 2;
+			__m128d v;
+			Vec(__m128d x) : v(x) {}
+			Vec(double x) : v(_mm_set1_pd(x)) {}
+			static Vec Load(const double* p) { return _mm_loadu_pd(p); }
+			void Store(double* p) const { _mm_storeu_pd(p, v); }
+		};
+
+		struct Mask
+		{
+			__m128d m;
+		};
+
+		inline Vec operator+(Vec a, Vec b) { return _mm_add_pd(a.v, b.v); }
+		inline Vec operator-(Vec a, Vec b) { return _mm_sub_pd(a.v, b.v); }
+		inline Vec operator*(Vec a, Vec b) { return _mm_mul_pd(a.v, b.v); }
+		inline Vec operator/(Vec a, Vec b) { return _mm_div_pd(a.v, b.v); }
+		inline Vec operator-(Vec a) { return _mm_xor_pd(a.v, _mm_set1_pd(-0.0)); }
+		inline Mask operator<(Vec a, Vec b) { return { _mm_cmplt_pd(a.v, b.v) }; }
+		inline Mask operator>(Vec a, Vec b) { return { _mm_cmpgt_pd(a.v, b.v) }; }
+		inline Mask operator>=(Vec a, Vec b) { return { _mm_cmpge_pd(a.v, b.v) }; }
+		inline Mask operator==(Vec a, Vec b) { return { _mm_cmpeq_pd(a.v, b.v) }; }
+		inline Mask operator!=(Vec a, Vec b) { return { _mm_cmpneq_pd(a.v, b.v) }; }
+		inline Mask operator&(Mask a, Mask b) { return { _mm_and_pd(a.m, b.m) }; }
+		inline Mask operator|(Mask a, Mask b) { return { _mm_or_pd(a.m, b.m) }; }
+		inline bool Any(Mask a) { return _mm_movemask_pd(a.m) != 0; }
+		inline Vec Select(Mask m, Vec a, Vec b) { return _mm_or_pd(_mm_and_pd(m.m, a.v), _mm_andnot_pd(m.m, b.v)); }
+		inline Vec Sqrt(Vec a) { return _mm_sqrt_pd(a.v); }
+		inline Vec Min(Vec a, Vec b) { return _mm_min_pd(a.v, b.v); }
+		inline Vec Max(Vec a, Vec b) { return _mm_max_pd(a.v, b.v); }
+		inline Vec Abs(Vec a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a.v); }
+		inline Vec CopySign(Vec magnitude, Vec sign) {
+			const __m128d signBit = _mm_set1_pd(-0.0);
+			return _mm_or_pd(_mm_andnot_pd(signBit, magnitude.v), _mm_and_pd(signBit, sign.v));
+		}
+		inline Vec Round(Vec a) {
+			// SSE2 has no rounding instruction; adding 2^52 + 2^51 pushes the fraction out of the
+			// mantissa, which rounds to nearest even like the other paths (valid for |a| < 2^51)
+			const __m128d magic = _mm_set1_pd(6755399441055744.0);
+			return _mm_sub_pd(_mm_add_pd(a.v, magic), magic);
+		}
+#elif defined(XPILOT_SIMD_NEON)
+		constexpr const char* INSTRUCTION_SET = "NEON";
+
+		struct Vec
+		{
+			static constexpr size_t Width = 2;
+			float64x2_t v;
+			Vec(float64x2_t x) : v(x) {}
+			Vec(double x) : v(vdupq_n_f64(x)) {}
+			static Vec Load(const double* p) { return vld1q_f64(p); }
+			void Store(double* p) const { vst1q_f64(p, v); }
+		};
+
+		struct Mask
+		{
+			uint64x2_t m;
+		};
+
+		inline Vec operator+(Vec a, Vec b) { return vaddq_f64(a.v, b.v); }
+		inline Vec operator-(Vec a, Vec b) { return vsubq_f64(a.v, b.v); }
+		inline Vec operator*(Vec a, Vec b) { return vmulq_f64(a.v, b.v); }
+		inline Vec operator/(Vec a, Vec b) { return vdivq_f64(a.v, b.v); }
+		inline Vec operator-(Vec a) { return vnegq_f64(a.v); }
+		inline Mask operator<(Vec a, Vec b) { return { vcltq_f64(a.v, b.v) }; }
+		inline Mask operator>(Vec a, Vec b) { return { vcgtq_f64(a.v, b.v) }; }
+		inline Mask operator>=(Vec a, Vec b) { return { vcgeq_f64(a.v, b.v) }; }
+		inline Mask operator==(Vec a, Vec b) { return { vceqq_f64(a.v, b.v) }; }
+		inline Mask operator!=(Vec a, Vec b) {
+			return { vreinterpretq_u64_u32(vmvnq_u32(vreinterpretq_u32_u64(vceqq_f64(a.v, b.v)))) };
+		}
+		inline Mask operator&(Mask a, Mask b) { return { vandq_u64(a.m, b.m) }; }
+		inline Mask operator|(Mask a, Mask b) { return { vorrq_u64(a.m, b.m) }; }
+		inline bool Any(Mask a) { return vmaxvq_u32(vreinterpretq_u32_u64(a.m)) != 0; }
+		inline Vec Select(Mask m, Vec a, Vec b) { return vbslq_f64(m.m, a.v, b.v); }
+		inline Vec Sqrt(Vec a) { return vsqrtq_f64(a.v); }
+		inline Vec Min(Vec a, Vec b) { return vminq_f64(a.v, b.v); }
+		inline Vec Max(Vec a, Vec b) { return vmaxq_f64(a.v, b.v); }
+		inline Vec Round(Vec a) { return vrndnq_f64(a.v); }
+		inline Vec Abs(Vec a) { return vabsq_f64(a.v); }
+		inline Vec CopySign(Vec magnitude, Vec sign) {
+			return vbslq_f64(vdupq_n_u64(0x8000000000000000ULL), sign.v, magnitude.v);
+		}
+#else
+		constexpr const char* INSTRUCTION_SET = "scalar";
+
+		struct Vec
+		{
+			static constexpr size_t Width = 1;
+			double v;
+			Vec(double x) : v(x) {}
+			static Vec Load(const double* p) { return *p; }
+			void Store(double* p) const { *p = v; }
+		};
+
+		struct Mask
+		{
+			bool m;
+		};
+
+		inline Vec operator+(Vec a, Vec b) { return a.v + b.v; }
+		inline Vec operator-(Vec a, Vec b) { return a.v - b.v; }
+		inline Vec operator*(Vec a, Vec b) { return a.v * b.v; }
+		inline Vec operator/(Vec a, Vec b) { return a.v / b.v; }
+		inline Vec operator-(Vec a) { return -a.v; }
+		inline Mask operator<(Vec a, Vec b) { return { a.v < b.v }; }
+		inline Mask operator>(Vec a, Vec b) { return { a.v > b.v }; }
+		inline Mask operator>=(Vec a, Vec b) { return { a.v >= b.v }; }
+		inline Mask operator==(Vec a, Vec b) { return { !(a.v < b.v) && !(a.v > b.v) }; }
+		inline Mask operator!=(Vec a, Vec b) { return { a.v < b.v || a.v > b.v }; }
+		inline Mask operator&(Mask a, Mask b) { return { a.m && b.m }; }
+		inline Mask operator|(Mask a, Mask b) { return { a.m || b.m }; }
+		inline bool Any(Mask a) { return a.m; }
+		inline Vec Select(Mask m, Vec a, Vec b) { return m.m ? a : b; }
+		inline Vec Sqrt(Vec a) { return std::sqrt(a.v); }
+		inline Vec Min(Vec a, Vec b) { return (std::min)(a.v, b.v); }
+		inline Vec Max(Vec a, Vec b) { return (std::max)(a.v, b.v); }
+		inline Vec Round(Vec a) { return std::nearbyint(a.v); }
+		inline Vec Abs(Vec a) { return std::fabs(a.v); }
+		inline Vec CopySign(Vec magnitude, Vec sign) { return std::copysign(magnitude.v, sign.v); }
+#endif
+
+		constexpr double PI = 3.14159265358979323846;
+		constexpr double PI_2 = 1.57079632679489661923;
+		constexpr double PI_4 = 0.78539816339744830962;
+
+		// pi/2 split in three parts (Cody-Waite), the first one exact in 33 bits
+		constexpr double PIO2_1 = 1.57079632673412561417e+00;
+		constexpr double PIO2_2 = 6.07710050630396597660e-11;
+		constexpr double PIO2_3 = 2.02226624879595063154e-21;
+		constexpr double TWO_OVER_PI = 6.36619772367581382433e-01;
+
+		// minimax polynomials on [-pi/4, pi/4] and the atan rational approximation, from Cephes
+		constexpr double SIN_COEF[] = {
+			1.58962301576546568060e-10, -2.50507477628578072866e-8, 2.75573136213857245213e-6,
+			-1.98412698295895385996e-4, 8.33333333332211858878e-3, -1.66666666666666307295e-1
+		};
+		constexpr double COS_COEF[] = {
+			-1.13585365213876817300e-11, 2.08757008419747316778e-9, -2.75573141792967388112e-7,
+			2.48015872888517045348e-5, -1.38888888888730564116e-3, 4.16666666666665929218e-2
+		};
+		constexpr double ATAN_P[] = {
+			-8.750608600031904122785e-1, -1.615753718733365076637e1, -7.500855792314704667340e1,
+			-1.228866684490136173410e2, -6.485021904942025371773e1
+		};
+		constexpr double ATAN_Q[] = {
+			2.485846490142306297962e1, 1.650270098316988542046e2, 4.328810604912902668951e2,
+			4.853903996359136964868e2, 1.945506571482613964425e2
+		};
+		constexpr double ATAN_MOREBITS = 6.123233995736765886130e-17;
+
+		// same threshold as Quaternion::ToEuler, including the float literal
+		constexpr double GIMBAL_LOCK_TEST = 0.4995f;
+
+		// accurate to a few ulp for |x| up to ~1e5, which covers every angle we feed it
+		void SinCos(Vec x, Vec& sinX, Vec& cosX) {
+			const Vec q = Round(x * TWO_OVER_PI);
+			const Vec r = ((x - q * PIO2_1) - q * PIO2_2) - q * PIO2_3;
+			const Vec z = r * r;
+
+			const Vec sinR = r + r * z * (((((Vec(SIN_COEF[0]) * z + SIN_COEF[1]) * z + SIN_COEF[2]) * z
+				+ SIN_COEF[3]) * z + SIN_COEF[4]) * z + SIN_COEF[5]);
+			const Vec cosR = Vec(1.0) - z * 0.5 + z * z * (((((Vec(COS_COEF[0]) * z + COS_COEF[1]) * z
+				+ COS_COEF[2]) * z + COS_COEF[3]) * z + COS_COEF[4]) * z + COS_COEF[5]);
+
+			// quadrant = q mod 4, floor(q / 4) computed as a round to nearest
+			const Vec quadrant = q - Round(q * 0.25 - 0.375) * 4.0;
+			const Mask swap = (quadrant == 1.0) | (quadrant == 3.0);
+			const Mask negateSin = quadrant >= 2.0;
+			const Mask negateCos = (quadrant == 1.0) | (quadrant == 2.0);
+
+			const Vec s = Select(swap, cosR, sinR);
+			const Vec c = Select(swap, sinR, cosR);
+			sinX = Select(negateSin, -s, s);
+			cosX = Select(negateCos, -c, c);
+		}
+
+		Vec Sin(Vec x) {
+			Vec s(0.0), c(0.0);
+			SinCos(x, s, c);
+			return s;
+		}
+
+		Vec Cos(Vec x) {
+			Vec s(0.0), c(0.0);
+			SinCos(x, s, c);
+			return c;
+		}
+
+		// atan(x) for 0 <= x <= 1
+		Vec AtanUnit(Vec x) {
+			const Mask upper = x > 0.66;
+			const Vec z = Select(upper, (x - 1.0) / (x + 1.0), x);
+			const Vec zz = z * z;
+			const Vec p = (((Vec(ATAN_P[0]) * zz + ATAN_P[1]) * zz + ATAN_P[2]) * zz + ATAN_P[3]) * zz + ATAN_P[4];
+			const Vec q = ((((zz + ATAN_Q[0]) * zz + ATAN_Q[1]) * zz + ATAN_Q[2]) * zz + ATAN_Q[3]) * zz + ATAN_Q[4];
+			const Vec y = z * (zz * p / q) + z;
+			return Select(upper, Vec(PI_4) + (y + 0.5 * ATAN_MOREBITS), y);
+		}
+
+		Vec Atan2(Vec y, Vec x) {
+			const Vec ax = Abs(x);
+			const Vec ay = Abs(y);
+			const Vec hi = Max(ax, ay);
+			const Vec lo = Min(ax, ay);
+
+			Vec a = AtanUnit(lo / Select(hi > 0.0, hi, Vec(1.0)));
+			a = Select(ay > ax, Vec(PI_2) - a, a);
+			a = Select(x < 0.0, Vec(PI) - a, a);
+			return CopySign(a, y);
+		}
+
+		Vec Asin(Vec x) {
+			return Atan2(x, Sqrt(Max(Vec(1.0) - x * x, Vec(0.0))));
+		}
+
+		struct Quat
+		{
+			Vec X, Y, Z, W;
+		};
+
+		// Quaternion::FromEuler
+		Quat FromEuler(Vec x, Vec y, Vec z) {
+			Vec sx(0.0), cx(0.0), sy(0.0), cy(0.0), sz(0.0), cz(0.0);
+			SinCos(x * 0.5, sx, cx);
+			SinCos(y * 0.5, sy, cy);
+			SinCos(z * 0.5, sz, cz);
+			return {
+				cx * sy * sz + cy * cz * sx,
+				cx * cz * sy - cy * sx * sz,
+				cx * cy * sz - cz * sx * sy,
+				sx * sy * sz + cx * cy * cz
+			};
+		}
+
+		// Quaternion::Slerp(Quaternion::Identity(), b, t) for 0 <= t <= 1
+		Quat SlerpFromIdentity(const Quat& b, Vec t) {
+			const Mask flip = b.W < 0.0;
+			const Vec dot = Abs(b.W);
+			const Mask nearlyEqual = dot > 0.999999;
+
+			const Vec angle = Atan2(Sqrt(Max(Vec(1.0) - dot * dot, Vec(0.0))), dot);
+			const Vec inverseSin = Vec(1.0) / Select(nearlyEqual, Vec(1.0), Sin(angle));
+			const Vec scaleA = Select(nearlyEqual, Vec(1.0) - t, Sin((Vec(1.0) - t) * angle) * inverseSin);
+			const Vec scaleB = Select(nearlyEqual, t, Sin(t * angle) * inverseSin);
+			const Vec signedScaleB = Select(flip, -scaleB, scaleB);
+
+			const Quat q{ signedScaleB * b.X, signedScaleB * b.Y, signedScaleB * b.Z, scaleA + signedScaleB * b.W };
+			const Vec norm = Sqrt(q.X * q.X + q.Y * q.Y + q.Z * q.Z + q.W * q.W);
+			return { q.X / norm, q.Y / norm, q.Z / norm, q.W / norm };
+		}
+
+		Quat Multiply(const Quat& a, const Quat& b) {
+			return {
+				a.X * b.W + a.W * b.X + a.Y * b.Z - a.Z * b.Y,
+				a.W * b.Y - a.X * b.Z + a.Y * b.W + a.Z * b.X,
+				a.W * b.Z + a.X * b.Y - a.Y * b.X + a.Z * b.W,
+				a.W * b.W - a.X * b.X - a.Y * b.Y - a.Z * b.Z
+			};
+		}
+
+		// Quaternion::ToEuler, in radians
+		void ToEuler(const Quat& q, Vec& x, Vec& y, Vec& z) {
+			const Vec unit = q.X * q.X + q.Y * q.Y + q.Z * q.Z + q.W * q.W;
+			const Vec test = q.X * q.W - q.Y * q.Z;
+			const Mask northPole = test > Vec(GIMBAL_LOCK_TEST) * unit;
+			const Mask southPole = test < Vec(-GIMBAL_LOCK_TEST) * unit;
+			const Mask singular = northPole | southPole;
+
+			const Vec singularYaw = Vec(2.0) * Atan2(q.Y, q.X);
+			const Vec yaw = Atan2(Vec(2.0) * q.W * q.Y + Vec(2.0) * q.Z * q.X, Vec(1.0) - Vec(2.0) * (q.X * q.X + q.Y * q.Y));
+			const Vec pitch = Asin(Vec(2.0) * (q.W * q.X - q.Y * q.Z));
+			const Vec roll = Atan2(Vec(2.0) * q.W * q.Z + Vec(2.0) * q.X * q.Y, Vec(1.0) - Vec(2.0) * (q.Z * q.Z + q.X * q.X));
+
+			x = Select(northPole, Vec(PI_2), Select(southPole, Vec(-PI_2), pitch));
+			y = Select(northPole, singularYaw, Select(southPole, -singularYaw, yaw));
+			z = Select(singular, Vec(0.0), roll);
+		}
+	}
+
+	size_t PredictionLanes::PaddedCount(size_t count) {
+		return (count + Vec::Width - 1) / Vec::Width * Vec::Width;
+	}
+
+	void PredictionLanes::Resize(size_t count) {
+		const size_t padded = PaddedCount(count);
+		for (auto lane : { &Lat, &Lon, &Altitude, &Pitch, &Heading, &Bank,
+			&VelocityX, &VelocityY, &VelocityZ, &RotationX, &RotationY, &RotationZ, &Interval }) {
+			lane->resize(padded, 0.0);
+		}
+	}
+
+	const char* BatchPredictor::GetInstructionSet() {
+		return INSTRUCTION_SET;
+	}
+
+	void BatchPredictor::Extrapolate(PredictionLanes& lanes, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i += Vec::Width) {
+			const Vec dt = Vec::Load(&lanes.Interval[i]);
+			const Vec t = Min(dt, Vec(1.0));
+			const Vec lat = Vec::Load(&lanes.Lat[i]);
+			const Vec lon = Vec::Load(&lanes.Lon[i]);
+			const Vec alt = Vec::Load(&lanes.Altitude[i]);
+			const Vec vx = Vec::Load(&lanes.VelocityX[i]);
+			const Vec vy = Vec::Load(&lanes.VelocityY[i]);
+			const Vec vz = Vec::Load(&lanes.VelocityZ[i]);
+
+			// position, as in ExtrapolatePose
+			Vec newLat = lat + vz * dt / METERS_PER_NM / NM_PER_DEG;
+			newLat = Select(newLat < -90.0, newLat + 180.0, Select(newLat > 90.0, newLat - 180.0, newLat));
+
+			const Vec longitudeScaling = Vec(PI_OVER_ONE_EIGHTY * EARTH_RADIUS_NM) * Cos(lat * PI_OVER_ONE_EIGHTY) / NM_PER_DEG;
+			Vec newLon = lon + vx * dt / longitudeScaling / METERS_PER_NM / NM_PER_DEG;
+			newLon = Select(newLon < -180.0, newLon + 360.0, Select(newLon > 180.0, newLon - 360.0, newLon));
+
+			const Vec newAlt = alt + vy * dt * 3.28084;
+
+			newLat.Store(&lanes.Lat[i]);
+			newLon.Store(&lanes.Lon[i]);
+			newAlt.Store(&lanes.Altitude[i]);
+
+			// orientation; most aircraft aren't turning, so skip the trig when no lane needs it
+			const Vec rx = Vec::Load(&lanes.RotationX[i]);
+			const Vec ry = Vec::Load(&lanes.RotationY[i]);
+			const Vec rz = Vec::Load(&lanes.RotationZ[i]);
+			const Mask rotating = (rx != 0.0) | (ry != 0.0) | (rz != 0.0);
+			if (!Any(rotating)) continue;
+
+			const Vec pitch = Vec::Load(&lanes.Pitch[i]);
+			const Vec heading = Vec::Load(&lanes.Heading[i]);
+			const Vec bank = Vec::Load(&lanes.Bank[i]);
+
+			const Quat current = FromEuler(pitch * PI_OVER_ONE_EIGHTY, heading * PI_OVER_ONE_EIGHTY, bank * PI_OVER_ONE_EIGHTY);
+			const Quat rotation = FromEuler(rx, ry, rz);
+			const Quat result = Multiply(current, SlerpFromIdentity(rotation, t));
+
+			Vec newPitch(0.0), newHeading(0.0), newBank(0.0);
+			ToEuler(result, newPitch, newHeading, newBank);
+
+			Select(rotating, newPitch * ONE_EIGHTY_OVER_PI, pitch).Store(&lanes.Pitch[i]);
+			Select(rotating, newHeading * ONE_EIGHTY_OVER_PI, heading).Store(&lanes.Heading[i]);
+			Select(rotating, newBank * ONE_EIGHTY_OVER_PI, bank).Store(&lanes.Bank[i]);
+		}
+	}
+}
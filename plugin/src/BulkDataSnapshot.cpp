@@ -0,0 +1,155 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "BulkDataSnapshot.h"
+#include "AircraftManager.h"
+
+#include <XPLMProcessing.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace xpilot {
+	namespace {
+		// copies whole records of the reader's size, as far as our records go
+		template<typename T>
+		int CopyRecords(const std::vector<T>& records, int size, void* outData, int inStartPos, int inNumBytes) {
+			if (!size || inStartPos % size != 0 || inNumBytes % size != 0)
+				return 0;
+
+			const size_t first = inStartPos / size;
+			if (first >= records.size())
+				return 0;
+			const size_t count = (std::min)(static_cast<size_t>(inNumBytes / size), records.size() - first);
+
+			char* out = static_cast<char*>(outData);
+			if (size == static_cast<int>(sizeof(T))) {
+				memcpy(out, records.data() + first, count * sizeof(T));
+			} else {
+				const size_t common = (std::min)(static_cast<size_t>(size), sizeof(T));
+				for (size_t i = 0; i < count; i++, out += size) {
+					memcpy(out, &records[first + i], common);
+					memset(out + common, 0, size - common);
+				}
+			}
+			return static_cast<int>(count) * size;
+		}
+	}
+
+	BulkDataSnapshot::BulkDataSnapshot() {
+		m_quickRef = XPLMRegisterDataAccessor("xpilot/bulk/quick",
+			xplmType_Data,
+			false,
+			NULL, NULL,
+			NULL, NULL,
+			NULL, NULL,
+			NULL, NULL,
+			NULL, NULL,
+			GetQuickData, NULL,
+			this, this);
+
+		m_expensiveRef = XPLMRegisterDataAccessor("xpilot/bulk/expensive",
+			xplmType_Data,
+			false,
+			NULL, NULL,
+			NULL, NULL,
+			NULL, NULL,
+			NULL, NULL,
+			NULL, NULL,
+			GetExpensiveData, NULL,
+			this, this);
+
+		m_generationRef = XPLMRegisterDataAccessor("xpilot/bulk/generation",
+			xplmType_Int,
+			false,
+			GetGeneration, NULL,
+			NULL, NULL,
+			NULL, NULL,
+			NULL, NULL,
+			NULL, NULL,
+			NULL, NULL,
+			this, this);
+	}
+
+	BulkDataSnapshot::~BulkDataSnapshot() {
+		XPLMUnregisterDataAccessor(m_quickRef);
+		XPLMUnregisterDataAccessor(m_expensiveRef);
+		XPLMUnregisterDataAccessor(m_generationRef);
+	}
+
+	void BulkDataSnapshot::RefreshQuick() {
+		const int cycle = XPLMGetCycleNumber();
+		if (cycle == m_quickCycle) return;
+		m_quickCycle = cycle;
+
+		m_quickBack.clear();
+		for (const auto& plane : mapPlanes) {
+			if (!plane.second) continue;
+			auto& record = m_quickBack.emplace_back();
+			memset(static_cast<void*>(&record), 0, sizeof(record)); // padding too, so records compare by memcmp
+			plane.second->copyBulkData(&record, sizeof(record));
+		}
+
+		if (m_quickBack.size() != m_quick.size() ||
+			memcmp(m_quickBack.data(), m_quick.data(), m_quick.size() * sizeof(m_quick[0])) != 0) {
+			m_quick.swap(m_quickBack);
+			m_generation++;
+		}
+	}
+
+	void BulkDataSnapshot::RefreshTexts() {
+		const int cycle = XPLMGetCycleNumber();
+		if (cycle == m_textsCycle) return;
+		m_textsCycle = cycle;
+
+		m_texts.clear();
+		for (const auto& plane : mapPlanes) {
+			if (!plane.second) continue;
+			auto& record = m_texts.emplace_back();
+			plane.second->copyBulkData(&record, sizeof(record));
+		}
+	}
+
+	int BulkDataSnapshot::GetQuickData(void* inRefcon, void* outData, int inStartPos, int inNumBytes) {
+		auto* snapshot = static_cast<BulkDataSnapshot*>(inRefcon);
+		if (!outData) {
+			snapshot->m_quickSize = inNumBytes;
+			return static_cast<int>(sizeof(XPilotAPIAircraft::XPilotAPIBulkData));
+		}
+
+		snapshot->RefreshQuick();
+		return CopyRecords(snapshot->m_quick, snapshot->m_quickSize, outData, inStartPos, inNumBytes);
+	}
+
+	int BulkDataSnapshot::GetExpensiveData(void* inRefcon, void* outData, int inStartPos, int inNumBytes) {
+		auto* snapshot = static_cast<BulkDataSnapshot*>(inRefcon);
+		if (!outData) {
+			snapshot->m_textsSize = inNumBytes;
+			return static_cast<int>(sizeof(XPilotAPIAircraft::XPilotAPIBulkInfoTexts));
+		}
+
+		snapshot->RefreshTexts();
+		return CopyRecords(snapshot->m_texts, snapshot->m_textsSize, outData, inStartPos, inNumBytes);
+	}
+
+	int BulkDataSnapshot::GetGeneration(void* inRefcon) {
+		auto* snapshot = static_cast<BulkDataSnapshot*>(inRefcon);
+		snapshot->RefreshQuick();
+		return snapshot->m_generation;
+	}
+}
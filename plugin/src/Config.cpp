@@ -126,6 +126,18 @@ namespace xpilot {
 				int vol = std::max(0, std::min(jf.at("AircraftSoundVolume").get<int>(), 100));
 				SetAircraftSoundVolume(vol);
 			}
+			if (jf.contains("AircraftUpdateBudget")) {
+				SetAircraftUpdateBudget(jf["AircraftUpdateBudget"]);
+			}
+			if (jf.contains("EngineSoundVoices")) {
+				SetEngineSoundVoices(jf["EngineSoundVoices"]);
+			}
+			if (jf.contains("LocalFrameExtrapolation")) {
+				SetLocalFrameExtrapolation(jf["LocalFrameExtrapolation"]);
+			}
+			if (jf.contains("PredictionThreads")) {
+				SetPredictionThreads(jf["PredictionThreads"]);
+			}
 			if (jf.contains("CSL")) {
 				json cslpackages = jf["CSL"];
 				for (auto& p : cslpackages) {
@@ -168,6 +180,10 @@ namespace xpilot {
 		j["EnableTransmitIndicator"] = GetTransmitIndicatorEnabled();
 		j["EnableAircraftSounds"] = GetAircraftSoundsEnabled();
 		j["AircraftSoundVolume"] = GetAircraftSoundVolume();
+		j["AircraftUpdateBudget"] = GetAircraftUpdateBudget();
+		j["EngineSoundVoices"] = GetEngineSoundVoices();
+		j["LocalFrameExtrapolation"] = GetLocalFrameExtrapolation();
+		j["PredictionThreads"] = GetPredictionThreads();
 
 		auto jsonObjects = json::array();
 		if (!m_cslPackages.empty()) {
@@ -0,0 +1,123 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "FlightModel.h"
+
+#include <regex>
+#include <unordered_map>
+
+namespace xpilot {
+	namespace {
+		struct CompiledModelMatch
+		{
+			std::string category;
+			std::regex regex;
+		};
+
+		// FlightModel::modelMatches compiled once, and the result per classification key
+		std::vector<CompiledModelMatch> compiledModelMatches;
+		std::unordered_map<std::string, FlightModel> flightModelCache;
+	}
+
+	std::vector<FlightModelInfo> FlightModel::modelMatches;
+
+	void FlightModel::InitializeModels() {
+		modelMatches.clear();
+
+		// Huge Jets
+		modelMatches.push_back({ "HugeJets","^(H|J);L\\dJ;" });
+		modelMatches.push_back({ "HugeJets","^M;L4J;" });
+
+		// Biz Jets
+		modelMatches.push_back({ "BizJet","^M;L\\dJ;*BEECH*" });     // Beech, Beechcraft
+		modelMatches.push_back({ "BizJet","^M;L\\dJ;GLF" });         // Grumman Gulfstream
+		modelMatches.push_back({ "BizJet","^M;L\\dJ;LJ" });          // Learjet
+		modelMatches.push_back({ "BizJet","^M;L\\dJ;*BEECH*" });     // Beech, Beechcraft
+		modelMatches.push_back({ "BizJet","^M;L\\dJ;.*;CESSNA" });   // Cessna
+		modelMatches.push_back({ "BizJet","^M;L\\dJ;.*;DASSAULT" }); // Dassault (Falcon)
+
+		// Medium Jets
+		modelMatches.push_back({ "MediumJets","^M;L\\dJ;" });
+		modelMatches.push_back({ "MediumProps","^M;L\\dT;" });
+		modelMatches.push_back({ "BizJet","^L;L\\dJ;" });
+		modelMatches.push_back({ "Glider",";(GLID|A20J|A33P|A33E|A34E|ARCE|ARCP|AS14|AS16|AS20|AS21|AS22|AS24|AS25|AS26|AS28|AS29|AS30|AS31|DG1T|DG40|DG50|DG60|DG80|DIMO|DISC|DUOD|G103|G109|HU1|HU2|JANU|L13M|LAE1|LK17|LK19|LK20|LS8|LS9|NIMB|PISI|PITE|PITA|PIT4|PK15|PK20|S10S|S32M|S32E|SF24|SF25|SF27|SF28|SF31|SZ45|SZ9M|TS1J|VENT);" });
+		modelMatches.push_back({ "LightAC", "^-" });
+		modelMatches.push_back({ "TurboProps", "^L;L\\dT;" });
+		modelMatches.push_back({ "GA", "^L;L\\dP;" });
+		modelMatches.push_back({ "Heli", "^.;H" });
+
+		// Fallback
+		modelMatches.push_back({ "MediumJets", ".*" });
+
+		// building a std::regex is slow, so it's done here once rather than for every new aircraft
+		compiledModelMatches.clear();
+		for (const auto& match : modelMatches) {
+			compiledModelMatches.push_back({ match.category, std::regex(match.regex, std::regex::optimize | std::regex::nosubs) });
+		}
+		flightModelCache.clear();
+	}
+
+	FlightModel FlightModel::ForClassification(const std::string& wtc, const std::string& classification, const std::string& icaoType) {
+		const std::string key = wtc + ";" + classification + ";" + icaoType + ";";
+
+		auto cached = flightModelCache.find(key);
+		if (cached != flightModelCache.end()) {
+			return cached->second;
+		}
+
+		std::string category = "MediumJets";
+		for (const auto& match : compiledModelMatches) {
+			if (std::regex_search(key, match.regex)) {
+				category = match.category;
+				break;
+			}
+		}
+
+		FlightModel flightModel = {};
+		flightModel.modelCategory = category;
+
+		if (category == "HugeJets") {
+			flightModel.FLAPS_DURATION = 10000;
+			flightModel.GEAR_DURATION = 10000;
+			flightModel.GEAR_DEFLECTION = 1.4;
+		} else if (category == "BizJet") {
+			flightModel.FLAPS_DURATION = 5000;
+			flightModel.GEAR_DURATION = 0.25;
+			flightModel.GEAR_DEFLECTION = 0.5;
+		} else if (category == "GA") {
+			flightModel.FLAPS_DURATION = 5000;
+			flightModel.GEAR_DURATION = 10000;
+			flightModel.GEAR_DEFLECTION = 0.25;
+		} else if (category == "LightAC") {
+			flightModel.FLAPS_DURATION = 5000;
+			flightModel.GEAR_DURATION = 10000;
+			flightModel.GEAR_DEFLECTION = 0.25;
+		} else if (category == "Heli") {
+			flightModel.FLAPS_DURATION = 5000;
+			flightModel.GEAR_DURATION = 10000;
+			flightModel.GEAR_DEFLECTION = 0.25;
+		} else {
+			flightModel.FLAPS_DURATION = 5000;
+			flightModel.GEAR_DURATION = 10000;
+			flightModel.GEAR_DEFLECTION = 0.5;
+		}
+
+		flightModelCache.emplace(key, flightModel);
+		return flightModel;
+	}
+}
@@ -0,0 +1,242 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "IpcStats.h"
+#include "Utilities.h"
+
+#include <cmath>
+#include <string>
+
+namespace xpilot {
+	namespace {
+		constexpr float PUBLISH_INTERVAL = 1.0f;
+		constexpr float LOG_INTERVAL = 60.0f;
+
+		// stamps from a client on another machine use an unrelated clock
+		constexpr int64_t MAX_PLAUSIBLE_LATENCY = 60 * 1000 * 1000;
+
+		// a sequence this far behind the last one means the client restarted, anything closer is
+		// a late message (e.g. while switching between nng and shared memory)
+		constexpr uint32_t REORDER_WINDOW = 64;
+
+		const std::string* MESSAGE_NAMES[] = {
+			nullptr,
+			&ADD_AIRCRAFT,
+			&AIRCRAFT_ADDED,
+			&AIRCRAFT_DELETED,
+			&DELETE_AIRCRAFT,
+			&DELETE_ALL_AIRCRAFT,
+			&AIRCRAFT_CONFIG,
+			&FAST_POSITION_UPDATE,
+			&POSITION_FRAME,
+			&HEARTBEAT,
+			&PLUGIN_VER,
+			&VALIDATE_CSL,
+			&RADIO_MESSAGE_SENT,
+			&RADIO_MESSAGE_RECEIVED,
+			&NOTIFICATION_POSTED,
+			&PRIVATE_MESSAGE_SENT,
+			&PRIVATE_MESSAGE_RECEIVED,
+			&NEARBY_ATC,
+			&REQUEST_METAR,
+			&REQUEST_STATION_INFO,
+			&WALLOP_SENT,
+			&FORCE_DISCONNECT,
+			&CONNECTED,
+			&DISCONNECTED,
+			&SHUTDOWN,
+			&STATION_CALLSIGN,
+			&USER_AIRCRAFT_STATE,
+		};
+		static_assert(sizeof(MESSAGE_NAMES) / sizeof(MESSAGE_NAMES[0]) == static_cast<size_t>(MessageId::Count),
+			"every message id needs a name");
+	}
+
+	IpcStats::IpcStats() :
+		m_messagesReceived("xpilot/stats/messages_received", ReadOnly),
+		m_messagesDropped("xpilot/stats/messages_dropped", ReadOnly),
+		m_sendsDroppedRef("xpilot/stats/sends_dropped", ReadOnly),
+		m_latencyP50("xpilot/stats/latency_p50_ms", ReadOnly),
+		m_latencyP99("xpilot/stats/latency_p99_ms", ReadOnly),
+		m_positionLatencyP50("xpilot/stats/position_latency_p50_ms", ReadOnly),
+		m_positionLatencyP99("xpilot/stats/position_latency_p99_ms", ReadOnly),
+		m_receivedByType("xpilot/stats/received_by_type", ReadOnly),
+		m_droppedByType("xpilot/stats/dropped_by_type", ReadOnly),
+		m_latencyP50ByType("xpilot/stats/latency_p50_ms_by_type", ReadOnly),
+		m_latencyP99ByType("xpilot/stats/latency_p99_ms_by_type", ReadOnly) {
+		m_receivedByType = std::vector<float>(TYPE_COUNT, 0.0f);
+		m_droppedByType = std::vector<float>(TYPE_COUNT, 0.0f);
+		m_latencyP50ByType = std::vector<float>(TYPE_COUNT, 0.0f);
+		m_latencyP99ByType = std::vector<float>(TYPE_COUNT, 0.0f);
+	}
+
+	size_t IpcStats::BucketIndex(int64_t latencyMicroseconds) {
+		size_t index = 0;
+		while (latencyMicroseconds > 0 && index < BUCKET_COUNT - 1) {
+			latencyMicroseconds >>= 1;
+			index++;
+		}
+		return index;
+	}
+
+	float IpcStats::Percentile(const Histogram& histogram, uint64_t total, double fraction) {
+		if (total == 0) return 0.0f;
+
+		// reports the upper bound of the bucket, i.e. the latency is at most this
+		const uint64_t rank = static_cast<uint64_t>(std::ceil(total * fraction));
+		uint64_t count = 0;
+		for (size_t i = 0; i < BUCKET_COUNT; i++) {
+			count += histogram[i];
+			if (count >= rank) {
+				return static_cast<float>(uint64_t(1) << i) / 1000.0f;
+			}
+		}
+		return static_cast<float>(uint64_t(1) << (BUCKET_COUNT - 1)) / 1000.0f;
+	}
+
+	void IpcStats::RecordReceived(MessageId id, const MessageStamp& stamp, int64_t receivedAt) {
+		if (id == MessageId::Unknown || id >= MessageId::Count) return;
+
+		TypeCounters& counters = m_types[static_cast<size_t>(id)];
+		counters.Received++;
+
+		if (stamp.sequence == 0) return; // older client, nothing to measure
+
+		if (stamp.sequence > counters.LastSequence) {
+			if (counters.LastSequence != 0) {
+				counters.Dropped += stamp.sequence - counters.LastSequence - 1;
+			}
+			counters.LastSequence = stamp.sequence;
+		}
+		else if (counters.LastSequence - stamp.sequence > REORDER_WINDOW) {
+			counters.LastSequence = stamp.sequence;
+		}
+
+		const int64_t latency = receivedAt - stamp.sentAt;
+		if (stamp.sentAt > 0 && latency >= 0 && latency <= MAX_PLAUSIBLE_LATENCY) {
+			counters.Buckets[BucketIndex(latency)].fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void IpcStats::RecordPositionApplied(int64_t sentAt, int64_t appliedAt) {
+		const int64_t latency = appliedAt - sentAt;
+		if (sentAt > 0 && latency >= 0 && latency <= MAX_PLAUSIBLE_LATENCY) {
+			m_positionWindow[BucketIndex(latency)]++;
+		}
+	}
+
+	void IpcStats::Update(float elapsedSinceLastCall, uint64_t sharedMemoryDropped) {
+		m_publishTimer += elapsedSinceLastCall;
+		if (m_publishTimer < PUBLISH_INTERVAL) return;
+		m_publishTimer = 0.0f;
+
+		uint64_t received = 0;
+		uint64_t dropped = 0;
+		Histogram all{};
+		uint64_t allSamples = 0;
+
+		std::vector<float> receivedByType(TYPE_COUNT, 0.0f);
+		std::vector<float> droppedByType(TYPE_COUNT, 0.0f);
+		std::vector<float> p50ByType(TYPE_COUNT, 0.0f);
+		std::vector<float> p99ByType(TYPE_COUNT, 0.0f);
+
+		for (size_t type = 0; type < TYPE_COUNT; type++) {
+			TypeCounters& counters = m_types[type];
+
+			// the buckets only cover the last interval, so the datarefs show current latency
+			Histogram window{};
+			uint64_t samples = 0;
+			for (size_t i = 0; i < BUCKET_COUNT; i++) {
+				window[i] = counters.Buckets[i].exchange(0, std::memory_order_relaxed);
+				samples += window[i];
+				all[i] += window[i];
+				m_logWindow[type][i] += window[i];
+			}
+			allSamples += samples;
+
+			const uint64_t typeReceived = counters.Received.load();
+			const uint64_t typeDropped = counters.Dropped.load();
+			received += typeReceived;
+			dropped += typeDropped;
+
+			receivedByType[type] = static_cast<float>(typeReceived);
+			droppedByType[type] = static_cast<float>(typeDropped);
+			p50ByType[type] = Percentile(window, samples, 0.50);
+			p99ByType[type] = Percentile(window, samples, 0.99);
+		}
+
+		const uint64_t sendsDropped = m_sendsDropped.load() + sharedMemoryDropped;
+
+		m_messagesReceived = static_cast<int>(received);
+		m_messagesDropped = static_cast<int>(dropped);
+		m_sendsDroppedRef = static_cast<int>(sendsDropped);
+		m_latencyP50 = Percentile(all, allSamples, 0.50);
+		m_latencyP99 = Percentile(all, allSamples, 0.99);
+
+		uint64_t positionSamples = 0;
+		for (size_t i = 0; i < BUCKET_COUNT; i++) {
+			positionSamples += m_positionWindow[i];
+			m_positionLogWindow[i] += m_positionWindow[i];
+		}
+		m_positionLatencyP50 = Percentile(m_positionWindow, positionSamples, 0.50);
+		m_positionLatencyP99 = Percentile(m_positionWindow, positionSamples, 0.99);
+		m_positionWindow.fill(0);
+		m_receivedByType = receivedByType;
+		m_droppedByType = droppedByType;
+		m_latencyP50ByType = p50ByType;
+		m_latencyP99ByType = p99ByType;
+
+		m_logTimer += PUBLISH_INTERVAL;
+		if (m_logTimer < LOG_INTERVAL) return;
+		m_logTimer = 0.0f;
+
+		std::string summary;
+		for (size_t type = 0; type < TYPE_COUNT; type++) {
+			Histogram& window = m_logWindow[type];
+			uint64_t samples = 0;
+			for (uint32_t count : window) samples += count;
+
+			if (samples > 0) {
+				char buf[128];
+				snprintf(buf, sizeof(buf), " %s: n=%llu p50=%.2fms p99=%.2fms dropped=%llu;",
+					MESSAGE_NAMES[type]->c_str(), (unsigned long long)samples,
+					Percentile(window, samples, 0.50), Percentile(window, samples, 0.99),
+					(unsigned long long)m_types[type].Dropped.load());
+				summary += buf;
+			}
+			window.fill(0);
+		}
+
+		uint64_t appliedSamples = 0;
+		for (uint32_t count : m_positionLogWindow) appliedSamples += count;
+		if (appliedSamples > 0) {
+			char buf[128];
+			snprintf(buf, sizeof(buf), " positions applied: n=%llu p50=%.2fms p99=%.2fms;",
+				(unsigned long long)appliedSamples, Percentile(m_positionLogWindow, appliedSamples, 0.50),
+				Percentile(m_positionLogWindow, appliedSamples, 0.99));
+			summary += buf;
+		}
+		m_positionLogWindow.fill(0);
+
+		if (!summary.empty()) {
+			LOG_MSG(logINFO, "IPC stats: received=%llu dropped=%llu sends_dropped=%llu, last %.0fs:%s",
+				(unsigned long long)received, (unsigned long long)dropped, (unsigned long long)sendsDropped,
+				LOG_INTERVAL, summary.c_str());
+		}
+	}
+}
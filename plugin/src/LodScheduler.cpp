@@ -0,0 +1,151 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "LodScheduler.h"
+#include "NetworkAircraft.h"
+#include "Config.h"
+
+#include <XPLMCamera.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace xpilot {
+	namespace {
+		constexpr float NEAR_DISTANCE = 3000.0f; // [m]
+		constexpr float IN_VIEW_DISTANCE = 20000.0f; // [m]
+		constexpr float IN_VIEW_HALF_ANGLE = 60.0f; // [deg] either side of the camera heading
+		constexpr float TIER_DISTANCES[] = { NEAR_DISTANCE, 10000.0f, 30000.0f }; // [m] upper bounds of tiers 0..2
+		constexpr int TIER_PERIODS[LodScheduler::TIER_COUNT] = { 1, 2, 4, 8 }; // [frames]
+		constexpr double MAX_DEFERRAL = 1.0; // [s]
+		constexpr double COST_SMOOTHING = 0.05;
+	}
+
+	LodScheduler::LodScheduler() :
+		m_latRef("sim/flightmodel/position/lat_ref", ReadOnly),
+		m_lonRef("sim/flightmodel/position/lon_ref", ReadOnly) {
+	}
+
+	LodScheduler& LodScheduler::GetInstance() {
+		static LodScheduler instance;
+		return instance;
+	}
+
+	void LodScheduler::Register(NetworkAircraft* aircraft) {
+		aircraft->LodPhase = m_nextPhase++;
+		m_aircraft.push_back(aircraft);
+	}
+
+	void LodScheduler::Unregister(NetworkAircraft* aircraft) {
+		m_aircraft.erase(std::remove(m_aircraft.begin(), m_aircraft.end(), aircraft), m_aircraft.end());
+
+		// don't keep idle threads around, and have them joined before the plugin is unloaded
+		if (m_aircraft.empty()) {
+			m_predictor.StopWorkers();
+		}
+	}
+
+	void LodScheduler::RecordFullUpdate(int64_t microseconds) {
+		m_averageCost += (static_cast<double>(microseconds) - m_averageCost) * COST_SMOOTHING;
+	}
+
+	size_t LodScheduler::GetTier(const NetworkAircraft* aircraft, float cameraHeading) const {
+		const float distance = aircraft->GetCameraDist();
+		if (distance < NEAR_DISTANCE) return 0;
+
+		float offAxis = std::fabs(std::fmod(aircraft->GetCameraBearing() - cameraHeading + 540.0f, 360.0f) - 180.0f);
+		if (offAxis <= IN_VIEW_HALF_ANGLE && distance < IN_VIEW_DISTANCE) return 0;
+
+		for (size_t tier = 1; tier < TIER_COUNT - 1; tier++) {
+			if (distance < TIER_DISTANCES[tier]) return tier;
+		}
+		return TIER_COUNT - 1;
+	}
+
+	void LodScheduler::BeginFrame(int flightLoopCounter, float frameRatePeriod) {
+		if (flightLoopCounter == m_lastFlightLoopCounter) return;
+		m_lastFlightLoopCounter = flightLoopCounter;
+		m_frame++;
+
+		XPLMCameraPosition_t camera;
+		XPLMReadCameraPosition(&camera);
+
+		// parked aircraft and local frame anchors are in the old local coordinates
+		const float latRef = m_latRef;
+		const float lonRef = m_lonRef;
+		const bool sceneryShifted = latRef != m_lastLatRef || lonRef != m_lastLonRef;
+		m_lastLatRef = latRef;
+		m_lastLonRef = lonRef;
+
+		m_due.clear();
+		m_candidates.clear();
+		m_tierCounts.fill(0);
+		m_parkedCount = 0;
+
+		for (NetworkAircraft* aircraft : m_aircraft) {
+			if (sceneryShifted) {
+				aircraft->InvalidateLocalFrame();
+				aircraft->WakeUp();
+			}
+			if (aircraft->IsParked) {
+				aircraft->IsFullUpdateDue = false;
+				m_parkedCount++;
+				continue;
+			}
+
+			aircraft->LodElapsed += frameRatePeriod;
+			aircraft->LodTier = static_cast<int>(GetTier(aircraft, camera.heading));
+			m_tierCounts[aircraft->LodTier]++;
+
+			const int period = TIER_PERIODS[aircraft->LodTier];
+			if (aircraft->IsFirstRenderPending || period == 1 || aircraft->LodElapsed >= MAX_DEFERRAL) {
+				aircraft->IsFullUpdateDue = true;
+				m_due.push_back(aircraft);
+			} else if (aircraft->LodDeferred || (m_frame + aircraft->LodPhase) % period == 0) {
+				m_candidates.push_back(aircraft);
+			} else {
+				aircraft->IsFullUpdateDue = false;
+			}
+		}
+
+		// distant aircraft share what's left of the budget, nearest tier and longest waiting first
+		const double budget = Config::GetInstance().GetAircraftUpdateBudget() * 1000.0;
+		const double remaining = budget - m_due.size() * m_averageCost;
+		const size_t allowed = remaining > 0.0 ? static_cast<size_t>(remaining / (std::max)(m_averageCost, 1.0)) : 0;
+
+		if (m_candidates.size() > allowed) {
+			std::sort(m_candidates.begin(), m_candidates.end(), [](const NetworkAircraft* a, const NetworkAircraft* b) {
+				return a->LodTier != b->LodTier ? a->LodTier < b->LodTier : a->LodElapsed > b->LodElapsed;
+			});
+		}
+
+		m_deferredCount = 0;
+		for (size_t i = 0; i < m_candidates.size(); i++) {
+			NetworkAircraft* aircraft = m_candidates[i];
+			aircraft->LodDeferred = i >= allowed;
+			aircraft->IsFullUpdateDue = !aircraft->LodDeferred;
+			if (aircraft->IsFullUpdateDue) {
+				m_due.push_back(aircraft);
+			} else {
+				m_deferredCount++;
+			}
+		}
+
+		m_predictor.Advance(m_due);
+	}
+}
@@ -17,12 +17,14 @@
 */
 
 #include "NetworkAircraft.h"
+#include "LodScheduler.h"
+#include "PositionExtrapolation.h"
 #include "Utilities.h"
 #include "Config.h"
 #include "GeoCalc.hpp"
 #include "Quaternion.hpp"
+#include <XPLMGraphics.h>
 #include <chrono>
-#include <regex>
 #include <cassert>
 
 namespace xpilot {
@@ -30,6 +32,11 @@ namespace xpilot {
 	constexpr double TERRAIN_OFFSET_WINDOW_LANDING = 2.0;
 	constexpr double TERRAIN_OFFSET_WINDOW_CLIMBOUT = 10.0;
 	constexpr double MIN_TERRAIN_OFFSET_MAGNITUDE = 0.1;
+	constexpr double PARKED_MAX_VELOCITY = 0.01; // [m/s]
+	constexpr double PARKED_MAX_ROTATION = 0.0005; // [rad/s]
+	constexpr double LOCAL_ANCHOR_STEP = 0.001; // [deg] for the per degree derivatives
+	constexpr double LOCAL_ANCHOR_MAX_OFFSET = 0.01; // [deg] re-anchor beyond this without a network update
+	constexpr double EARTH_RADIUS_M = 6371000.0;
 
 	double CalculateNormalizedDelta(double start, double end, double lowerBound, double upperBound) {
 		double range = upperBound - lowerBound;
@@ -42,17 +49,6 @@ namespace xpilot {
 		return end - start;
 	}
 
-	double NormalizeDegrees(double value, double lowerBound, double upperBound) {
-		double range = upperBound - lowerBound;
-		if (value < lowerBound) {
-			return value + range;
-		}
-		if (value > upperBound) {
-			return value - range;
-		}
-		return value;
-	}
-
 	float RpmToDegree(float rpm, double s) {
 		return rpm / 60.0f * float(s) * 360.0f;
 	}
@@ -74,9 +70,11 @@ namespace xpilot {
 		const std::string& _icaoType,
 		const std::string& _icaoAirline,
 		const std::string& _livery,
-		XPMPPlaneID _modeS_id = 0,
-		const std::string& _modelName = "") :
-		XPMP2::Aircraft(_callsign, _icaoType, _icaoAirline, _livery, _modeS_id, _modelName) {
+		XPMPPlaneID _modeS_id,
+		const std::string& _modelName,
+		TerrainElevationCache& _terrainCache) :
+		XPMP2::Aircraft(_callsign, _icaoType, _icaoAirline, _livery, _modeS_id, _modelName),
+		TerrainCache(_terrainCache) {
 		strScpy(acInfoTexts.tailNum, _callsign.c_str(), sizeof(acInfoTexts.tailNum));
 		strScpy(acInfoTexts.icaoAcType, acIcaoType.c_str(), sizeof(acInfoTexts.icaoAcType));
 		strScpy(acInfoTexts.icaoAirline, acIcaoAirline.c_str(), sizeof(acInfoTexts.icaoAirline));
@@ -117,64 +115,35 @@ namespace xpilot {
 				EngineClass = EngineClassType::TurboProp;
 			}
 		}
+
+		LodScheduler::GetInstance().Register(this);
+	}
+
+	NetworkAircraft::~NetworkAircraft() {
+		LodScheduler::GetInstance().Unregister(this);
 	}
 
 	AircraftVisualState NetworkAircraft::ExtrapolatePosition(
 		Vector3 velocityVector,
 		Vector3 rotationVector,
 		double interval) {
-		double lat_change = MetersToDegrees(velocityVector.Z * interval);
-		double new_lat = NormalizeDegrees(PredictedVisualState.Lat + lat_change, -90.0, 90.0);
-
-		double lon_change = MetersToDegrees(velocityVector.X * interval / LongitudeScalingFactor(PredictedVisualState.Lat));
-		double new_lon = NormalizeDegrees(PredictedVisualState.Lon + lon_change, -180.0, 180.0);
-
-		double alt_change = velocityVector.Y * interval * 3.28084;
-		double new_alt = PredictedVisualState.AltitudeTrue + alt_change;
-
-		double pitch;
-		double bank;
-		double heading;
-
-		if (rotationVector == Vector3::Zero()) {
-			pitch = PredictedVisualState.Pitch;
-			bank = PredictedVisualState.Bank;
-			heading = PredictedVisualState.Heading;
-		} else {
-			Quaternion current_orientation = Quaternion::FromEuler(
-				DegreesToRadians(PredictedVisualState.Pitch),
-				DegreesToRadians(PredictedVisualState.Heading),
-				DegreesToRadians(PredictedVisualState.Bank)
-			);
-
-			Quaternion rotation = Quaternion::FromEuler(
-				rotationVector.X,
-				rotationVector.Y,
-				rotationVector.Z
-			);
-
-			Quaternion slerp = Quaternion::Slerp(
-				Quaternion::Identity(),
-				rotation,
-				interval > 1.0 ? 1.0 : interval
-			);
-
-			Quaternion result = current_orientation * slerp;
-
-			Vector3 new_orientation = Quaternion::ToEuler(result);
-
-			pitch = RadiansToDegrees(new_orientation.X);
-			heading = RadiansToDegrees(new_orientation.Y);
-			bank = RadiansToDegrees(new_orientation.Z);
-		}
+		const ExtrapolatedPose current{
+			PredictedVisualState.Lat,
+			PredictedVisualState.Lon,
+			PredictedVisualState.AltitudeTrue,
+			PredictedVisualState.Pitch,
+			PredictedVisualState.Heading,
+			PredictedVisualState.Bank
+		};
+		const ExtrapolatedPose pose = ExtrapolatePose(current, velocityVector, rotationVector, interval);
 
 		AircraftVisualState predictedVisualState{};
-		predictedVisualState.Lat = new_lat;
-		predictedVisualState.Lon = new_lon;
-		predictedVisualState.AltitudeTrue = new_alt;
-		predictedVisualState.Pitch = pitch;
-		predictedVisualState.Bank = bank;
-		predictedVisualState.Heading = heading;
+		predictedVisualState.Lat = pose.Lat;
+		predictedVisualState.Lon = pose.Lon;
+		predictedVisualState.AltitudeTrue = pose.AltitudeTrue;
+		predictedVisualState.Pitch = pose.Pitch;
+		predictedVisualState.Bank = pose.Bank;
+		predictedVisualState.Heading = pose.Heading;
 
 		return predictedVisualState;
 	}
@@ -183,69 +152,107 @@ namespace xpilot {
 		if (!LocalTerrainElevation.has_value())
 			return;
 
-		HasUsableTerrainElevationData = false;
-
-		TerrainElevationHistory.remove_if([&](TerrainElevationData& meta) {
-			return meta.Timestamp < (currentTimestamp - TERRAIN_ELEVATION_DATA_USABLE_AGE + 250);
-		});
+		HasUsableTerrainElevationData = TerrainElevationHistory.Record(currentTimestamp,
+			VisualState.Lat, VisualState.Lon, VisualState.AltitudeAgl, LocalTerrainElevation.value());
+	}
 
-		if (VisualState.AltitudeAgl.has_value() && (VisualState.AltitudeAgl.value() <= MAX_USABLE_ALTITUDE_AGL)) {
-			TerrainElevationData data{};
-			data.Timestamp = currentTimestamp;
-			data.Location.Latitude = VisualState.Lat;
-			data.Location.Longitude = VisualState.Lon;
-			data.LocalValue = LocalTerrainElevation.value();
-			TerrainElevationHistory.push_back(data);
-		} else {
-			return;
+	void NetworkAircraft::UpdateVelocityVectors() {
+		auto currentTimestamp = PrecisionTimestamp();
+		if (currentTimestamp - LastVelocityUpdate > 500) {
+			ClearRotationalVelocities();
 		}
+		LastVelocityUpdate = currentTimestamp;
+		RecordTerrainElevationHistory(currentTimestamp);
+		UpdateErrorVectors(currentTimestamp);
 
-		if (TerrainElevationHistory.size() < 2) {
-			return;
-		}
+		// the error vectors are relative to the last full update, so don't let a distant aircraft wait for its turn
+		LodDeferred = true;
+		InvalidateLocalFrame();
+		WakeUp();
+	}
 
-		auto startSample = TerrainElevationHistory.front();
-		auto endSample = TerrainElevationHistory.back();
-		if ((endSample.Timestamp - startSample.Timestamp) < TERRAIN_ELEVATION_DATA_USABLE_AGE) {
-			return;
-		}
+	void NetworkAircraft::AnchorLocalFrame(double lat, double lon, double altitudeTrue) {
+		const double altitudeMeters = altitudeTrue / 3.28084;
+		double x, y, z, xLat, yLat, zLat, xLon, yLon, zLon;
+		XPLMWorldToLocal(lat, lon, altitudeMeters, &x, &y, &z);
+		XPLMWorldToLocal(lat + LOCAL_ANCHOR_STEP, lon, altitudeMeters, &xLat, &yLat, &zLat);
+		XPLMWorldToLocal(lat, lon + LOCAL_ANCHOR_STEP, altitudeMeters, &xLon, &yLon, &zLon);
+
+		LocalAnchor.Valid = true;
+		LocalAnchor.Lat = lat;
+		LocalAnchor.Lon = lon;
+		LocalAnchor.AltitudeTrue = altitudeTrue;
+		LocalAnchor.Position = Vector3(x, y, z);
+		LocalAnchor.PerDegreeLat = Vector3(xLat - x, yLat - y, zLat - z) / LOCAL_ANCHOR_STEP;
+		LocalAnchor.PerDegreeLon = Vector3(xLon - x, yLon - y, zLon - z) / LOCAL_ANCHOR_STEP;
+	}
 
-		double distance = DegreesToFeet(GreatCircleDistance(
-			startSample.Location.Longitude, startSample.Location.Latitude,
-			endSample.Location.Longitude, endSample.Location.Latitude));
-		double remoteElevationDelta = abs(startSample.RemoteValue - endSample.RemoteValue);
-		double localElevationDelta = abs(startSample.LocalValue - endSample.LocalValue);
-		double remoteSlope = RadiansToDegrees(atan(remoteElevationDelta / distance));
-		if (remoteSlope > TERRAIN_ELEVATION_MAX_SLOPE) {
+	void NetworkAircraft::SetPredictedLocation(double lat, double lon, double altitudeTrue) {
+		if (!Config::GetInstance().GetLocalFrameExtrapolation()) {
+			SetLocation(lat, lon, altitudeTrue);
 			return;
 		}
-		double localSlope = RadiansToDegrees(atan(localElevationDelta / distance));
-		if (localSlope > TERRAIN_ELEVATION_MAX_SLOPE) {
-			return;
+
+		// XPLMWorldToLocal only when anchoring; in between the local position is linear in lat/lon,
+		// plus the drop of the earth's surface below the anchor's tangent plane
+		if (!LocalAnchor.Valid
+			|| std::abs(lat - LocalAnchor.Lat) > LOCAL_ANCHOR_MAX_OFFSET
+			|| std::abs(CalculateNormalizedDelta(LocalAnchor.Lon, lon, -180.0, 180.0)) > LOCAL_ANCHOR_MAX_OFFSET) {
+			AnchorLocalFrame(lat, lon, altitudeTrue);
 		}
 
-		HasUsableTerrainElevationData = true;
+		const double dLat = lat - LocalAnchor.Lat;
+		const double dLon = CalculateNormalizedDelta(LocalAnchor.Lon, lon, -180.0, 180.0);
+		const Vector3 offset = LocalAnchor.PerDegreeLat * dLat + LocalAnchor.PerDegreeLon * dLon;
+		const double drop = (offset.X * offset.X + offset.Z * offset.Z) / (2.0 * EARTH_RADIUS_M);
+
+		SetLocalLoc(
+			static_cast<float>(LocalAnchor.Position.X + offset.X),
+			static_cast<float>(LocalAnchor.Position.Y + offset.Y - drop + (altitudeTrue - LocalAnchor.AltitudeTrue) / 3.28084) + GetVertOfs(),
+			static_cast<float>(LocalAnchor.Position.Z + offset.Z));
 	}
 
-	void NetworkAircraft::UpdateVelocityVectors() {
-		auto currentTimestamp = PrecisionTimestamp();
-		if (currentTimestamp - LastVelocityUpdate > 500) {
-			ClearRotationalVelocities();
-		}
-		LastVelocityUpdate = currentTimestamp;
-		RecordTerrainElevationHistory(currentTimestamp);
-		UpdateErrorVectors(currentTimestamp);
+	void NetworkAircraft::WakeUp() {
+		if (!IsParked) return;
+		IsParked = false;
+		LodElapsed = 0.0;
+		LodDeferred = true;
+		// surfaces continue from where they stopped instead of jumping by the time spent parked
+		PreviousSurfaceUpdateTime = PrecisionTimestamp();
+	}
+
+	bool NetworkAircraft::CanPark(int64_t currentTimestamp) const {
+		auto isStill = [](const Vector3& v, double limit) {
+			return std::abs(v.X) < limit && std::abs(v.Y) < limit && std::abs(v.Z) < limit;
+		};
+		auto isSettled = [](float surface, float target) {
+			return std::abs(surface - target) <= std::numeric_limits<float>::epsilon();
+		};
+
+		return !IsFirstRenderPending
+			&& !IsEnginesRunning
+			&& isStill(PositionalVelocities, PARKED_MAX_VELOCITY)
+			&& isStill(RotationalVelocities, PARKED_MAX_ROTATION)
+			&& (currentTimestamp >= ApplyErrorVelocitiesUntil
+				|| (isStill(PositionalErrorVelocities, PARKED_MAX_VELOCITY) && isStill(RotationalErrorVelocities, PARKED_MAX_ROTATION)))
+			&& TerrainOffset == TargetTerrainOffset
+			&& isSettled(Surfaces.gearPosition, TargetGearPosition)
+			&& isSettled(Surfaces.flapRatio, TargetFlapsPosition)
+			&& isSettled(Surfaces.spoilerRatio, TargetSpoilerPosition)
+			&& isSettled(Surfaces.reversRatio, TargetReverserPosition);
 	}
 
 	void NetworkAircraft::PerformGroundClamping(float frameRate) {
 		LocalTerrainElevation = {};
 		if (PredictedVisualState.AltitudeTrue < 18000.0) {
-			LocalTerrainElevation = LocalTerrainProbe.GetTerrainElevation(
+			LocalTerrainElevation = TerrainCache.GetTerrainElevation(
 				PredictedVisualState.Lat,
 				PredictedVisualState.Lon
 			);
 		}
 
+		// no scenery under the aircraft: leave it at its reported altitude rather than clamping
+		// to 0 ft as the old per-aircraft probe did
 		AdjustedAltitude = {};
 		if (!LocalTerrainElevation.has_value())
 			return;
@@ -372,32 +379,60 @@ namespace xpilot {
 		ApplyErrorVelocitiesUntil = currentTimestamp + 2000;
 	}
 
-	void NetworkAircraft::UpdatePosition(float _frameRatePeriod, int) {
+	void NetworkAircraft::PrepareExtrapolation(int64_t currentTimestamp, Vector3& positionalVelocities, Vector3& rotationalVelocities) {
+		if (currentTimestamp - LastVelocityUpdate > 500) {
+			ClearRotationalVelocities();
+		}
+
+		positionalVelocities = PositionalVelocities;
+		rotationalVelocities = RotationalVelocities;
+
+		if (currentTimestamp <= ApplyErrorVelocitiesUntil) {
+			positionalVelocities += PositionalErrorVelocities;
+			rotationalVelocities += RotationalErrorVelocities;
+		}
+	}
+
+	void NetworkAircraft::UpdateLodPosition() {
+		// dead reckoning from the last full update; attitude, terrain offset and animation stay put
+		double lat = NormalizeDegrees(PredictedVisualState.Lat + MetersToDegrees(PositionalVelocities.Z * LodElapsed), -90.0, 90.0);
+		double lon = NormalizeDegrees(PredictedVisualState.Lon + MetersToDegrees(PositionalVelocities.X * LodElapsed
+			/ LongitudeScalingFactor(PredictedVisualState.Lat)), -180.0, 180.0);
+		double alt = AdjustedAltitude.value_or(PredictedVisualState.AltitudeTrue) + PositionalVelocities.Y * LodElapsed * 3.28084;
+		SetPredictedLocation(lat, lon, alt);
+	}
+
+	void NetworkAircraft::UpdatePosition(float _frameRatePeriod, int _flightLoopCounter) {
+		// the first aircraft of this flight loop decides which aircraft are due and extrapolates them in one pass
+		LodScheduler::GetInstance().BeginFrame(_flightLoopCounter, _frameRatePeriod);
+
+		if (IsParked) {
+			// position and animation are unchanged, so XPMP2 won't even touch the instance
+			HexToRgb(Config::GetInstance().GetAircraftLabelColor(), colLabel);
+			return;
+		}
+
+		if (!IsFullUpdateDue) {
+			UpdateLodPosition();
+			return;
+		}
+
+		const auto updateStart = std::chrono::steady_clock::now();
 		auto currentTimestamp = PrecisionTimestamp();
 
+		// time since the last full update, which is longer than a frame for distant aircraft
+		const float elapsed = IsFirstRenderPending ? _frameRatePeriod : static_cast<float>(LodElapsed);
+		LodElapsed = 0.0;
+
 		if (IsFirstRenderPending) {
 			PredictedVisualState = VisualState;
 			PositionalErrorVelocities = Vector3::Zero();
 			RotationalErrorVelocities = Vector3::Zero();
-		} else {
-			if (currentTimestamp - LastVelocityUpdate > 500) {
-				ClearRotationalVelocities();
-			}
-
-			Vector3 positionalVelocities = PositionalVelocities;
-			Vector3 rotationalVelocities = RotationalVelocities;
-
-			if (currentTimestamp <= ApplyErrorVelocitiesUntil) {
-				positionalVelocities += PositionalErrorVelocities;
-				rotationalVelocities += RotationalErrorVelocities;
-			}
-
-			PredictedVisualState = ExtrapolatePosition(positionalVelocities, rotationalVelocities, _frameRatePeriod);
 		}
 
-		PerformGroundClamping(1.0 / _frameRatePeriod);
+		PerformGroundClamping(1.0 / elapsed);
 
-		SetLocation(PredictedVisualState.Lat, PredictedVisualState.Lon, AdjustedAltitude.has_value() ? AdjustedAltitude.value() : PredictedVisualState.AltitudeTrue);
+		SetPredictedLocation(PredictedVisualState.Lat, PredictedVisualState.Lon, AdjustedAltitude.has_value() ? AdjustedAltitude.value() : PredictedVisualState.AltitudeTrue);
 		SetPitch(PredictedVisualState.Pitch);
 		SetRoll(PredictedVisualState.Bank);
 		SetHeading(PredictedVisualState.Heading);
@@ -438,7 +473,7 @@ namespace xpilot {
 
 		if (IsReportedOnGround) {
 			double rpm = (60 / (2 * M_PI * 3.2)) * abs(PositionalVelocities.X);
-			double rpmDeg = RpmToDegree(GetTireRotRpm(), _frameRatePeriod);
+			double rpmDeg = RpmToDegree(GetTireRotRpm(), elapsed);
 			SetTireRotRpm(rpm);
 			SetTireRotAngle(GetTireRotAngle() + rpmDeg);
 			while (GetTireRotAngle() >= 360.0f)
@@ -448,7 +483,7 @@ namespace xpilot {
 		if (IsEnginesRunning) {
 			SetEngineRotRpm(1200);
 			SetPropRotRpm(GetEngineRotRpm());
-			SetEngineRotAngle(GetEngineRotAngle() + RpmToDegree(GetEngineRotRpm(), _frameRatePeriod));
+			SetEngineRotAngle(GetEngineRotAngle() + RpmToDegree(GetEngineRotRpm(), elapsed));
 			while (GetEngineRotAngle() >= 360.0f) {
 				SetEngineRotAngle(GetEngineRotAngle() - 360.0f);
 			}
@@ -465,6 +500,10 @@ namespace xpilot {
 		HexToRgb(Config::GetInstance().GetAircraftLabelColor(), colLabel);
 
 		IsFirstRenderPending = false;
+		IsParked = CanPark(currentTimestamp);
+
+		LodScheduler::GetInstance().RecordFullUpdate(std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - updateStart).count());
 	}
 
 	void NetworkAircraft::copyBulkData(XPilotAPIAircraft::XPilotAPIBulkData* pOut, size_t size) const {
@@ -512,33 +551,6 @@ namespace xpilot {
 		STRCPY_ATMOST(pOut->destination, Destination);
 	}
 
-	void FlightModel::InitializeModels() {
-		// Huge Jets
-		modelMatches.push_back({ "HugeJets","^(H|J);L\\dJ;" });
-		modelMatches.push_back({ "HugeJets","^M;L4J;" });
-
-		// Biz Jets
-		modelMatches.push_back({ "BizJet","^M;L\\dJ;*BEECH*" });     // Beech, Beechcraft
-		modelMatches.push_back({ "BizJet","^M;L\\dJ;GLF" });         // Grumman Gulfstream
-		modelMatches.push_back({ "BizJet","^M;L\\dJ;LJ" });          // Learjet
-		modelMatches.push_back({ "BizJet","^M;L\\dJ;*BEECH*" });     // Beech, Beechcraft
-		modelMatches.push_back({ "BizJet","^M;L\\dJ;.*;CESSNA" });   // Cessna
-		modelMatches.push_back({ "BizJet","^M;L\\dJ;.*;DASSAULT" }); // Dassault (Falcon)
-
-		// Medium Jets
-		modelMatches.push_back({ "MediumJets","^M;L\\dJ;" });
-		modelMatches.push_back({ "MediumProps","^M;L\\dT;" });
-		modelMatches.push_back({ "BizJet","^L;L\\dJ;" });
-		modelMatches.push_back({ "Glider",";(GLID|A20J|A33P|A33E|A34E|ARCE|ARCP|AS14|AS16|AS20|AS21|AS22|AS24|AS25|AS26|AS28|AS29|AS30|AS31|DG1T|DG40|DG50|DG60|DG80|DIMO|DISC|DUOD|G103|G109|HU1|HU2|JANU|L13M|LAE1|LK17|LK19|LK20|LS8|LS9|NIMB|PISI|PITE|PITA|PIT4|PK15|PK20|S10S|S32M|S32E|SF24|SF25|SF27|SF28|SF31|SZ45|SZ9M|TS1J|VENT);" });
-		modelMatches.push_back({ "LightAC", "^-" });
-		modelMatches.push_back({ "TurboProps", "^L;L\\dT;" });
-		modelMatches.push_back({ "GA", "^L;L\\dP;" });
-		modelMatches.push_back({ "Heli", "^.;H" });
-
-		// Fallback
-		modelMatches.push_back({ "MediumJets", ".*" });
-	}
-
 	float NetworkAircraft::GetLift() const
 	{
 		// No wake if the aircraft is reported on the ground
@@ -546,50 +558,6 @@ namespace xpilot {
 	}
 
 	FlightModel NetworkAircraft::GetFlightModel(const XPMP2::CSLModelInfo_t model) {
-		std::string classification = string_format("%s;%s;%s;", model.doc8643WTC.c_str(), model.doc8643Classification.c_str(), model.icaoType.c_str());
-		std::string category = "MediumJets";
-
-		for (const auto& mapIt : FlightModel::modelMatches) {
-			std::smatch m;
-			std::regex re(mapIt.regex.c_str());
-			std::regex_search(classification, m, re);
-			if (m.size() > 0) {
-				category = mapIt.category;
-				break;
-			}
-		}
-
-		FlightModel flightModel = {};
-		flightModel.modelCategory = category;
-
-		if (category == "HugeJets") {
-			flightModel.FLAPS_DURATION = 10000;
-			flightModel.GEAR_DURATION = 10000;
-			flightModel.GEAR_DEFLECTION = 1.4;
-		} else if (category == "BizJet") {
-			flightModel.FLAPS_DURATION = 5000;
-			flightModel.GEAR_DURATION = 0.25;
-			flightModel.GEAR_DEFLECTION = 0.5;
-		} else if (category == "GA") {
-			flightModel.FLAPS_DURATION = 5000;
-			flightModel.GEAR_DURATION = 10000;
-			flightModel.GEAR_DEFLECTION = 0.25;
-		} else if (category == "LightAC") {
-			flightModel.FLAPS_DURATION = 5000;
-			flightModel.GEAR_DURATION = 10000;
-			flightModel.GEAR_DEFLECTION = 0.25;
-		} else if (category == "Heli") {
-			flightModel.FLAPS_DURATION = 5000;
-			flightModel.GEAR_DURATION = 10000;
-			flightModel.GEAR_DEFLECTION = 0.25;
-		} else {
-			flightModel.FLAPS_DURATION = 5000;
-			flightModel.GEAR_DURATION = 10000;
-			flightModel.GEAR_DEFLECTION = 0.5;
-		}
-
-		return flightModel;
+		return FlightModel::ForClassification(model.doc8643WTC, model.doc8643Classification, model.icaoType);
 	}
-
-	std::vector<FlightModelInfo> FlightModel::modelMatches;
 }
\ No newline at end of file
@@ -0,0 +1,91 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "PositionExtrapolation.h"
+#include "GeoCalc.hpp"
+#include "Quaternion.hpp"
+
+namespace xpilot {
+	double NormalizeDegrees(double value, double lowerBound, double upperBound) {
+		double range = upperBound - lowerBound;
+		if (value < lowerBound) {
+			return value + range;
+		}
+		if (value > upperBound) {
+			return value - range;
+		}
+		return value;
+	}
+
+	ExtrapolatedPose ExtrapolatePose(const ExtrapolatedPose& pose, const Vector3& velocityVector,
+		const Vector3& rotationVector, double interval) {
+		double lat_change = MetersToDegrees(velocityVector.Z * interval);
+		double new_lat = NormalizeDegrees(pose.Lat + lat_change, -90.0, 90.0);
+
+		double lon_change = MetersToDegrees(velocityVector.X * interval / LongitudeScalingFactor(pose.Lat));
+		double new_lon = NormalizeDegrees(pose.Lon + lon_change, -180.0, 180.0);
+
+		double alt_change = velocityVector.Y * interval * 3.28084;
+		double new_alt = pose.AltitudeTrue + alt_change;
+
+		double pitch;
+		double bank;
+		double heading;
+
+		if (rotationVector == Vector3::Zero()) {
+			pitch = pose.Pitch;
+			bank = pose.Bank;
+			heading = pose.Heading;
+		} else {
+			Quaternion current_orientation = Quaternion::FromEuler(
+				DegreesToRadians(pose.Pitch),
+				DegreesToRadians(pose.Heading),
+				DegreesToRadians(pose.Bank)
+			);
+
+			Quaternion rotation = Quaternion::FromEuler(
+				rotationVector.X,
+				rotationVector.Y,
+				rotationVector.Z
+			);
+
+			Quaternion slerp = Quaternion::Slerp(
+				Quaternion::Identity(),
+				rotation,
+				interval > 1.0 ? 1.0 : interval
+			);
+
+			Quaternion result = current_orientation * slerp;
+
+			Vector3 new_orientation = Quaternion::ToEuler(result);
+
+			pitch = RadiansToDegrees(new_orientation.X);
+			heading = RadiansToDegrees(new_orientation.Y);
+			bank = RadiansToDegrees(new_orientation.Z);
+		}
+
+		ExtrapolatedPose predicted{};
+		predicted.Lat = new_lat;
+		predicted.Lon = new_lon;
+		predicted.AltitudeTrue = new_alt;
+		predicted.Pitch = pitch;
+		predicted.Bank = bank;
+		predicted.Heading = heading;
+		return predicted;
+	}
+}
@@ -23,6 +23,7 @@
 #include "Utilities.h"
 #include "Config.h"
 #include "SettingsWindow.h"
+#include "LodScheduler.h"
 #include "XPMPMultiplayer.h"
 
 namespace xpilot {
@@ -42,6 +43,10 @@ namespace xpilot {
 	static bool enableTransmitIndicator = false;
 	static bool enableAircraftSounds = true;
 	static int aircraftSoundVolume = 50;
+	static float aircraftUpdateBudget = 2.0f;
+	static int engineSoundVoices = 32;
+	static bool localFrameExtrapolation = true;
+	static int predictionThreads = 0;
 	static float lblCol[4];
 	ImGui::FileBrowser fileBrowser(ImGuiFileBrowserFlags_SelectDirectory);
 
@@ -81,6 +86,10 @@ namespace xpilot {
 		enableTransmitIndicator = xpilot::Config::GetInstance().GetTransmitIndicatorEnabled();
 		enableAircraftSounds = xpilot::Config::GetInstance().GetAircraftSoundsEnabled();
 		aircraftSoundVolume = xpilot::Config::GetInstance().GetAircraftSoundVolume();
+		aircraftUpdateBudget = xpilot::Config::GetInstance().GetAircraftUpdateBudget();
+		engineSoundVoices = xpilot::Config::GetInstance().GetEngineSoundVoices();
+		localFrameExtrapolation = xpilot::Config::GetInstance().GetLocalFrameExtrapolation();
+		predictionThreads = xpilot::Config::GetInstance().GetPredictionThreads();
 		HexToRgb(xpilot::Config::GetInstance().GetAircraftLabelColor(), lblCol);
 	}
 
@@ -293,6 +302,18 @@ namespace xpilot {
 						Save();
 					}
 
+					ImGui::TableNextRow();
+					ImGui::TableSetColumnIndex(0);
+					ImGui::AlignTextToFramePadding();
+					ImGui::Text("Max Aircraft Engine Sounds");
+					ImGui::SameLine();
+					ImGui::ButtonIcon(ICON_FA_QUESTION_CIRCLE, "Only the engines of this many aircraft closest to you are played at once.");
+					ImGui::TableSetColumnIndex(1);
+					if (ImGui::SliderInt("##EngineSoundVoices", &engineSoundVoices, 1, 128)) {
+						xpilot::Config::GetInstance().SetEngineSoundVoices(engineSoundVoices);
+						Save();
+					}
+
 					ImGui::EndTable();
 				}
 			} else {
@@ -433,6 +454,60 @@ namespace xpilot {
 						xpilot::Config::GetInstance().SetDebugModelMatching(debugModelMatching);
 						Save();
 					}
+
+					ImGui::TableNextRow();
+					ImGui::TableSetColumnIndex(0);
+					ImGui::AlignTextToFramePadding();
+					ImGui::Text("Extrapolate in Local Coordinates");
+					ImGui::SameLine();
+					ImGui::ButtonIcon(ICON_FA_QUESTION_CIRCLE, "If enabled, aircraft are placed in X-Plane's local coordinates with simple arithmetic between position updates, instead of asking X-Plane to convert their latitude and longitude every frame.\n\nOnly disable this option if aircraft appear misplaced.");
+					ImGui::TableSetColumnIndex(1);
+					if (ImGui::Checkbox("##LocalFrameExtrapolation", &localFrameExtrapolation)) {
+						xpilot::Config::GetInstance().SetLocalFrameExtrapolation(localFrameExtrapolation);
+						Save();
+					}
+
+					ImGui::TableNextRow();
+					ImGui::TableSetColumnIndex(0);
+					ImGui::AlignTextToFramePadding();
+					ImGui::Text("Distant Aircraft Update Budget");
+					ImGui::SameLine();
+					ImGui::ButtonIcon(ICON_FA_QUESTION_CIRCLE, "Aircraft close to you or in front of you are updated every frame. Aircraft further away are updated less often, and only as long as they fit in this much time per frame.\n\nLower this if many aircraft nearby reduce your frame rate.");
+					ImGui::TableSetColumnIndex(1);
+					if (ImGui::SliderFloat("##AircraftUpdateBudget", &aircraftUpdateBudget, 0.5f, 10.0f, "%.1f ms")) {
+						xpilot::Config::GetInstance().SetAircraftUpdateBudget(aircraftUpdateBudget);
+						Save();
+					}
+
+					ImGui::TableNextRow();
+					ImGui::TableSetColumnIndex(0);
+					ImGui::AlignTextToFramePadding();
+					ImGui::Text("Aircraft Prediction Threads");
+					ImGui::SameLine();
+					ImGui::ButtonIcon(ICON_FA_QUESTION_CIRCLE, "Number of CPU threads used to extrapolate aircraft positions when there is a lot of traffic. Automatic picks a small number based on your CPU.\n\nSet this to 1 to do all of the work on X-Plane's own thread.");
+					ImGui::TableSetColumnIndex(1);
+					if (ImGui::SliderInt("##PredictionThreads", &predictionThreads, 0, 16, predictionThreads == 0 ? "Automatic" : "%d")) {
+						xpilot::Config::GetInstance().SetPredictionThreads(predictionThreads);
+						Save();
+					}
+
+					const auto tierCounts = LodScheduler::GetInstance().GetTierCounts();
+					ImGui::TableNextRow();
+					ImGui::TableSetColumnIndex(0);
+					ImGui::AlignTextToFramePadding();
+					ImGui::Text("Aircraft Updated Every 1/2/4/8 Frames");
+					ImGui::TableSetColumnIndex(1);
+					ImGui::AlignTextToFramePadding();
+					ImGui::Text("%d / %d / %d / %d (%d deferred)", tierCounts[0], tierCounts[1], tierCounts[2], tierCounts[3],
+						LodScheduler::GetInstance().GetDeferredCount());
+
+					ImGui::TableNextRow();
+					ImGui::TableSetColumnIndex(0);
+					ImGui::AlignTextToFramePadding();
+					ImGui::Text("Parked Aircraft Not Updated");
+					ImGui::TableSetColumnIndex(1);
+					ImGui::AlignTextToFramePadding();
+					ImGui::Text("%d", LodScheduler::GetInstance().GetParkedCount());
 				}
 				ImGui::EndTable();
 			} else {
@@ -0,0 +1,317 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "SharedMemoryTransport.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace xpilot {
+	namespace {
+		constexpr uint32_t SEGMENT_MAGIC = 0x78504950; // "xPIP"
+		constexpr uint32_t SEGMENT_VERSION = 1;
+		constexpr uint32_t RING_SIZE = 1024 * 1024;
+		constexpr uint32_t MAX_MESSAGE_SIZE = RING_SIZE - sizeof(uint32_t); // a message and its length prefix fill the ring
+		constexpr int64_t PEER_CHECK_INTERVAL_MS = 1000;
+
+		int64_t SteadyMilliseconds() {
+			return std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+	}
+
+	struct SharedMemoryTransport::RingHeader
+	{
+		alignas(64) std::atomic<uint64_t> Head; // advanced by the reader
+		alignas(64) std::atomic<uint64_t> Tail; // advanced by the writer
+		alignas(64) std::atomic<uint32_t> Doorbell; // futex word, bumped for every message
+		std::atomic<uint32_t> ReaderSleeping;
+	};
+
+	struct SharedMemoryTransport::SegmentHeader
+	{
+		std::atomic<uint32_t> Magic;
+		uint32_t Version;
+		uint32_t RingSize;
+		std::atomic<int32_t> HostPid;
+		std::atomic<int32_t> GuestPid;
+		RingHeader ToHost;
+		RingHeader ToGuest;
+	};
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+		"shared memory atomics must be lock-free to work across processes");
+
+#if defined(__linux__)
+	static void FutexWait(std::atomic<uint32_t>* word, uint32_t expected, int timeoutMs) {
+		timespec ts{};
+		ts.tv_sec = timeoutMs / 1000;
+		ts.tv_nsec = (timeoutMs % 1000) * 1000000L;
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+	}
+
+	static void FutexWake(std::atomic<uint32_t>* word) {
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+	}
+#endif
+
+	SharedMemoryTransport::SharedMemoryTransport(Role role, std::string segmentName) :
+		m_role(role),
+		m_segmentName(std::move(segmentName)) {
+	}
+
+	SharedMemoryTransport::~SharedMemoryTransport() {
+		Close();
+	}
+
+	SharedMemoryTransport::RingHeader& SharedMemoryTransport::OutgoingRing() const {
+		return m_role == Role::Host ? m_segment->ToGuest : m_segment->ToHost;
+	}
+
+	SharedMemoryTransport::RingHeader& SharedMemoryTransport::IncomingRing() const {
+		return m_role == Role::Host ? m_segment->ToHost : m_segment->ToGuest;
+	}
+
+	uint8_t* SharedMemoryTransport::RingData(const RingHeader& ring) const {
+		uint8_t* data = reinterpret_cast<uint8_t*>(m_segment + 1);
+		return &ring == &m_segment->ToHost ? data : data + RING_SIZE;
+	}
+
+	bool SharedMemoryTransport::Open() {
+#if defined(__linux__)
+		if (m_segment) return true;
+
+		const size_t size = sizeof(SegmentHeader) + 2 * RING_SIZE;
+		int fd = -1;
+
+		if (m_role == Role::Host) {
+			shm_unlink(m_segmentName.c_str()); // left behind by a crashed session
+			fd = shm_open(m_segmentName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+			if (fd < 0 || ftruncate(fd, size) != 0) {
+				if (fd >= 0) close(fd);
+				return false;
+			}
+		}
+		else {
+			fd = shm_open(m_segmentName.c_str(), O_RDWR, 0600);
+			struct stat st {};
+			if (fd < 0 || fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < size) {
+				if (fd >= 0) close(fd);
+				return false;
+			}
+		}
+
+		void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if (mapping == MAP_FAILED) {
+			return false;
+		}
+
+		auto segment = static_cast<SegmentHeader*>(mapping);
+
+		if (m_role == Role::Host) {
+			// the mapping starts zeroed, which is a valid initial state for every ring
+			segment->Version = SEGMENT_VERSION;
+			segment->RingSize = RING_SIZE;
+			segment->HostPid.store(getpid());
+			segment->Magic.store(SEGMENT_MAGIC, std::memory_order_release);
+		}
+		else {
+			const int32_t hostPid = segment->HostPid.load();
+			if (segment->Magic.load(std::memory_order_acquire) != SEGMENT_MAGIC || segment->Version != SEGMENT_VERSION
+				|| segment->RingSize != RING_SIZE || hostPid <= 0 || (kill(hostPid, 0) != 0 && errno != EPERM)) {
+				munmap(mapping, size);
+				return false;
+			}
+
+			// skip anything the host queued for a previous client
+			segment->ToGuest.Head.store(segment->ToGuest.Tail.load(std::memory_order_acquire), std::memory_order_release);
+			segment->GuestPid.store(getpid());
+		}
+
+		std::lock_guard<std::mutex> lock(m_sendMutex);
+		m_segment = segment;
+		m_segmentSize = size;
+		m_interrupted = false;
+		m_lastPeerCheck = 0;
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void SharedMemoryTransport::Close() {
+#if defined(__linux__)
+		std::lock_guard<std::mutex> lock(m_sendMutex);
+		if (!m_segment) return;
+
+		if (m_role == Role::Host) {
+			m_segment->Magic.store(0);
+			m_segment->HostPid.store(0);
+			shm_unlink(m_segmentName.c_str());
+		}
+		else {
+			int32_t pid = getpid();
+			m_segment->GuestPid.compare_exchange_strong(pid, 0);
+		}
+
+		munmap(m_segment, m_segmentSize);
+		m_segment = nullptr;
+		m_segmentSize = 0;
+#endif
+	}
+
+	bool SharedMemoryTransport::IsPeerAlive() {
+#if defined(__linux__)
+		const int64_t now = SteadyMilliseconds();
+		if (now - m_lastPeerCheck >= PEER_CHECK_INTERVAL_MS) {
+			const int32_t pid = m_role == Role::Host ? m_segment->GuestPid.load() : m_segment->HostPid.load();
+			m_peerAlive = pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+			m_lastPeerCheck = now;
+		}
+		return m_peerAlive;
+#else
+		return false;
+#endif
+	}
+
+	bool SharedMemoryTransport::Send(const char* data, size_t size) {
+#if defined(__linux__)
+		std::lock_guard<std::mutex> lock(m_sendMutex);
+		if (!m_segment || !IsPeerAlive()) {
+			return false;
+		}
+
+		RingHeader& ring = OutgoingRing();
+		uint8_t* ringData = RingData(ring);
+
+		const uint32_t length = static_cast<uint32_t>(size);
+		const uint64_t required = sizeof(length) + size;
+		const uint64_t tail = ring.Tail.load(std::memory_order_relaxed);
+		const uint64_t head = ring.Head.load(std::memory_order_acquire);
+
+		if (size > MAX_MESSAGE_SIZE || RING_SIZE - (tail - head) < required) {
+			m_droppedMessages++;
+			return true;
+		}
+
+		auto write = [&](uint64_t position, const void* src, size_t count) {
+			const size_t offset = position % RING_SIZE;
+			const size_t first = std::min(count, RING_SIZE - offset);
+			memcpy(ringData + offset, src, first);
+			memcpy(ringData, static_cast<const uint8_t*>(src) + first, count - first);
+		};
+		write(tail, &length, sizeof(length));
+		write(tail + sizeof(length), data, size);
+
+		ring.Tail.store(tail + required, std::memory_order_release);
+		ring.Doorbell.fetch_add(1, std::memory_order_release);
+		if (ring.ReaderSleeping.load()) {
+			FutexWake(&ring.Doorbell);
+		}
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	bool SharedMemoryTransport::Receive(std::vector<char>& message, int timeoutMs) {
+#if defined(__linux__)
+		if (!m_segment) return false;
+
+		RingHeader& ring = IncomingRing();
+		const uint8_t* ringData = RingData(ring);
+		const int64_t deadline = SteadyMilliseconds() + timeoutMs;
+
+		auto read = [&](uint64_t position, void* dst, size_t count) {
+			const size_t offset = position % RING_SIZE;
+			const size_t first = std::min(count, RING_SIZE - offset);
+			memcpy(dst, ringData + offset, first);
+			memcpy(static_cast<uint8_t*>(dst) + first, ringData, count - first);
+		};
+
+		while (!m_interrupted) {
+			const uint64_t head = ring.Head.load(std::memory_order_relaxed);
+			const uint64_t tail = ring.Tail.load(std::memory_order_acquire);
+			if (head != tail) {
+				// the ring is writable by the peer process, so nothing in it is trusted: a length
+				// that doesn't fit what was queued discards the whole backlog
+				const uint64_t queued = tail - head;
+				uint32_t length = 0;
+				if (queued >= sizeof(length) && queued <= RING_SIZE) {
+					read(head, &length, sizeof(length));
+				}
+				if (queued < sizeof(length) || queued > RING_SIZE || length > MAX_MESSAGE_SIZE
+					|| sizeof(length) + uint64_t(length) > queued) {
+					ring.Head.store(tail, std::memory_order_release);
+					m_droppedMessages++;
+					continue;
+				}
+				message.resize(length);
+				read(head + sizeof(length), message.data(), length);
+				ring.Head.store(head + sizeof(length) + length, std::memory_order_release);
+				return true;
+			}
+
+			const int64_t remaining = deadline - SteadyMilliseconds();
+			if (remaining <= 0) {
+				return false;
+			}
+
+			// publish that we're about to sleep, then re-check so a message sent in between
+			// isn't missed; the writer only issues the wake syscall if it sees the flag
+			const uint32_t doorbell = ring.Doorbell.load(std::memory_order_acquire);
+			ring.ReaderSleeping.store(1);
+			if (head == ring.Tail.load(std::memory_order_acquire) && !m_interrupted) {
+				FutexWait(&ring.Doorbell, doorbell, static_cast<int>(remaining));
+			}
+			ring.ReaderSleeping.store(0);
+		}
+		return false;
+#else
+		return false;
+#endif
+	}
+
+	void SharedMemoryTransport::Interrupt() {
+		m_interrupted = true;
+#if defined(__linux__)
+		std::lock_guard<std::mutex> lock(m_sendMutex);
+		if (m_segment) {
+			RingHeader& ring = IncomingRing();
+			ring.Doorbell.fetch_add(1);
+			FutexWake(&ring.Doorbell);
+		}
+#endif
+	}
+}
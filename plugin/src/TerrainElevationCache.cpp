@@ -0,0 +1,169 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "TerrainElevationCache.h"
+#include "Utilities.h"
+
+#include <cmath>
+
+namespace xpilot {
+	namespace {
+		constexpr double CELL_SIZE = 1.0 / 4096.0; // [deg]
+		constexpr int64_t LON_CELLS = 360 * 4096;
+
+		constexpr int MAX_PROBES_PER_FRAME = 32;
+		constexpr int64_t SAMPLE_MAX_AGE = 60 * 1000; // [ms]
+		constexpr int64_t NO_TERRAIN_MAX_AGE = 2 * 1000; // [ms] scenery may still be loading
+		constexpr int64_t EVICT_AGE = 5 * 60 * 1000; // [ms]
+		constexpr int64_t SWEEP_INTERVAL = 10 * 1000; // [ms]
+		constexpr float PUBLISH_INTERVAL = 1.0f;
+
+		uint64_t SampleKey(int64_t latIndex, int64_t lonIndex) {
+			return (static_cast<uint64_t>(latIndex) << 32) | static_cast<uint64_t>(lonIndex);
+		}
+	}
+
+	TerrainElevationCache::TerrainElevationCache() :
+		m_latRef("sim/flightmodel/position/lat_ref", ReadOnly),
+		m_lonRef("sim/flightmodel/position/lon_ref", ReadOnly),
+		m_hitsRef("xpilot/stats/terrain_cache_hits", ReadOnly),
+		m_missesRef("xpilot/stats/terrain_cache_misses", ReadOnly),
+		m_probesRef("xpilot/stats/terrain_cache_probes", ReadOnly),
+		m_deferredRef("xpilot/stats/terrain_cache_deferred", ReadOnly),
+		m_sizeRef("xpilot/stats/terrain_cache_size", ReadOnly) {
+		m_probeBudget = MAX_PROBES_PER_FRAME;
+	}
+
+	const TerrainElevationCache::Sample* TerrainElevationCache::GetSample(int64_t latIndex, int64_t lonIndex, int64_t now, bool& missed) {
+		lonIndex = ((lonIndex % LON_CELLS) + LON_CELLS) % LON_CELLS;
+		const uint64_t key = SampleKey(latIndex, lonIndex);
+
+		auto it = m_samples.find(key);
+		if (it != m_samples.end()) {
+			const Sample& sample = it->second;
+			if (now - sample.ProbedAt < (sample.HitTerrain ? SAMPLE_MAX_AGE : NO_TERRAIN_MAX_AGE)) {
+				return &sample;
+			}
+		}
+
+		missed = true;
+		if (m_probeBudget <= 0) {
+			m_deferred++;
+			return it != m_samples.end() ? &it->second : nullptr;
+		}
+
+		m_probeBudget--;
+		m_probes++;
+
+		const double lat = latIndex * CELL_SIZE - 90.0;
+		const double lon = lonIndex * CELL_SIZE - 180.0;
+		const std::optional<double> elevation = m_probe.GetTerrainElevation(lat, lon);
+
+		Sample& sample = m_samples[key];
+		sample.Elevation = elevation.value_or(0.0);
+		sample.ProbedAt = now;
+		sample.HitTerrain = elevation.has_value();
+		return &sample;
+	}
+
+	std::optional<double> TerrainElevationCache::GetTerrainElevation(double degLat, double degLon) {
+		const int64_t now = PrecisionTimestamp();
+
+		const double latCell = (degLat + 90.0) / CELL_SIZE;
+		const double lonCell = (degLon + 180.0) / CELL_SIZE;
+		const int64_t latIndex = static_cast<int64_t>(std::floor(latCell));
+		const int64_t lonIndex = static_cast<int64_t>(std::floor(lonCell));
+		const double fy = latCell - latIndex;
+		const double fx = lonCell - lonIndex;
+
+		bool missed = false;
+		const Sample* corners[4] = {
+			GetSample(latIndex, lonIndex, now, missed),
+			GetSample(latIndex, lonIndex + 1, now, missed),
+			GetSample(latIndex + 1, lonIndex, now, missed),
+			GetSample(latIndex + 1, lonIndex + 1, now, missed)
+		};
+		const double weights[4] = {
+			(1.0 - fx) * (1.0 - fy),
+			fx * (1.0 - fy),
+			(1.0 - fx) * fy,
+			fx * fy
+		};
+
+		// only lookups served entirely from fresh samples count as hits
+		if (missed) {
+			m_misses++;
+		} else {
+			m_hits++;
+		}
+
+		// corners that couldn't be probed this frame, or where the probe found no scenery, are
+		// left out and the rest reweighted
+		double elevation = 0.0;
+		double totalWeight = 0.0;
+		const Sample* firstHit = nullptr;
+		for (int i = 0; i < 4; i++) {
+			if (corners[i] && corners[i]->HitTerrain) {
+				elevation += corners[i]->Elevation * weights[i];
+				totalWeight += weights[i];
+				if (!firstHit) firstHit = corners[i];
+			}
+		}
+
+		if (!firstHit) return {};
+		if (totalWeight <= 0.0) {
+			// the only corners with terrain have zero weight, take the first of them
+			return firstHit->Elevation;
+		}
+		return elevation / totalWeight;
+	}
+
+	void TerrainElevationCache::Update(float elapsedSinceLastCall) {
+		m_probeBudget = MAX_PROBES_PER_FRAME;
+
+		const float latRef = m_latRef;
+		const float lonRef = m_lonRef;
+		if (latRef != m_lastLatRef || lonRef != m_lastLonRef) {
+			m_samples.clear();
+			m_lastLatRef = latRef;
+			m_lastLonRef = lonRef;
+		}
+
+		const int64_t now = PrecisionTimestamp();
+		if (now - m_lastSweep >= SWEEP_INTERVAL) {
+			for (auto it = m_samples.begin(); it != m_samples.end();) {
+				if (now - it->second.ProbedAt > EVICT_AGE) {
+					it = m_samples.erase(it);
+				} else {
+					++it;
+				}
+			}
+			m_lastSweep = now;
+		}
+
+		m_publishTimer += elapsedSinceLastCall;
+		if (m_publishTimer < PUBLISH_INTERVAL) return;
+		m_publishTimer = 0.0f;
+
+		m_hitsRef = static_cast<int>(m_hits);
+		m_missesRef = static_cast<int>(m_misses);
+		m_probesRef = static_cast<int>(m_probes);
+		m_deferredRef = static_cast<int>(m_deferred);
+		m_sizeRef = static_cast<int>(m_samples.size());
+	}
+}
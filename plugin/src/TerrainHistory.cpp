@@ -0,0 +1,69 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "TerrainHistory.h"
+#include "GeoCalc.hpp"
+
+#include <cmath>
+
+namespace xpilot {
+	bool TerrainHistory::Record(double timestamp, double lat, double lon, std::optional<double> altitudeAgl, double localElevation) {
+		// samples are in timestamp order, so the outdated ones are all at the front
+		while (!m_samples.IsEmpty()
+			&& m_samples.Front().Timestamp < (timestamp - TERRAIN_ELEVATION_DATA_USABLE_AGE + 250)) {
+			m_samples.PopFront();
+		}
+
+		if (altitudeAgl.has_value() && (altitudeAgl.value() <= MAX_USABLE_ALTITUDE_AGL)) {
+			TerrainElevationData data{};
+			data.Timestamp = timestamp;
+			data.Location.Latitude = lat;
+			data.Location.Longitude = lon;
+			data.LocalValue = localElevation;
+			m_samples.Push(data);
+		} else {
+			return false;
+		}
+
+		if (m_samples.Size() < 2) {
+			return false;
+		}
+
+		const auto& startSample = m_samples.Front();
+		const auto& endSample = m_samples.Back();
+		if ((endSample.Timestamp - startSample.Timestamp) < TERRAIN_ELEVATION_DATA_USABLE_AGE) {
+			return false;
+		}
+
+		double distance = DegreesToFeet(GreatCircleDistance(
+			startSample.Location.Longitude, startSample.Location.Latitude,
+			endSample.Location.Longitude, endSample.Location.Latitude));
+		double remoteElevationDelta = std::abs(startSample.RemoteValue - endSample.RemoteValue);
+		double localElevationDelta = std::abs(startSample.LocalValue - endSample.LocalValue);
+		double remoteSlope = RadiansToDegrees(std::atan(remoteElevationDelta / distance));
+		if (remoteSlope > TERRAIN_ELEVATION_MAX_SLOPE) {
+			return false;
+		}
+		double localSlope = RadiansToDegrees(std::atan(localElevationDelta / distance));
+		if (localSlope > TERRAIN_ELEVATION_MAX_SLOPE) {
+			return false;
+		}
+
+		return true;
+	}
+}
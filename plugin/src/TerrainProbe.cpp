@@ -28,7 +28,7 @@ namespace xpilot {
 		XPLMDestroyProbe(m_probeRef);
 	}
 
-	double TerrainProbe::GetTerrainElevation(double degLat, double degLon) const {
+	std::optional<double> TerrainProbe::GetTerrainElevation(double degLat, double degLon) const {
 		double x, y, z, foo, alt;
 		XPLMProbeInfo_t probeinfo;
 		probeinfo.structSize = sizeof(XPLMProbeInfo_t);
@@ -39,6 +39,6 @@ namespace xpilot {
 			return alt * 3.28084;
 		}
 
-		return 0;
+		return {};
 	}
 }
\ No newline at end of file
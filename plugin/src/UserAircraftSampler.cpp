@@ -0,0 +1,98 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "UserAircraftSampler.h"
+
+#include <algorithm>
+
+namespace xpilot {
+	UserAircraftSampler::UserAircraftSampler() :
+		m_latitude("sim/flightmodel/position/latitude", ReadOnly),
+		m_longitude("sim/flightmodel/position/longitude", ReadOnly),
+		m_elevation("sim/flightmodel/position/elevation", ReadOnly),
+		m_altitudeAgl("sim/flightmodel/position/y_agl", ReadOnly),
+		m_pressureAltitude("sim/flightmodel2/position/pressure_altitude", ReadOnly),
+		m_barometerSeaLevel("sim/weather/barometer_sealevel_inhg", ReadOnly),
+		m_pitch("sim/flightmodel/position/theta", ReadOnly),
+		m_heading("sim/flightmodel/position/psi", ReadOnly),
+		m_bank("sim/flightmodel/position/phi", ReadOnly),
+		m_localVx("sim/flightmodel/position/local_vx", ReadOnly),
+		m_localVy("sim/flightmodel/position/local_vy", ReadOnly),
+		m_localVz("sim/flightmodel/position/local_vz", ReadOnly),
+		m_pitchRate("sim/flightmodel/position/Qrad", ReadOnly),
+		m_headingRate("sim/flightmodel/position/Rrad", ReadOnly),
+		m_bankRate("sim/flightmodel/position/Prad", ReadOnly),
+		m_groundSpeed("sim/flightmodel/position/groundspeed", ReadOnly),
+		m_tireSteerAngle("sim/flightmodel2/gear/tire_steer_actual_deg", ReadOnly),
+		m_engineCount("sim/aircraft/engine/acf_num_engines", ReadOnly),
+		m_engineRunning("sim/flightmodel/engine/ENGN_running", ReadOnly),
+		m_enginePropMode("sim/flightmodel/engine/ENGN_propmode", ReadOnly),
+		m_onGround("sim/flightmodel/failures/onground_any", ReadOnly),
+		m_gearHandle("sim/cockpit/switches/gear_handle_status", ReadOnly),
+		m_flapRatio("sim/flightmodel/controls/flaprat", ReadOnly),
+		m_speedbrakeRatio("sim/cockpit2/controls/speedbrake_ratio", ReadOnly),
+		m_beaconLights("sim/cockpit2/switches/beacon_on", ReadOnly),
+		m_landingLights("sim/cockpit2/switches/landing_lights_on", ReadOnly),
+		m_taxiLights("sim/cockpit2/switches/taxi_light_on", ReadOnly),
+		m_navLights("sim/cockpit2/switches/navigation_lights_on", ReadOnly),
+		m_strobeLights("sim/cockpit2/switches/strobe_lights_on", ReadOnly) {
+	}
+
+	void UserAircraftSampler::Sample(UserAircraftStateDto& state) const {
+		state.sampledAt = getSteadyMicroseconds();
+		state.latitude = m_latitude;
+		state.longitude = m_longitude;
+		state.elevation = m_elevation;
+		state.altitudeAgl = m_altitudeAgl;
+		state.pressureAltitude = m_pressureAltitude;
+		state.barometerSeaLevel = m_barometerSeaLevel;
+		state.pitch = m_pitch;
+		state.heading = m_heading;
+		state.bank = m_bank;
+		state.localVx = m_localVx;
+		state.localVy = m_localVy;
+		state.localVz = m_localVz;
+		state.pitchRate = m_pitchRate;
+		state.headingRate = m_headingRate;
+		state.bankRate = m_bankRate;
+		state.groundSpeed = m_groundSpeed;
+		state.noseWheelAngle = m_tireSteerAngle[0];
+		state.engineCount = m_engineCount;
+
+		const std::vector<int> running = m_engineRunning;
+		const std::vector<int> propMode = m_enginePropMode;
+		state.enginesRunning = 0;
+		state.enginesReversing = 0;
+		for (size_t i = 0; i < std::min<size_t>(4, running.size()); i++) {
+			if (running[i]) state.enginesRunning |= 1 << i;
+		}
+		for (size_t i = 0; i < std::min<size_t>(4, propMode.size()); i++) {
+			if (propMode[i] == 3) state.enginesReversing |= 1 << i; // 3 = reverse
+		}
+
+		state.onGround = m_onGround;
+		state.gearDown = m_gearHandle;
+		state.flapRatio = m_flapRatio;
+		state.speedbrakeRatio = m_speedbrakeRatio;
+		state.beaconLightsOn = m_beaconLights;
+		state.landingLightsOn = m_landingLights;
+		state.taxiLightsOn = m_taxiLights;
+		state.navLightsOn = m_navLights;
+		state.strobeLightsOn = m_strobeLights;
+	}
+}
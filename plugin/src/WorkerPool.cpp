@@ -0,0 +1,116 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+namespace xpilot {
+	WorkerPool::~WorkerPool() {
+		Stop();
+	}
+
+	void WorkerPool::SetThreadCount(size_t threads) {
+		threads = threads > 0 ? threads - 1 : 0;
+		if (threads == m_threads.size()) return;
+
+		Stop();
+		m_stopping = false;
+		for (size_t i = 0; i < threads; i++) {
+			m_threads.emplace_back(&WorkerPool::Work, this);
+		}
+	}
+
+	void WorkerPool::Run(size_t chunks, const std::function<void(size_t)>& job) {
+		if (m_threads.empty() || chunks <= 1) {
+			for (size_t chunk = 0; chunk < chunks; chunk++) {
+				job(chunk);
+			}
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_job = &job;
+		m_chunks = chunks;
+		m_nextChunk = 0;
+		m_pending = chunks;
+		m_wake.notify_all();
+
+		// the calling thread takes its share instead of just waiting
+		while (m_nextChunk < m_chunks) {
+			const size_t chunk = m_nextChunk++;
+			lock.unlock();
+			job(chunk);
+			lock.lock();
+			m_pending--;
+		}
+
+		m_done.wait(lock, [this] { return m_pending == 0; });
+		m_job = nullptr;
+		m_chunks = 0;
+		m_nextChunk = 0;
+	}
+
+	void WorkerPool::RunRanges(size_t count, size_t granularity, size_t minCount, const std::function<void(size_t, size_t)>& job) {
+		if (count == 0) return;
+
+		minCount = minCount > 0 ? minCount : 1;
+		const size_t chunks = (std::min)(GetThreadCount(), (count + minCount - 1) / minCount);
+		const size_t perChunk = (count + chunks - 1) / chunks;
+		const size_t chunkCount = (perChunk + granularity - 1) / granularity * granularity;
+
+		Run(chunks, [&](size_t chunk) {
+			const size_t begin = chunk * chunkCount;
+			const size_t end = (std::min)(begin + chunkCount, count);
+			if (begin < end) {
+				job(begin, end);
+			}
+		});
+	}
+
+	void WorkerPool::Stop() {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		m_wake.notify_all();
+
+		for (std::thread& thread : m_threads) {
+			thread.join();
+		}
+		m_threads.clear();
+	}
+
+	void WorkerPool::Work() {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (true) {
+			m_wake.wait(lock, [this] { return m_stopping || m_nextChunk < m_chunks; });
+			if (m_stopping) return;
+
+			const size_t chunk = m_nextChunk++;
+			const std::function<void(size_t)>* job = m_job;
+			lock.unlock();
+			(*job)(chunk);
+			lock.lock();
+
+			if (--m_pending == 0) {
+				m_done.notify_one();
+			}
+		}
+	}
+}
@@ -21,6 +21,8 @@
 #include "Config.h"
 #include "Utilities.h"
 #include "AircraftManager.h"
+#include "AircraftStateQueue.h"
+#include "BulkDataSnapshot.h"
 #include "NetworkAircraft.h"
 #include "FrameRateMonitor.h"
 #include "NearbyATCWindow.h"
@@ -30,6 +32,13 @@
 #include "XPMPMultiplayer.h"
 
 namespace xpilot {
+	namespace {
+		// per frame slices of the aircraft work queued by the client, see InvokeQueuedCallbacks
+		constexpr auto POSITION_SLICE = std::chrono::microseconds(1500);
+		constexpr auto CONFIG_SLICE = std::chrono::microseconds(500);
+		constexpr auto NEW_AIRCRAFT_SLICE = std::chrono::microseconds(2000);
+	}
+
 	XPilot::XPilot() :
 		m_xplaneAtisEnabled("sim/atc/atis_enabled", ReadWrite),
 		m_pttPressed("xpilot/ptt", ReadWrite),
@@ -54,37 +63,7 @@ namespace xpilot {
 		m_audioSelectionCom2("sim/cockpit2/radios/actuators/audio_selection_com2", ReadWrite),
 		m_transponderCode("sim/cockpit/radios/transponder_code", ReadWrite),
 		m_avionicsPower("sim/cockpit2/switches/avionics_power_on", ReadOnly) {
-		m_bulkDataQuick = XPLMRegisterDataAccessor("xpilot/bulk/quick",
-			xplmType_Data,
-			false,
-			NULL,
-			NULL,
-			NULL,
-			NULL,
-			NULL, NULL,
-			NULL, NULL,
-			NULL, NULL,
-			GetBulkData,
-			NULL,
-			(void*)xpilot::dataRefs::DR_BULK_QUICK,
-			(void*)xpilot::dataRefs::DR_BULK_QUICK
-		);
-
-		m_bulkDataExpensive = XPLMRegisterDataAccessor("xpilot/bulk/expensive",
-			xplmType_Data,
-			false,
-			NULL,
-			NULL,
-			NULL,
-			NULL,
-			NULL, NULL,
-			NULL, NULL,
-			NULL, NULL,
-			GetBulkData,
-			NULL,
-			(void*)xpilot::dataRefs::DR_BULK_EXPENSIVE,
-			(void*)xpilot::dataRefs::DR_BULK_EXPENSIVE
-		);
+		m_bulkDataSnapshot = std::make_unique<BulkDataSnapshot>();
 
 		int left, top, right, bottom, screenTop, screenRight;
 		XPLMGetScreenBoundsGlobal(nullptr, &screenTop, &screenRight, nullptr);
@@ -98,14 +77,18 @@ namespace xpilot {
 		m_settingsWindow = std::make_unique<SettingsWindow>();
 		m_frameRateMonitor = std::make_unique<FrameRateMonitor>(this);
 		m_aircraftManager = std::make_unique<AircraftManager>(this);
+		m_aircraftStates = std::make_unique<AircraftStateQueue>();
+		m_ipcStats = std::make_unique<IpcStats>();
+		m_userAircraftSampler = std::make_unique<UserAircraftSampler>();
 		m_pluginVersion = PLUGIN_VERSION;
+		m_xplaneThread = std::this_thread::get_id();
+
+		RegisterPacketHandlers();
 
 		XPLMRegisterFlightLoopCallback(DeferredStartup, -1.0f, this);
 	}
 
 	XPilot::~XPilot() {
-		XPLMUnregisterDataAccessor(m_bulkDataQuick);
-		XPLMUnregisterDataAccessor(m_bulkDataExpensive);
 		XPLMUnregisterFlightLoopCallback(DeferredStartup, this);
 		XPLMUnregisterFlightLoopCallback(MainFlightLoop, this);
 	}
@@ -137,6 +120,18 @@ namespace xpilot {
 
 		m_keepSocketAlive = true;
 		m_socketThread = std::make_unique<std::thread>(&XPilot::SocketWorker, this);
+
+		// a client on this machine will prefer the shared memory rings when they're available
+		if (!Config::GetInstance().GetUseTcpSocket()) {
+			m_sharedMemory = std::make_unique<SharedMemoryTransport>(SharedMemoryTransport::Role::Host);
+			if (m_sharedMemory->Open()) {
+				m_sharedMemoryThread = std::make_unique<std::thread>(&XPilot::SharedMemoryWorker, this);
+				LOG_MSG(logMSG, "Shared memory transport available");
+			}
+			else {
+				m_sharedMemory.reset();
+			}
+		}
 	}
 
 	void XPilot::Shutdown() {
@@ -152,6 +147,14 @@ namespace xpilot {
 		if (m_socketThread) {
 			m_socketThread->join();
 		}
+
+		if (m_sharedMemory) {
+			m_sharedMemory->Interrupt();
+			if (m_sharedMemoryThread) {
+				m_sharedMemoryThread->join();
+			}
+			m_sharedMemory->Close();
+		}
 	}
 
 	int CBIntPrefsFunc(const char*, [[maybe_unused]] const char* item, int defaultVal) {
@@ -211,6 +214,11 @@ namespace xpilot {
 		auto* instance = static_cast<XPilot*>(ref);
 		if (instance) {
 			instance->InvokeQueuedCallbacks();
+			if (instance->m_streamUserAircraftState) {
+				instance->m_userAircraftSampler->Sample(instance->m_userAircraftState);
+				instance->SendDto(instance->m_userAircraftState);
+			}
+			instance->m_ipcStats->Update(inElapsedSinceLastCall, instance->m_sharedMemory ? instance->m_sharedMemory->GetDroppedMessages() : 0);
 			instance->m_aiControlled = XPMPHasControlOfAIAircraft();
 			instance->m_aircraftCount = XPMPCountPlanes();
 			UpdateMenuItems();
@@ -227,32 +235,82 @@ namespace xpilot {
 			err = nng_recv(_socket, &buffer, &bufferLen, NNG_FLAG_ALLOC);
 
 			if (err == 0) {
-				BaseDto dto;
-				auto obj = msgpack::unpack(reinterpret_cast<const char*>(buffer), bufferLen);
-
-				try {
-					obj.get().convert(dto);
-					ProcessPacket(dto);
-				}
-				catch (const msgpack::type_error& e) {}
-
+				HandleMessage(buffer, bufferLen);
 				nng_free(buffer, bufferLen);
 			}
 		}
 	}
 
-	void XPilot::ProcessPacket(const BaseDto& packet) {
-		if (packet.type == dto::PLUGIN_VER) {
-			PluginVersionDto dto{ PLUGIN_VERSION };
-			SendDto(dto);
+	void XPilot::SharedMemoryWorker() {
+		std::vector<char> buffer;
+		while (m_keepSocketAlive) {
+			if (m_sharedMemory->Receive(buffer, 250)) {
+				HandleMessage(buffer.data(), buffer.size());
+			}
+		}
+	}
+
+	void XPilot::HandleMessage(const char* data, size_t size) {
+		std::lock_guard<std::mutex> lock(m_receiveMutex);
+
+		try {
+			auto obj = msgpack::unpack(data, size);
+			msgpack::object payload;
+			MessageId id = decodeDto(obj.get(), payload, &m_receivedStamp);
+			m_ipcStats->RecordReceived(id, m_receivedStamp, getSteadyMicroseconds());
+			ProcessPacket(id, payload);
 		}
-		if (packet.type == dto::VALIDATE_CSL) {
+		catch (const msgpack::type_error& e) {}
+	}
+
+	static FastPositionUpdate ToFastPositionUpdate(const FastPositionUpdateDto& dto, const MessageStamp& stamp) {
+		FastPositionUpdate update{};
+		update.Handle = dto.handle;
+		update.Callsign = dto.callsign;
+		update.Speed = dto.speed;
+		update.SentAt = stamp.sentAt;
+
+		update.VisualState.Lat = dto.latitude;
+		update.VisualState.Lon = dto.longitude;
+		update.VisualState.AltitudeTrue = dto.altitudeTrue;
+		update.VisualState.AltitudeAgl = dto.altitudeAgl;
+		update.VisualState.Pitch = dto.pitch;
+		update.VisualState.Bank = dto.bank;
+		update.VisualState.Heading = dto.heading;
+		update.VisualState.NoseWheelAngle = dto.noseWheelAngle;
+
+		update.PositionalVelocities.X = dto.vx; // vel lon
+		update.PositionalVelocities.Y = dto.vy; // vel alt
+		update.PositionalVelocities.Z = dto.vz; // vel lat
+
+		update.RotationalVelocities.X = dto.vp * -1; // vel pitch
+		update.RotationalVelocities.Y = dto.vh; // vel heading
+		update.RotationalVelocities.Z = dto.vb * -1; // vel bank
+
+		return update;
+	}
+
+	void XPilot::RegisterPacketHandlers() {
+		m_packetHandlers[static_cast<size_t>(MessageId::PluginVersion)] = [this](const msgpack::object& packet) {
+			PluginVersionDto request{};
+			packet.convert(request);
+
+			// only switch to compact message ids if the client has told us it understands them
+			m_compactMessages = request.protocol >= PROTOCOL_VERSION_HANDLES;
+			m_streamUserAircraftState = request.protocol >= PROTOCOL_VERSION_USER_STATE;
+
+			PluginVersionDto dto{ PLUGIN_VERSION, PROTOCOL_VERSION };
+			SendDto(dto);
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::ValidateCsl)] = [this](const msgpack::object& packet) {
 			ValidateCslDto dto{ XPMPGetNumberOfInstalledModels() > 0 };
 			SendDto(dto);
-		}
-		if (packet.type == dto::ADD_AIRCRAFT) {
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::AddAircraft)] = [this](const msgpack::object& packet) {
 			AddAircraftDto dto;
-			packet.dto.convert(dto);
+			packet.convert(dto);
 
 			AircraftVisualState visualState{};
 			visualState.Lat = dto.latitude;
@@ -263,75 +321,124 @@ namespace xpilot {
 			visualState.Bank = dto.bank;
 
 			if (!dto.callsign.empty() && !dto.typeCode.empty()) {
+				m_aircraftStates->Reset(dto.handle);
 				QueueCallback([=] {
-					m_aircraftManager->HandleAddPlane(dto.callsign, visualState, dto.airline, dto.typeCode);
+					m_aircraftManager->HandleAddPlane(dto.callsign, dto.handle, visualState, dto.airline, dto.typeCode);
 				});
 			}
-		}
-		if (packet.type == dto::HEARTBEAT) {
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::Heartbeat)] = [this](const msgpack::object& packet) {
 			HeartbeatDto dto;
-			packet.dto.convert(dto);
+			packet.convert(dto);
+
+			if (AircraftStateQueue::IsValidHandle(dto.handle)) {
+				m_aircraftStates->PostHeartbeat(dto.handle);
+				return;
+			}
 
 			QueueCallback([=] {
-				m_aircraftManager->HandleHeartbeat(dto.callsign);
+				m_aircraftManager->HandleHeartbeat(dto.handle, dto.callsign);
 			});
-		}
-		if (packet.type == dto::FAST_POSITION_UPDATE) {
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::FastPositionUpdate)] = [this](const msgpack::object& packet) {
 			FastPositionUpdateDto dto;
-			packet.dto.convert(dto);
+			packet.convert(dto);
 
-			AircraftVisualState visualState{};
-			visualState.Lat = dto.latitude;
-			visualState.Lon = dto.longitude;
-			visualState.AltitudeTrue = dto.altitudeTrue;
-			visualState.AltitudeAgl = dto.altitudeAgl;
-			visualState.Pitch = dto.pitch;
-			visualState.Bank = dto.bank;
-			visualState.Heading = dto.heading;
-			visualState.NoseWheelAngle = dto.noseWheelAngle;
+			if (AircraftStateQueue::IsValidHandle(dto.handle)) {
+				FastPositionUpdate update = ToFastPositionUpdate(dto, m_receivedStamp);
+				m_aircraftStates->PostPosition(update.Handle, update.VisualState,
+					update.PositionalVelocities, update.RotationalVelocities, update.Speed, update.SentAt);
+			}
+			else if (!dto.callsign.empty()) {
+				FastPositionUpdate update = ToFastPositionUpdate(dto, m_receivedStamp);
+				QueueCallback([=] {
+					m_aircraftManager->HandleFastPositionUpdate(update.Handle, update.Callsign, update.VisualState,
+						update.PositionalVelocities, update.RotationalVelocities, update.Speed);
+					m_ipcStats->RecordPositionApplied(update.SentAt, getSteadyMicroseconds());
+				});
+			}
+		};
 
-			Vector3 positionalVector{};
-			positionalVector.X = dto.vx; // vel lon
-			positionalVector.Y = dto.vy; // vel alt
-			positionalVector.Z = dto.vz; // vel lat
+		m_packetHandlers[static_cast<size_t>(MessageId::PositionFrame)] = [this](const msgpack::object& packet) {
+			// decode straight from the msgpack array into one contiguous frame,
+			// so the whole tick is applied by a single queued callback
+			if (packet.type != msgpack::type::ARRAY || packet.via.array.size < 1)
+				return;
+			const msgpack::object& updates = packet.via.array.ptr[0];
+			if (updates.type != msgpack::type::ARRAY || updates.via.array.size == 0)
+				return;
 
-			Vector3 rotationalVelocity{};
-			rotationalVelocity.X = dto.vp * -1; // vel pitch
-			rotationalVelocity.Y = dto.vh; // vel heading
-			rotationalVelocity.Z = dto.vb * -1; // vel bank
+			// updates addressed by handle go straight to their aircraft's slot, only
+			// callsign-addressed ones still need a queued callback
+			std::shared_ptr<PositionFrame> frame;
+
+			FastPositionUpdateDto dto;
+			for (uint32_t i = 0; i < updates.via.array.size; i++) {
+				updates.via.array.ptr[i].convert(dto);
+				if (AircraftStateQueue::IsValidHandle(dto.handle)) {
+					FastPositionUpdate update = ToFastPositionUpdate(dto, m_receivedStamp);
+					m_aircraftStates->PostPosition(update.Handle, update.VisualState,
+						update.PositionalVelocities, update.RotationalVelocities, update.Speed, update.SentAt);
+				}
+				else if (!dto.callsign.empty()) {
+					if (!frame) {
+						frame = std::make_shared<PositionFrame>();
+						frame->reserve(updates.via.array.size);
+					}
+					frame->push_back(ToFastPositionUpdate(dto, m_receivedStamp));
+				}
+			}
 
-			if (!dto.callsign.empty()) {
+			if (frame) {
 				QueueCallback([=] {
-					m_aircraftManager->HandleFastPositionUpdate(dto.callsign,
-						visualState, positionalVector, rotationalVelocity, dto.speed);
+					m_aircraftManager->HandlePositionFrame(*frame);
+					const int64_t appliedAt = getSteadyMicroseconds();
+					for (const auto& update : *frame) {
+						m_ipcStats->RecordPositionApplied(update.SentAt, appliedAt);
+					}
 				});
 			}
-		}
-		if (packet.type == dto::DELETE_AIRCRAFT) {
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::DeleteAircraft)] = [this](const msgpack::object& packet) {
 			DeleteAircraftDto dto;
-			packet.dto.convert(dto);
+			packet.convert(dto);
 
-			if (!dto.callsign.empty()) {
+			if (dto.handle > 0 || !dto.callsign.empty()) {
+				m_aircraftStates->Reset(dto.handle);
 				QueueCallback([=] {
-					m_aircraftManager->HandleRemovePlane(dto.callsign);
+					m_aircraftManager->HandleRemovePlane(dto.handle, dto.callsign);
 				});
 			}
-		}
-		if (packet.type == dto::DELETE_ALL_AIRCRAFT) {
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::DeleteAllAircraft)] = [this](const msgpack::object& packet) {
+			m_aircraftStates->ResetAll();
 			QueueCallback([=] {
 				m_aircraftManager->RemoveAllPlanes();
 			});
-		}
-		if (packet.type == dto::AIRCRAFT_CONFIG) {
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::AircraftConfig)] = [this](const msgpack::object& packet) {
 			AircraftConfigDto dto;
-			packet.dto.convert(dto);
+			packet.convert(dto);
+
+			AircraftConfig config = AircraftConfig::FromDto(dto);
+			if (AircraftStateQueue::IsValidHandle(dto.handle)) {
+				m_aircraftStates->PostConfig(dto.handle, config);
+				return;
+			}
+
 			QueueCallback([=] {
-				m_aircraftManager->HandleAircraftConfig(dto.callsign, dto);
+				m_aircraftManager->HandleAircraftConfig(dto.handle, dto.callsign, config);
 			});
-		}
-		if (packet.type == dto::NOTIFICATION_POSTED) {
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::NotificationPosted)] = [this](const msgpack::object& packet) {
 			NotificationPostedDto dto;
-			packet.dto.convert(dto);
+			packet.convert(dto);
 
 			long color = dto.color;
 			int red = ((color >> 16) & 0xff);
@@ -339,53 +446,59 @@ namespace xpilot {
 			int blue = ((color) & 0xff);
 
 			NotificationPosted(dto.message.c_str(), red, green, blue);
-		}
-		if (packet.type == dto::RADIO_MESSAGE_SENT) {
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::RadioMessageSent)] = [this](const msgpack::object& packet) {
 			RadioMessageSentDto dto;
-			packet.dto.convert(dto);
+			packet.convert(dto);
 
 			std::string msg = dto.message.c_str();
 			NotificationPosted(msg, 0, 255, 255);
-		}
-		if (packet.type == dto::RADIO_MESSAGE_RECEIVED) {
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::RadioMessageReceived)] = [this](const msgpack::object& packet) {
 			RadioMessageReceivedDto dto;
-			packet.dto.convert(dto);
+			packet.convert(dto);
 
 			double r = dto.isDirect ? 255 : 192;
 			double g = dto.isDirect ? 255 : 192;
 			double b = dto.isDirect ? 255 : 192;
 			std::string msg = string_format("%s: %s", dto.from.c_str(), dto.message.c_str());
 			NotificationPosted(msg, r, g, b);
-		}
-		if (packet.type == dto::PRIVATE_MESSAGE_SENT) {
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::PrivateMessageSent)] = [this](const msgpack::object& packet) {
 			PrivateMessageSentDto dto;
-			packet.dto.convert(dto);
+			packet.convert(dto);
 
 			std::string msg = dto.message;
 			std::string to = dto.to;
 			AddPrivateMessage(to, msg, ConsoleTabType::Sent);
 			AddNotificationPanelMessage(string_format("%s [pvt]: %s", m_networkCallsign.value().c_str(), msg.c_str()), 0, 255, 255);
-		}
-		if (packet.type == dto::PRIVATE_MESSAGE_RECEIVED) {
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::PrivateMessageReceived)] = [this](const msgpack::object& packet) {
 			PrivateMessageReceivedDto dto;
-			packet.dto.convert(dto);
+			packet.convert(dto);
 
 			std::string msg = dto.message;
 			std::string from = dto.from;
 			AddPrivateMessage(from, msg, ConsoleTabType::Received);
 			AddNotificationPanelMessage(string_format("%s [pvt]: %s", from.c_str(), msg.c_str()), 255, 255, 255);
-		}
-		if (packet.type == dto::NEARBY_ATC) {
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::NearbyAtc)] = [this](const msgpack::object& packet) {
 			NearbyAtcDto dto;
-			packet.dto.convert(dto);
+			packet.convert(dto);
 
 			QueueCallback([=] {
 				m_nearbyAtcWindow->UpdateList(dto);
 			});
-		}
-		if (packet.type == dto::CONNECTED) {
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::Connected)] = [this](const msgpack::object& packet) {
 			ConnectedDto dto;
-			packet.dto.convert(dto);
+			packet.convert(dto);
 
 			std::string callsign = dto.callsign;
 			std::string selcal = dto.selcal;
@@ -401,8 +514,9 @@ namespace xpilot {
 				m_com1StationCallsign.setValue("");
 				m_com2StationCallsign.setValue("");
 			});
-		}
-		if (packet.type == dto::DISCONNECTED) {
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::Disconnected)] = [this](const msgpack::object& packet) {
 			QueueCallback([=] {
 				m_aircraftManager->RemoveAllPlanes();
 				m_frameRateMonitor->StopMonitoring();
@@ -415,10 +529,11 @@ namespace xpilot {
 				m_com1StationCallsign.setValue("");
 				m_com2StationCallsign.setValue("");
 			});
-		}
-		if (packet.type == dto::STATION_CALLSIGN) {
+		};
+
+		m_packetHandlers[static_cast<size_t>(MessageId::StationCallsign)] = [this](const msgpack::object& packet) {
 			ComStationCallsign dto;
-			packet.dto.convert(dto);
+			packet.convert(dto);
 
 			std::string callsign = dto.callsign;
 			int comStack = dto.com;
@@ -433,6 +548,13 @@ namespace xpilot {
 					break;
 				}
 			});
+		};
+	}
+
+	void XPilot::ProcessPacket(MessageId id, const msgpack::object& packet) {
+		const auto& handler = m_packetHandlers[static_cast<size_t>(id)];
+		if (handler) {
+			handler(packet);
 		}
 	}
 
@@ -573,22 +695,51 @@ namespace xpilot {
 		m_aircraftManager->RemoveAllPlanes();
 	}
 
-	void XPilot::QueueCallback(const std::function<void()>& cb) {
-		std::lock_guard<std::mutex> lck(m_mutex);
-		m_queuedCallbacks.push_back(cb);
+	void XPilot::QueueCallback(std::function<void()> cb) {
+		if (std::this_thread::get_id() == m_xplaneThread) {
+			m_deferredCallbacks.push_back(std::move(cb));
+			return;
+		}
+
+		// the flight loop drains the queue every frame, so it can only fill up while X-Plane is
+		// stalled; wait for room rather than dropping an add or delete
+		while (!m_socketCallbacks.Push(std::move(cb)) && m_keepSocketAlive) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
 	}
 
 	void XPilot::InvokeQueuedCallbacks() {
-		std::deque<std::function<void()>> temp;
-		{
-			std::lock_guard<std::mutex> lck(m_mutex);
-			std::swap(temp, m_queuedCallbacks);
+		std::deque<std::function<void()>> deferred;
+		std::swap(deferred, m_deferredCallbacks);
+		for (auto& cb : deferred) {
+			cb();
 		}
-		while (!temp.empty()) {
-			auto cb = temp.front();
-			temp.pop_front();
+
+		// cheap enough to run all of them in order; ADD_AIRCRAFT only records the aircraft
+		std::function<void()> cb;
+		while (m_socketCallbacks.Pop(cb)) {
 			cb();
 		}
+
+		// the per aircraft work gets a slice of the frame per kind: position updates first, then
+		// config, then new aircraft nearest to the user first. Whatever doesn't fit waits for the next frame.
+		const auto positionDeadline = std::chrono::steady_clock::now() + POSITION_SLICE;
+		m_aircraftStates->Drain([this](uint32_t handle, const AircraftState& state, bool positionChanged, bool configChanged, bool heartbeatChanged) {
+			if (positionChanged) {
+				m_aircraftManager->HandleFastPositionUpdate(handle, {}, state.VisualState,
+					state.PositionalVelocities, state.RotationalVelocities, state.Speed);
+				m_ipcStats->RecordPositionApplied(state.PositionSentAt, getSteadyMicroseconds());
+			}
+			if (configChanged) {
+				m_aircraftManager->QueueAircraftConfig(handle, state.Config);
+			}
+			if (heartbeatChanged) {
+				m_aircraftManager->HandleHeartbeat(handle, {});
+			}
+		}, [&] { return std::chrono::steady_clock::now() >= positionDeadline; });
+
+		m_aircraftManager->ApplyQueuedConfigs(std::chrono::steady_clock::now() + CONFIG_SLICE);
+		m_aircraftManager->CreatePendingAircraft(std::chrono::steady_clock::now() + NEW_AIRCRAFT_SLICE);
 	}
 
 	void XPilot::ToggleSettingsWindow() {
@@ -631,43 +782,4 @@ namespace xpilot {
 			LOG_MSG(logDEBUG, "xPilot has released TCAS control");
 		}
 	}
-
-	int XPilot::GetBulkData(void* inRefcon, void* outData, int inStartPos, int inNumBytes) {
-		dataRefs dr = (dataRefs)reinterpret_cast<long long>(inRefcon);
-		assert(dr == xpilot::dataRefs::DR_BULK_QUICK || dr == xpilot::dataRefs::DR_BULK_EXPENSIVE);
-
-		static int size_quick = 0, size_expensive = 0;
-		if (!outData) {
-			if (dr == xpilot::dataRefs::DR_BULK_QUICK) {
-				size_quick = inNumBytes;
-				return (int)sizeof(XPilotAPIAircraft::XPilotAPIBulkData);
-			} else {
-				size_expensive = inNumBytes;
-				return (int)sizeof(XPilotAPIAircraft::XPilotAPIBulkInfoTexts);
-			}
-		}
-
-		int size = dr == xpilot::dataRefs::DR_BULK_QUICK ? size_quick : size_expensive;
-		if (!size) return 0;
-
-		if ((inStartPos % size != 0) ||
-			(inNumBytes % size != 0))
-			return 0;
-
-		const int startAc = 1 + inStartPos / size;
-		const int endAc = startAc + (inNumBytes / size);
-		char* pOut = (char*)outData;
-		int iAc = startAc;
-		for (mapPlanesTy::iterator pIter = mapGetAircraftByIndex(iAc);
-			pIter != mapPlanes.end() && iAc < endAc;
-			pIter = mapGetNextAircraft(pIter), iAc++, pOut += size) {
-			const NetworkAircraft& ac = *pIter->second;
-			if (dr == xpilot::dataRefs::DR_BULK_QUICK)
-				ac.copyBulkData((XPilotAPIAircraft::XPilotAPIBulkData*)pOut, size);
-			else
-				ac.copyBulkData((XPilotAPIAircraft::XPilotAPIBulkInfoTexts*)pOut, size);
-		}
-
-		return (iAc - startAc) * size;
-	}
 }
@@ -0,0 +1,221 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Benchmarks the per-frame work of XPMP2's AI/TCAS slot handling with 1,000 aircraft: picking
+// the closest aircraft for the 63 slots (a std::map rebuild before, nth_element on a reused
+// vector now) and writing the 27 sim/cockpit2/tcas/targets arrays (every value every frame
+// before, only the changed range now). XPLMSetDatavf/XPLMSetDatavi are stubbed with plain
+// buffers, so the write figures count values handed to X-Plane rather than X-Plane's own cost.
+// Fails if a new path ends up with a different result from the old one.
+
+#include "TcasTargets.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace XPMP2;
+
+namespace {
+	constexpr size_t AIRCRAFT = 1000;
+	constexpr size_t SLOTS = 63;
+	constexpr size_t FLOAT_ARRAYS = 25;
+	constexpr size_t INT_ARRAYS = 2;
+	constexpr size_t ARRAYS = FLOAT_ARRAYS + INT_ARRAYS;
+	constexpr int FRAMES = 2000;
+
+	// what X-Plane would hold for each stubbed dataRef, index 0 being the user's aircraft
+	std::unordered_map<XPLMDataRef, std::vector<float>> floatDataRefs;
+	std::unordered_map<XPLMDataRef, std::vector<int>> intDataRefs;
+	size_t valuesWritten = 0;
+	size_t calls = 0;
+
+	template <class T>
+	void Store(std::vector<T>& target, const T* values, int offset, int count) {
+		if (target.size() < size_t(offset + count)) target.resize(size_t(offset + count));
+		std::copy(values, values + count, target.begin() + offset);
+		valuesWritten += size_t(count);
+		calls++;
+	}
+
+	// the old pass writes to dataRefs [0, ARRAYS), the new one to [ARRAYS, 2 * ARRAYS)
+	XPLMDataRef DataRef(size_t i) {
+		return reinterpret_cast<XPLMDataRef>(i + 1);
+	}
+
+	template <class T>
+	bool Holds(const std::unordered_map<XPLMDataRef, std::vector<T>>& dataRefs, size_t i, const std::vector<T>& values) {
+		auto it = dataRefs.find(DataRef(i));
+		return it != dataRefs.end() && it->second.size() == values.size() + 1 &&
+			std::equal(values.begin(), values.end(), it->second.begin() + 1);
+	}
+
+	double Microseconds(std::chrono::steady_clock::duration d) {
+		return std::chrono::duration<double, std::micro>(d).count();
+	}
+}
+
+extern "C" {
+	void XPLMSetDatavf(XPLMDataRef inDataRef, float* inValues, int inoffset, int inCount) {
+		Store(floatDataRefs[inDataRef], inValues, inoffset, inCount);
+	}
+
+	void XPLMSetDatavi(XPLMDataRef inDataRef, int* inValues, int inoffset, int inCount) {
+		Store(intDataRefs[inDataRef], inValues, inoffset, inCount);
+	}
+}
+
+namespace {
+	// Picks the aircraft for the slots every frame the old way and the new one, with a third of
+	// the traffic moving. Returns the number of slots the two disagree on.
+	size_t SlotSelection(std::mt19937& rng) {
+		std::uniform_real_distribution<float> range(500.0f, 200000.0f);
+		std::uniform_real_distribution<float> jitter(-50.0f, 50.0f);
+
+		std::vector<float> distance(AIRCRAFT);
+		for (auto& d : distance) d = range(rng);
+
+		std::map<float, XPMPPlaneID> mapAcByDist;
+		std::vector<acByDistTy> acByDist;
+		acByDist.reserve(AIRCRAFT);
+		std::chrono::steady_clock::duration mapTime{}, vectorTime{};
+		size_t mismatches = 0;
+
+		for (int frame = 0; frame < FRAMES; frame++) {
+			for (size_t i = 0; i < AIRCRAFT; i += 3) distance[i] += jitter(rng);
+
+			auto start = std::chrono::steady_clock::now();
+			mapAcByDist.clear();
+			for (size_t i = 0; i < AIRCRAFT; i++) mapAcByDist.emplace(distance[i], XPMPPlaneID(i + 1));
+			mapTime += std::chrono::steady_clock::now() - start;
+
+			start = std::chrono::steady_clock::now();
+			acByDist.clear();
+			for (size_t i = 0; i < AIRCRAFT; i++) acByDist.emplace_back(distance[i], XPMPPlaneID(i + 1));
+			AISortClosest(acByDist, SLOTS);
+			vectorTime += std::chrono::steady_clock::now() - start;
+
+			auto it = mapAcByDist.begin();
+			for (size_t slot = 0; slot < SLOTS && it != mapAcByDist.end(); slot++, ++it) {
+				if (it->second != acByDist[slot].second) mismatches++;
+			}
+		}
+
+		std::printf("slot selection, %zu aircraft into %zu slots: std::map %.2f us/frame, nth_element %.2f us/frame\n",
+			AIRCRAFT, SLOTS, Microseconds(mapTime) / FRAMES, Microseconds(vectorTime) / FRAMES);
+		if (mismatches > 0) {
+			std::printf("the two selections differ in %zu slots\n", mismatches);
+		}
+		return mismatches;
+	}
+
+	// Writes the TCAS target arrays every frame the old way and the new one, with `movedPerFrame`
+	// random slots changing in each. Returns the number of times a dataRef ended up wrong.
+	size_t TcasTargets(std::mt19937& rng, size_t movedPerFrame) {
+		std::uniform_int_distribution<size_t> anySlot(0, SLOTS - 1);
+
+		std::vector<std::vector<float>> floatValues(FLOAT_ARRAYS, std::vector<float>(SLOTS));
+		std::vector<std::vector<int>> intValues(INT_ARRAYS, std::vector<int>(SLOTS));
+		for (size_t a = 0; a < FLOAT_ARRAYS; a++)
+			for (size_t s = 0; s < SLOTS; s++) floatValues[a][s] = float(a * 1000 + s);
+		for (size_t a = 0; a < INT_ARRAYS; a++)
+			for (size_t s = 0; s < SLOTS; s++) intValues[a][s] = int(a * 1000 + s);
+
+		std::vector<TcasArrayTy<float>> floatArrays(FLOAT_ARRAYS);
+		std::vector<TcasArrayTy<int>> intArrays(INT_ARRAYS);
+		for (auto& arr : floatArrays) arr.reserve(SLOTS);
+		for (auto& arr : intArrays) arr.reserve(SLOTS);
+
+		floatDataRefs.clear();
+		intDataRefs.clear();
+		std::chrono::steady_clock::duration fullTime{}, changedTime{};
+		size_t fullValues = 0, fullCalls = 0, changedValues = 0, changedCalls = 0;
+		size_t mismatches = 0;
+
+		for (int frame = 0; frame < FRAMES; frame++) {
+			for (size_t moved = 0; moved < movedPerFrame; moved++) {
+				const size_t s = anySlot(rng);
+				for (auto& values : floatValues) values[s] += 0.5f;
+			}
+			// a squawk change now and then
+			if (movedPerFrame > 0 && frame % 100 == 0) intValues[1][anySlot(rng)]++;
+
+			// before: every array written in full
+			valuesWritten = calls = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (size_t a = 0; a < FLOAT_ARRAYS; a++)
+				XPLMSetDatavf(DataRef(a), floatValues[a].data(), 1, int(SLOTS));
+			for (size_t a = 0; a < INT_ARRAYS; a++)
+				XPLMSetDatavi(DataRef(FLOAT_ARRAYS + a), intValues[a].data(), 1, int(SLOTS));
+			fullTime += std::chrono::steady_clock::now() - start;
+			fullValues += valuesWritten;
+			fullCalls += calls;
+
+			// now: the arrays are refilled each frame, as AIMultiUpdate does, and only changes go out
+			valuesWritten = calls = 0;
+			start = std::chrono::steady_clock::now();
+			for (size_t a = 0; a < FLOAT_ARRAYS; a++) {
+				floatArrays[a].clear();
+				for (float val : floatValues[a]) floatArrays[a].push_back(val);
+				floatArrays[a].SetChanged(DataRef(ARRAYS + a));
+			}
+			for (size_t a = 0; a < INT_ARRAYS; a++) {
+				intArrays[a].clear();
+				for (int val : intValues[a]) intArrays[a].push_back(val);
+				intArrays[a].SetChanged(DataRef(ARRAYS + FLOAT_ARRAYS + a));
+			}
+			changedTime += std::chrono::steady_clock::now() - start;
+			changedValues += valuesWritten;
+			changedCalls += calls;
+
+			for (size_t a = 0; a < FLOAT_ARRAYS; a++) {
+				if (!Holds(floatDataRefs, a, floatValues[a])) mismatches++;
+				if (!Holds(floatDataRefs, ARRAYS + a, floatValues[a])) mismatches++;
+			}
+			for (size_t a = 0; a < INT_ARRAYS; a++) {
+				if (!Holds(intDataRefs, FLOAT_ARRAYS + a, intValues[a])) mismatches++;
+				if (!Holds(intDataRefs, ARRAYS + FLOAT_ARRAYS + a, intValues[a])) mismatches++;
+			}
+		}
+
+		std::printf("TCAS targets, %zu arrays of %zu slots, %zu changing per frame:\n"
+			"  full writes   %6.2f us/frame, %6.1f values in %4.1f calls\n"
+			"  changed range %6.2f us/frame, %6.1f values in %4.1f calls\n",
+			ARRAYS, SLOTS, movedPerFrame,
+			Microseconds(fullTime) / FRAMES, double(fullValues) / FRAMES, double(fullCalls) / FRAMES,
+			Microseconds(changedTime) / FRAMES, double(changedValues) / FRAMES, double(changedCalls) / FRAMES);
+		if (mismatches > 0) {
+			std::printf("a dataRef differed from its values %zu times\n", mismatches);
+		}
+		return mismatches;
+	}
+}
+
+int main() {
+	std::mt19937 rng(24);
+	size_t mismatches = SlotSelection(rng);
+	// all traffic parked, one moving aircraft, and a few spread over the whole array
+	mismatches += TcasTargets(rng, 0);
+	mismatches += TcasTargets(rng, 1);
+	mismatches += TcasTargets(rng, SLOTS / 10);
+	return mismatches == 0 ? 0 : 1;
+}
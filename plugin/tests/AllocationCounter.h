@@ -0,0 +1,168 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef AllocationCounter_h
+#define AllocationCounter_h
+
+// Replaces every global operator new and delete with versions that count calls while
+// AllocationCounter::Counting is set, from any thread. The replacements are ordinary
+// definitions, so include this in exactly one source file of a test executable.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace xpilot {
+	struct AllocationCounter
+	{
+		static inline std::atomic<bool> Counting{ false };
+		static inline std::atomic<size_t> Allocations{ 0 };
+		static inline std::atomic<size_t> Frees{ 0 };
+
+		// resets the counts and counts from here on
+		static void Start() {
+			Allocations = 0;
+			Frees = 0;
+			Counting = true;
+		}
+
+		static void Stop() {
+			Counting = false;
+		}
+
+		// every replacement goes through these two rather than calling another operator, so the
+		// compiler never sees a pointer from one overload handed to a different one
+		static void* Allocate(size_t size, size_t alignment) noexcept {
+			if (Counting.load(std::memory_order_relaxed)) {
+				Allocations.fetch_add(1, std::memory_order_relaxed);
+			}
+			size = size > 0 ? size : 1;
+			if (alignment <= alignof(std::max_align_t)) {
+				return std::malloc(size);
+			}
+#ifdef _WIN32
+			return _aligned_malloc(size, alignment);
+#else
+			return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+		}
+
+		static void Free(void* p, size_t alignment) noexcept {
+			if (!p) return;
+			if (Counting.load(std::memory_order_relaxed)) {
+				Frees.fetch_add(1, std::memory_order_relaxed);
+			}
+#ifdef _WIN32
+			if (alignment > alignof(std::max_align_t)) {
+				_aligned_free(p);
+				return;
+			}
+#endif
+			std::free(p);
+		}
+
+		static void* AllocateOrThrow(size_t size, size_t alignment) {
+			void* p = Allocate(size, alignment);
+			if (!p) throw std::bad_alloc();
+			return p;
+		}
+	};
+}
+
+void* operator new(size_t size) {
+	return xpilot::AllocationCounter::AllocateOrThrow(size, 0);
+}
+
+void* operator new[](size_t size) {
+	return xpilot::AllocationCounter::AllocateOrThrow(size, 0);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return xpilot::AllocationCounter::Allocate(size, 0);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return xpilot::AllocationCounter::Allocate(size, 0);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	return xpilot::AllocationCounter::AllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+	return xpilot::AllocationCounter::AllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return xpilot::AllocationCounter::Allocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return xpilot::AllocationCounter::Allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept {
+	xpilot::AllocationCounter::Free(p, 0);
+}
+
+void operator delete[](void* p) noexcept {
+	xpilot::AllocationCounter::Free(p, 0);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	xpilot::AllocationCounter::Free(p, 0);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+	xpilot::AllocationCounter::Free(p, 0);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+	xpilot::AllocationCounter::Free(p, 0);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+	xpilot::AllocationCounter::Free(p, 0);
+}
+
+void operator delete(void* p, std::align_val_t alignment) noexcept {
+	xpilot::AllocationCounter::Free(p, static_cast<size_t>(alignment));
+}
+
+void operator delete[](void* p, std::align_val_t alignment) noexcept {
+	xpilot::AllocationCounter::Free(p, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p, size_t, std::align_val_t alignment) noexcept {
+	xpilot::AllocationCounter::Free(p, static_cast<size_t>(alignment));
+}
+
+void operator delete[](void* p, size_t, std::align_val_t alignment) noexcept {
+	xpilot::AllocationCounter::Free(p, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	xpilot::AllocationCounter::Free(p, static_cast<size_t>(alignment));
+}
+
+void operator delete[](void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	xpilot::AllocationCounter::Free(p, static_cast<size_t>(alignment));
+}
+
+#endif // !AllocationCounter_h
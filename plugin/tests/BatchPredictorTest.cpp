@@ -0,0 +1,118 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Checks BatchPredictor::Extrapolate against ExtrapolatePose, the scalar maths behind
+// NetworkAircraft::ExtrapolatePosition. Built once with SIMD and once with XPILOT_NO_SIMD.
+
+#include "BatchPredictor.h"
+#include "PositionExtrapolation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace xpilot;
+
+namespace {
+	constexpr size_t AIRCRAFT = 200000;
+	constexpr double MAX_DEGREES_ERROR = 1e-9;
+	constexpr double MAX_FEET_ERROR = 1e-6;
+
+	// difference of two angles in degrees, so that -180 and 180 compare as equal
+	double AngleError(double a, double b) {
+		return std::fabs(std::remainder(a - b, 360.0));
+	}
+}
+
+int main() {
+	std::mt19937_64 random(20221017);
+	std::uniform_real_distribution<double> lat(-85.0, 85.0);
+	std::uniform_real_distribution<double> lon(-180.0, 180.0);
+	std::uniform_real_distribution<double> altitude(-1000.0, 45000.0);
+	std::uniform_real_distribution<double> pitch(-60.0, 60.0);
+	std::uniform_real_distribution<double> heading(-180.0, 180.0);
+	std::uniform_real_distribution<double> bank(-60.0, 60.0);
+	std::uniform_real_distribution<double> velocity(-300.0, 300.0);
+	std::uniform_real_distribution<double> rotation(-0.5, 0.5);
+	std::uniform_real_distribution<double> interval(0.0, 1.5);
+
+	PredictionLanes lanes;
+	lanes.Resize(AIRCRAFT);
+
+	std::vector<ExtrapolatedPose> expected(AIRCRAFT);
+	for (size_t i = 0; i < AIRCRAFT; i++) {
+		const ExtrapolatedPose pose{ lat(random), lon(random), altitude(random), pitch(random), heading(random), bank(random) };
+		const Vector3 velocityVector(velocity(random), velocity(random) * 0.1, velocity(random));
+
+		// most traffic isn't turning, which takes the kernel's no-rotation shortcut
+		Vector3 rotationVector = Vector3::Zero();
+		if (i % 4 != 0) {
+			rotationVector = Vector3(rotation(random), rotation(random), rotation(random));
+		}
+		const double dt = interval(random);
+
+		lanes.Lat[i] = pose.Lat;
+		lanes.Lon[i] = pose.Lon;
+		lanes.Altitude[i] = pose.AltitudeTrue;
+		lanes.Pitch[i] = pose.Pitch;
+		lanes.Heading[i] = pose.Heading;
+		lanes.Bank[i] = pose.Bank;
+		lanes.VelocityX[i] = velocityVector.X;
+		lanes.VelocityY[i] = velocityVector.Y;
+		lanes.VelocityZ[i] = velocityVector.Z;
+		lanes.RotationX[i] = rotationVector.X;
+		lanes.RotationY[i] = rotationVector.Y;
+		lanes.RotationZ[i] = rotationVector.Z;
+		lanes.Interval[i] = dt;
+
+		expected[i] = ExtrapolatePose(pose, velocityVector, rotationVector, dt);
+	}
+
+	BatchPredictor::Extrapolate(lanes, 0, AIRCRAFT);
+
+	double maxDegrees = 0.0;
+	double maxFeet = 0.0;
+	size_t failures = 0;
+	for (size_t i = 0; i < AIRCRAFT; i++) {
+		const ExtrapolatedPose& want = expected[i];
+		const double degrees = (std::max)({
+			std::fabs(lanes.Lat[i] - want.Lat),
+			AngleError(lanes.Lon[i], want.Lon),
+			AngleError(lanes.Pitch[i], want.Pitch),
+			AngleError(lanes.Heading[i], want.Heading),
+			AngleError(lanes.Bank[i], want.Bank)
+		});
+		const double feet = std::fabs(lanes.Altitude[i] - want.AltitudeTrue);
+		maxDegrees = (std::max)(maxDegrees, degrees);
+		maxFeet = (std::max)(maxFeet, feet);
+
+		if (!(degrees <= MAX_DEGREES_ERROR) || !(feet <= MAX_FEET_ERROR)) {
+			if (failures++ < 10) {
+				std::printf("aircraft %zu: lat %.12f/%.12f lon %.12f/%.12f alt %.9f/%.9f pitch %.12f/%.12f heading %.12f/%.12f bank %.12f/%.12f\n",
+					i, lanes.Lat[i], want.Lat, lanes.Lon[i], want.Lon, lanes.Altitude[i], want.AltitudeTrue,
+					lanes.Pitch[i], want.Pitch, lanes.Heading[i], want.Heading, lanes.Bank[i], want.Bank);
+			}
+		}
+	}
+
+	std::printf("%s: %zu aircraft, max error %.3g deg, %.3g ft, %zu outside tolerance\n",
+		BatchPredictor::GetInstructionSet(), AIRCRAFT, maxDegrees, maxFeet, failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Runs BatchPredictor::Extrapolate split across a WorkerPool the way BatchPredictor::Advance does,
+// and checks that every thread count gives bit for bit the results of the single-thread pass.
+
+#include "BatchPredictor.h"
+#include "WorkerPool.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace xpilot;
+
+namespace {
+	constexpr size_t AIRCRAFT = 10007; // not a whole number of SIMD vectors
+	constexpr size_t RUNS = 20;
+	const size_t THREAD_COUNTS[] = { 2, 3, 4, 8 };
+
+	PredictionLanes RandomLanes(size_t count) {
+		std::mt19937_64 random(20221017);
+		std::uniform_real_distribution<double> lat(-85.0, 85.0);
+		std::uniform_real_distribution<double> lon(-180.0, 180.0);
+		std::uniform_real_distribution<double> altitude(-1000.0, 45000.0);
+		std::uniform_real_distribution<double> attitude(-60.0, 60.0);
+		std::uniform_real_distribution<double> heading(-180.0, 180.0);
+		std::uniform_real_distribution<double> velocity(-300.0, 300.0);
+		std::uniform_real_distribution<double> rotation(-0.5, 0.5);
+		std::uniform_real_distribution<double> interval(0.0, 1.5);
+
+		PredictionLanes lanes;
+		lanes.Resize(count);
+		for (size_t i = 0; i < count; i++) {
+			lanes.Lat[i] = lat(random);
+			lanes.Lon[i] = lon(random);
+			lanes.Altitude[i] = altitude(random);
+			lanes.Pitch[i] = attitude(random);
+			lanes.Heading[i] = heading(random);
+			lanes.Bank[i] = attitude(random);
+			lanes.VelocityX[i] = velocity(random);
+			lanes.VelocityY[i] = velocity(random) * 0.1;
+			lanes.VelocityZ[i] = velocity(random);
+			const bool turning = i % 4 != 0;
+			lanes.RotationX[i] = turning ? rotation(random) : 0.0;
+			lanes.RotationY[i] = turning ? rotation(random) : 0.0;
+			lanes.RotationZ[i] = turning ? rotation(random) : 0.0;
+			lanes.Interval[i] = interval(random);
+		}
+		return lanes;
+	}
+
+	bool SameResults(const PredictionLanes& a, const PredictionLanes& b, size_t count) {
+		const std::vector<double> PredictionLanes::* outputs[] = {
+			&PredictionLanes::Lat, &PredictionLanes::Lon, &PredictionLanes::Altitude,
+			&PredictionLanes::Pitch, &PredictionLanes::Heading, &PredictionLanes::Bank
+		};
+		for (auto output : outputs) {
+			if (std::memcmp((a.*output).data(), (b.*output).data(), count * sizeof(double)) != 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// the pass as BatchPredictor::Advance runs it, except that every range is worth a thread
+	struct ChunkedPass
+	{
+		std::vector<unsigned char> Covered;
+		size_t Ranges = 0;
+		bool Misaligned = false;
+		bool OffCallingThread = false;
+
+		void Run(WorkerPool& workers, PredictionLanes& lanes, size_t count) {
+			const size_t width = PredictionLanes::PaddedCount(1);
+			const std::thread::id caller = std::this_thread::get_id();
+			std::mutex mutex;
+			Covered.assign(count, 0);
+
+			workers.RunRanges(count, width, 1, [&](size_t begin, size_t end) {
+				BatchPredictor::Extrapolate(lanes, begin, end);
+
+				std::lock_guard<std::mutex> lock(mutex);
+				Ranges++;
+				Misaligned |= begin % width != 0;
+				OffCallingThread |= std::this_thread::get_id() != caller;
+				for (size_t i = begin; i < end; i++) {
+					Covered[i]++;
+				}
+			});
+		}
+
+		bool CoveredOnce() const {
+			for (unsigned char times : Covered) {
+				if (times != 1) return false;
+			}
+			return true;
+		}
+	};
+}
+
+int main() {
+	const PredictionLanes input = RandomLanes(AIRCRAFT);
+	int failures = 0;
+
+	// single-thread mode: one range, run inline on the calling thread
+	WorkerPool single;
+	single.SetThreadCount(1);
+	PredictionLanes expected = input;
+	ChunkedPass reference;
+	reference.Run(single, expected, AIRCRAFT);
+	if (reference.Ranges != 1 || reference.OffCallingThread || !reference.CoveredOnce()) {
+		std::printf("1 thread: %zu ranges, %s the calling thread\n", reference.Ranges,
+			reference.OffCallingThread ? "not only on" : "on");
+		failures++;
+	}
+
+	for (size_t threads : THREAD_COUNTS) {
+		WorkerPool workers;
+		workers.SetThreadCount(threads);
+
+		size_t mismatches = 0;
+		size_t badRanges = 0;
+		for (size_t run = 0; run < RUNS; run++) {
+			PredictionLanes lanes = input;
+			ChunkedPass pass;
+			pass.Run(workers, lanes, AIRCRAFT);
+
+			if (pass.Ranges != threads || pass.Misaligned || !pass.CoveredOnce()) {
+				badRanges++;
+			}
+			if (!SameResults(lanes, expected, AIRCRAFT)) {
+				mismatches++;
+			}
+		}
+
+		std::printf("%zu threads: %zu runs, %zu with results differing from 1 thread, %zu with bad ranges\n",
+			threads, RUNS, mismatches, badRanges);
+		if (mismatches > 0 || badRanges > 0) {
+			failures++;
+		}
+	}
+
+	return failures == 0 ? 0 : 1;
+}
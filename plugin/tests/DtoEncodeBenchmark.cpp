@@ -0,0 +1,168 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Benchmarks encodeDto as SendDto uses it against the encoding it replaced: the old path
+// converted the dto into a zone-backed msgpack::object, packed the envelope into a temp
+// sbuffer, copied that into a fresh buffer per send and then into a std::vector for nng. The
+// new one packs straight into a reused buffer. Counts heap allocations per message too, and
+// fails if the two paths produce different bytes or the new one allocates once warmed up.
+
+#include "AllocationCounter.h"
+#include "Dto.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using xpilot::AllocationCounter;
+
+namespace {
+	constexpr int ITERATIONS = 100000;
+
+	// stands in for nng_send, which only reads the bytes
+	size_t sentBytes = 0;
+	void Send(const char* data, size_t size) {
+		sentBytes += size + static_cast<unsigned char>(data[size - 1]);
+	}
+
+	// encodeDto before it packed straight into the caller's buffer
+	template<class T>
+	bool EncodeDtoViaObject(msgpack::sbuffer& dtoBuf, const T& dto, bool compact) {
+		msgpack::zone z;
+		msgpack::sbuffer dtoTempBuf;
+		if (compact && dto.getId() != MessageId::PluginVersion) {
+			CompactDto base{ static_cast<uint8_t>(dto.getId()), msgpack::object(dto, z) };
+			msgpack::pack(dtoTempBuf, base);
+		}
+		else {
+			BaseDto base{ dto.getName(), msgpack::object(dto, z) };
+			msgpack::pack(dtoTempBuf, base);
+		}
+		if (dtoTempBuf.size() > UINT16_MAX) {
+			return false;
+		}
+		dtoBuf.write(dtoTempBuf.data(), dtoTempBuf.size());
+		return true;
+	}
+
+	// SendDto before: a new buffer per message and a std::vector copy for nng
+	template<class T>
+	void SendViaObject(const T& dto, bool compact) {
+		msgpack::sbuffer dtoBuf;
+		if (EncodeDtoViaObject(dtoBuf, dto, compact)) {
+			std::vector<unsigned char> dgBuffer(dtoBuf.data(), dtoBuf.data() + dtoBuf.size());
+			Send(reinterpret_cast<char*>(dgBuffer.data()), dgBuffer.size());
+		}
+	}
+
+	// SendDto now
+	template<class T>
+	void SendDirect(const T& dto, bool compact) {
+		thread_local msgpack::sbuffer dtoBuf;
+		dtoBuf.clear();
+		if (encodeDto(dtoBuf, dto, compact)) {
+			Send(dtoBuf.data(), dtoBuf.size());
+		}
+	}
+
+	template<class F>
+	double Measure(F send, size_t& allocationsPerMessage) {
+		send(); // warms up the reused buffer
+		AllocationCounter::Start();
+		const auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < ITERATIONS; i++) {
+			send();
+		}
+		const auto elapsed = std::chrono::steady_clock::now() - start;
+		AllocationCounter::Stop();
+		allocationsPerMessage = AllocationCounter::Allocations / ITERATIONS;
+		return std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+	}
+
+	template<class T>
+	int Compare(const char* name, const T& dto, bool compact) {
+		msgpack::sbuffer before, after;
+		EncodeDtoViaObject(before, dto, compact);
+		encodeDto(after, dto, compact);
+		if (before.size() != after.size() || std::memcmp(before.data(), after.data(), before.size()) != 0) {
+			std::printf("%-28s the encodings differ\n", name);
+			return 1;
+		}
+
+		size_t allocsBefore = 0, allocsAfter = 0;
+		const double nsBefore = Measure([&] { SendViaObject(dto, compact); }, allocsBefore);
+		const double nsAfter = Measure([&] { SendDirect(dto, compact); }, allocsAfter);
+		std::printf("%-28s %5zu bytes: via object %7.1f ns, %zu allocs; direct %7.1f ns, %zu allocs\n",
+			name, after.size(), nsBefore, allocsBefore, nsAfter, allocsAfter);
+		return allocsAfter == 0 ? 0 : 1;
+	}
+
+	FastPositionUpdateDto MakePosition(uint32_t i) {
+		FastPositionUpdateDto dto{};
+		dto.callsign = "DLH" + std::to_string(100 + i);
+		dto.latitude = 47.4 + i * 0.01;
+		dto.longitude = 8.5 + i * 0.01;
+		dto.altitudeTrue = 12000.0 + i;
+		dto.altitudeAgl = 10000.0;
+		dto.heading = 270.5;
+		dto.bank = -2.5;
+		dto.pitch = 3.1;
+		dto.vx = 120.0;
+		dto.vy = 5.0;
+		dto.vz = -30.0;
+		dto.vh = 0.01;
+		dto.speed = 250.0;
+		dto.handle = i + 1;
+		return dto;
+	}
+}
+
+int main() {
+	const FastPositionUpdateDto position = MakePosition(0);
+
+	AircraftConfigDto config{};
+	config.callsign = "DLH100";
+	config.fullConfig = true;
+	config.enginesOn = true;
+	config.onGround = false;
+	config.flaps = 0.25f;
+	config.gearDown = false;
+	config.landingLightsOn = true;
+	config.handle = 1;
+
+	PositionFrameDto frame;
+	for (uint32_t i = 0; i < 50; i++) {
+		frame.updates.push_back(MakePosition(i));
+	}
+
+	RadioMessageReceivedDto radio{ "EDDF_TWR", "DLH100, wind 250 at 8, runway 25C cleared to land", false };
+
+	int failures = 0;
+	failures += Compare("FastPositionUpdate", position, false);
+	failures += Compare("FastPositionUpdate compact", position, true);
+	failures += Compare("AircraftConfig compact", config, true);
+	failures += Compare("PositionFrame (50) compact", frame, true);
+	failures += Compare("RadioMessageReceived", radio, false);
+
+	if (sentBytes == 0) {
+		std::printf("nothing was sent\n");
+		return 1;
+	}
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Benchmarks picking the flight model when an aircraft is created, for 1,000 aircraft of
+// common types: the old way, which built a std::regex for every pattern in
+// FlightModel::modelMatches per aircraft, against FlightModel::ForClassification with its
+// patterns compiled once by InitializeModels and its results cached per type. Fails if the two
+// ever pick a different category.
+
+#include "FlightModel.h"
+
+#include <chrono>
+#include <cstdio>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace xpilot;
+
+namespace {
+	constexpr size_t AIRCRAFT = 1000;
+
+	struct AircraftType
+	{
+		const char* wtc;
+		const char* classification;
+		const char* icaoType;
+	};
+
+	// Doc8643 data for a mix of airliners, business jets, GA, gliders and helicopters
+	const AircraftType TYPES[] = {
+		{ "M", "L2J", "A320" }, { "M", "L2J", "B738" }, { "M", "L2J", "A21N" }, { "M", "L2J", "E190" },
+		{ "M", "L2J", "CRJ9" }, { "H", "L2J", "B77W" }, { "H", "L2J", "A359" }, { "H", "L4J", "B744" },
+		{ "J", "L4J", "A388" }, { "H", "L2J", "B789" }, { "M", "L2T", "AT76" }, { "M", "L2T", "DH8D" },
+		{ "M", "L2J", "GLF6" }, { "M", "L2J", "LJ45" }, { "L", "L2J", "C525" }, { "L", "L2J", "E55P" },
+		{ "L", "L1P", "C172" }, { "L", "L1P", "PA28" }, { "L", "L1P", "SR22" }, { "L", "L2P", "BE58" },
+		{ "L", "L1T", "PC12" }, { "L", "L2T", "BE20" }, { "L", "H1T", "EC35" }, { "L", "H2T", "EC45" },
+		{ "L", "H1P", "R22" }, { "L", "G1P", "GLID" }, { "L", "L1P", "DG80" }, { "-", "-", "ZZZZ" },
+	};
+	constexpr size_t TYPE_COUNT = sizeof(TYPES) / sizeof(TYPES[0]);
+
+	// GetFlightModel's matching before the patterns were compiled once
+	std::string CategoryViaRegexPerAircraft(const AircraftType& type) {
+		std::string classification = std::string(type.wtc) + ";" + type.classification + ";" + type.icaoType + ";";
+		std::string category = "MediumJets";
+		for (const auto& mapIt : FlightModel::modelMatches) {
+			std::smatch m;
+			std::regex re(mapIt.regex.c_str());
+			std::regex_search(classification, m, re);
+			if (m.size() > 0) {
+				category = mapIt.category;
+				break;
+			}
+		}
+		return category;
+	}
+
+	double Microseconds(std::chrono::steady_clock::duration d) {
+		return std::chrono::duration<double, std::micro>(d).count();
+	}
+}
+
+int main() {
+	auto start = std::chrono::steady_clock::now();
+	FlightModel::InitializeModels();
+	const double initializeUs = Microseconds(std::chrono::steady_clock::now() - start);
+
+	// the aircraft arrive in no particular order, with the popular types more often
+	std::vector<const AircraftType*> aircraft;
+	for (size_t i = 0; i < AIRCRAFT; i++) {
+		aircraft.push_back(&TYPES[(i * 7 + i / 3) % TYPE_COUNT]);
+	}
+
+	std::vector<std::string> before;
+	start = std::chrono::steady_clock::now();
+	for (const auto* type : aircraft) {
+		before.push_back(CategoryViaRegexPerAircraft(*type));
+	}
+	const double beforeUs = Microseconds(std::chrono::steady_clock::now() - start);
+
+	// the first aircraft of each type runs the compiled patterns, the rest hit the cache
+	std::vector<std::string> after;
+	std::chrono::steady_clock::duration uncached{}, cached{};
+	std::vector<bool> seen(TYPE_COUNT);
+	for (const auto* type : aircraft) {
+		start = std::chrono::steady_clock::now();
+		FlightModel model = FlightModel::ForClassification(type->wtc, type->classification, type->icaoType);
+		const auto elapsed = std::chrono::steady_clock::now() - start;
+		const size_t index = size_t(type - TYPES);
+		(seen[index] ? cached : uncached) += elapsed;
+		seen[index] = true;
+		after.push_back(model.modelCategory);
+	}
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < AIRCRAFT; i++) {
+		if (before[i] != after[i]) {
+			if (mismatches++ < 10) {
+				std::printf("%s;%s;%s: %s before, %s now\n", aircraft[i]->wtc, aircraft[i]->classification,
+					aircraft[i]->icaoType, before[i].c_str(), after[i].c_str());
+			}
+		}
+	}
+
+	std::printf("%zu aircraft of %zu types, %zu patterns (compiled once in %.0f us)\n",
+		AIRCRAFT, TYPE_COUNT, FlightModel::modelMatches.size(), initializeUs);
+	std::printf("  regex per aircraft  %8.2f us/aircraft\n", beforeUs / AIRCRAFT);
+	std::printf("  compiled, new type  %8.2f us/aircraft\n", Microseconds(uncached) / TYPE_COUNT);
+	std::printf("  compiled, cached    %8.2f us/aircraft\n", Microseconds(cached) / (AIRCRAFT - TYPE_COUNT));
+	return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Ping-pong latency between two threads, over SharedMemoryTransport and over the nng pair1 ipc
+// socket it stands in for. One thread plays the plugin and sends a message the size of a
+// position update, the other plays the client and sends it straight back; the round trip is
+// timed for each message. Both ends live in one process, which the transport allows since it
+// only checks the peer pid is alive. Linux only, like the transport. Fails if a message comes
+// back altered or not at all.
+
+#include "SharedMemoryTransport.h"
+
+#include <nng/nng.h>
+#include <nng/protocol/pair1/pair.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace xpilot;
+
+namespace {
+	constexpr int WARM_UP = 1000;
+	constexpr int ROUND_TRIPS = 20000;
+	constexpr size_t MESSAGE_SIZE = 96; // a compact FastPositionUpdateDto
+	constexpr int TIMEOUT_MS = 1000;
+
+	int64_t Nanoseconds() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Prints the distribution and returns 0, or 1 if the echo went wrong
+	int Report(const char* name, std::vector<int64_t>& samples, int failures) {
+		if (failures > 0 || samples.empty()) {
+			std::printf("%-16s %d of %d round trips failed\n", name, failures, ROUND_TRIPS);
+			return 1;
+		}
+		std::sort(samples.begin(), samples.end());
+		auto percentile = [&](double p) {
+			return samples[std::min(samples.size() - 1, size_t(p * samples.size()))] / 1000.0;
+		};
+		std::printf("%-16s round trip: median %6.1f us, p90 %6.1f us, p99 %6.1f us, max %7.1f us\n",
+			name, percentile(0.5), percentile(0.9), percentile(0.99), samples.back() / 1000.0);
+		return 0;
+	}
+
+	std::vector<char> MakeMessage(int i) {
+		std::vector<char> message(MESSAGE_SIZE);
+		for (size_t b = 0; b < MESSAGE_SIZE; b++) {
+			message[b] = char((i + int(b)) & 0x7f);
+		}
+		return message;
+	}
+
+	int SharedMemory() {
+		const std::string segmentName = "/xpilot-latency-benchmark-" + std::to_string(getpid());
+		SharedMemoryTransport host(SharedMemoryTransport::Role::Host, segmentName);
+		SharedMemoryTransport guest(SharedMemoryTransport::Role::Guest, segmentName);
+		if (!host.Open() || !guest.Open()) {
+			std::printf("shared memory: could not open the segment\n");
+			return 1;
+		}
+
+		std::thread echo([&] {
+			std::vector<char> message;
+			for (int i = 0; i < WARM_UP + ROUND_TRIPS; i++) {
+				if (!guest.Receive(message, TIMEOUT_MS) || !guest.Send(message.data(), message.size())) {
+					break;
+				}
+			}
+		});
+
+		std::vector<int64_t> samples;
+		samples.reserve(ROUND_TRIPS);
+		std::vector<char> reply;
+		int failures = 0;
+		for (int i = 0; i < WARM_UP + ROUND_TRIPS; i++) {
+			const std::vector<char> message = MakeMessage(i);
+			const int64_t start = Nanoseconds();
+			if (!host.Send(message.data(), message.size()) || !host.Receive(reply, TIMEOUT_MS)) {
+				failures = WARM_UP + ROUND_TRIPS - i;
+				break;
+			}
+			const int64_t elapsed = Nanoseconds() - start;
+			if (reply != message) {
+				failures++;
+			}
+			if (i >= WARM_UP) {
+				samples.push_back(elapsed);
+			}
+		}
+
+		guest.Interrupt();
+		echo.join();
+		guest.Close();
+		host.Close();
+		return Report("shared memory", samples, failures);
+	}
+
+	int Nng() {
+		const std::string url = "ipc:///tmp/xpilot-latency-benchmark-" + std::to_string(getpid()) + ".ipc";
+		nng_socket plugin, client;
+		if (nng_pair1_open(&plugin) != 0 || nng_pair1_open(&client) != 0) {
+			std::printf("nng: could not open the sockets\n");
+			return 1;
+		}
+		nng_setopt_ms(plugin, NNG_OPT_RECVTIMEO, TIMEOUT_MS);
+		nng_setopt_ms(client, NNG_OPT_RECVTIMEO, TIMEOUT_MS);
+		if (nng_listen(plugin, url.c_str(), NULL, 0) != 0 || nng_dial(client, url.c_str(), NULL, 0) != 0) {
+			std::printf("nng: could not connect %s\n", url.c_str());
+			return 1;
+		}
+
+		// receives like the plugin and the client do, into a buffer nng allocates
+		std::thread echo([&] {
+			for (int i = 0; i < WARM_UP + ROUND_TRIPS; i++) {
+				char* buffer = nullptr;
+				size_t bufferLen = 0;
+				if (nng_recv(client, &buffer, &bufferLen, NNG_FLAG_ALLOC) != 0) {
+					break;
+				}
+				const int rv = nng_send(client, buffer, bufferLen, 0);
+				nng_free(buffer, bufferLen);
+				if (rv != 0) {
+					break;
+				}
+			}
+		});
+
+		std::vector<int64_t> samples;
+		samples.reserve(ROUND_TRIPS);
+		int failures = 0;
+		for (int i = 0; i < WARM_UP + ROUND_TRIPS; i++) {
+			std::vector<char> message = MakeMessage(i);
+			char* buffer = nullptr;
+			size_t bufferLen = 0;
+			const int64_t start = Nanoseconds();
+			if (nng_send(plugin, message.data(), message.size(), 0) != 0
+				|| nng_recv(plugin, &buffer, &bufferLen, NNG_FLAG_ALLOC) != 0) {
+				failures = WARM_UP + ROUND_TRIPS - i;
+				break;
+			}
+			const int64_t elapsed = Nanoseconds() - start;
+			if (bufferLen != message.size() || std::memcmp(buffer, message.data(), bufferLen) != 0) {
+				failures++;
+			}
+			nng_free(buffer, bufferLen);
+			if (i >= WARM_UP) {
+				samples.push_back(elapsed);
+			}
+		}
+
+		echo.join();
+		nng_close(client);
+		nng_close(plugin);
+		return Report("nng pair1 ipc", samples, failures);
+	}
+}
+
+int main() {
+	std::printf("%d round trips of %zu bytes between two threads\n", ROUND_TRIPS, MESSAGE_SIZE);
+	int failures = SharedMemory();
+	failures += Nng();
+	nng_fini();
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+/*
+ * xPilot: X-Plane pilot client for VATSIM
+ * Copyright (C) 2019-2022 Justin Shannon
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Counts heap allocations on the per-update paths that are meant to be allocation free once
+// warmed up: the terrain elevation history of every network aircraft (RingBuffer) and the
+// queue of aircraft configs waiting for the prioritised drain (DrainQueue).
+
+#include "AllocationCounter.h"
+#include "DrainQueue.h"
+#include "RingBuffer.h"
+#include "TerrainHistory.h"
+
+#include <cmath>
+#include <cstdio>
+#include <optional>
+#include <utility>
+#include <vector>
+
+using namespace xpilot;
+
+namespace {
+	constexpr size_t AIRCRAFT = 1000;
+	constexpr int64_t FRAME_MS = 20;
+	constexpr int64_t WARM_UP_MS = 10000;
+	constexpr int64_t RUN_MS = 60000;
+	constexpr size_t CONFIGS_PER_FRAME = 40; // drained per frame, the rest wait for the next one
+	constexpr int64_t CONFIG_BURST_MS = 5000; // every aircraft sends a config at once, e.g. after a reconnect
+
+	// the same shape as AircraftConfig, which can't be included without the SDK
+	struct Config
+	{
+		std::optional<bool> GearDown;
+		std::optional<float> Flaps;
+		std::optional<bool> OnGround;
+		std::optional<bool> LandingLightsOn;
+	};
+}
+
+int main() {
+	std::vector<TerrainHistory> histories(AIRCRAFT);
+	DrainQueue<std::pair<uint32_t, Config>> queuedConfigs;
+
+	size_t fullHistories = 0;
+	size_t applied = 0;
+	size_t steadyStateAllocations = 0;
+
+	for (int64_t now = 0; now < WARM_UP_MS + RUN_MS; now += FRAME_MS) {
+		if (now == WARM_UP_MS) {
+			AllocationCounter::Start();
+		}
+		AllocationCounter::Allocations = 0;
+
+		for (size_t i = 0; i < AIRCRAFT; i++) {
+			// half the traffic sends fast position updates (every frame), which keeps the ring
+			// buffer full, the rest the usual five per second
+			const int64_t interval = i % 2 == 0 ? FRAME_MS : 200;
+			if ((now + int64_t(i) * FRAME_MS) % interval != 0) continue;
+
+			const double lat = 47.0 + i * 0.001 + now * 1e-8;
+			const double lon = 8.0 + i * 0.001;
+			// a few aircraft are airborne, which skips the sample
+			const std::optional<double> agl = i % 10 == 0 ? std::optional<double>(2500.0) : std::optional<double>(0.0);
+			const double localElevation = 1300.0 + std::sin(now * 1e-4 + i);
+			histories[i].Record(double(now), lat, lon, agl, localElevation);
+			if (histories[i].Size() > TERRAIN_ELEVATION_HISTORY_CAPACITY) {
+				std::printf("aircraft %zu: history grew past its capacity\n", i);
+				return 1;
+			}
+			if (AllocationCounter::Counting && histories[i].Size() == TERRAIN_ELEVATION_HISTORY_CAPACITY) {
+				fullHistories++;
+			}
+		}
+
+		// one config per aircraft and second, and a burst of all of them now and then
+		for (size_t i = 0; i < AIRCRAFT; i++) {
+			if (now % CONFIG_BURST_MS == 0 || (now / FRAME_MS + int64_t(i)) % 50 == 0) {
+				Config config{};
+				config.GearDown = (now / 1000) % 2 == 0;
+				config.Flaps = 0.5f;
+				queuedConfigs.Push({ uint32_t(i + 1), config });
+			}
+		}
+
+		size_t drained = 0;
+		queuedConfigs.Drain([&](const std::pair<uint32_t, Config>& queued) {
+			applied += queued.second.GearDown.has_value() ? 1 : 0;
+			return ++drained < CONFIGS_PER_FRAME;
+		});
+		if (now % 1000 == 0) {
+			// an aircraft removed every second takes its queued configs with it
+			queuedConfigs.RemoveIf([now](const std::pair<uint32_t, Config>& queued) {
+				return queued.first == uint32_t(now / 1000 % AIRCRAFT + 1);
+			});
+		}
+
+		steadyStateAllocations += AllocationCounter::Allocations;
+	}
+	AllocationCounter::Stop();
+
+	std::printf("%zu aircraft, %lld s: %zu full terrain histories, %zu configs applied, %zu queued, %zu allocations after warm-up\n",
+		AIRCRAFT, (long long)(RUN_MS / 1000), fullHistories, applied, queuedConfigs.Size(), steadyStateAllocations);
+
+	// the fast aircraft wrap their ring buffer, and the configs keep flowing
+	if (fullHistories == 0 || applied == 0) {
+		std::printf("the scenario never reached steady state\n");
+		return 1;
+	}
+	return steadyStateAllocations == 0 ? 0 : 1;
+}